@@ -1079,7 +1079,7 @@ signame(int sig)
  *
  *   1. close all temporarily opened pipes and output files.
  *   2. set the terminal back to normal cooked mode.
- *   3. free all temporary buffers.
+ *   3. free all temporary buffers and the command's arena.
  *   4. restore the last known output radix.
  */
 static void
@@ -1201,6 +1201,7 @@ restore_sanity(void)
 	restore_gdb_sanity();
 
 	free_all_bufs();
+	arena_reset();
 
 	/*
 	 *  Clear the structure cache references -- no-ops if DUMPFILE().
@@ -1212,6 +1213,7 @@ restore_sanity(void)
 	clear_dentry_cache();
 	clear_inode_cache();
 	clear_vma_cache();
+	clear_live_cache();
 	clear_active_set();
 
 	if (kt->ikconfig_flags & IKCONFIG_LOADED)
@@ -54,6 +54,9 @@
 #ifdef SNAPPY
 #include <snappy-c.h>
 #endif
+#ifdef ZSTD
+#include <zstd.h>
+#endif
 
 #ifndef ATTRIBUTE_UNUSED
 #define ATTRIBUTE_UNUSED __attribute__ ((__unused__))
@@ -300,6 +303,7 @@ struct number_option {
 #define NO_ELF_NOTES        (0x20)
 #define LZO_SUPPORTED       (0x40)
 #define SNAPPY_SUPPORTED    (0x80)
+#define ZSTD_SUPPORTED      (0x100)
 #define DISKDUMP_VALID()    (dd->flags & DISKDUMP_LOCAL)
 #define KDUMP_CMPRS_VALID() (dd->flags & KDUMP_CMPRS_LOCAL)
 #define KDUMP_SPLIT()       (dd->flags & DUMPFILE_SPLIT)
@@ -518,6 +522,10 @@ struct program_context {
 #define INCOMPLETE_DUMP  (0x8000ULL)
 #define is_incomplete_dump() (pc->flags2 & INCOMPLETE_DUMP)
 #define QEMU_MEM_DUMP_COMPRESSED (0x10000ULL)
+#define LIVE_CACHE_OFF   (0x20000ULL)
+#define LIVE_CACHE_FROZEN (0x40000ULL)
+#define VMLINUX_TEXT     (0x80000ULL)
+#define VMLINUX_TEXT_VERIFY (0x100000ULL)
 	char *cleanup;
 	char *namelist_orig;
 	char *namelist_debug_orig;
@@ -820,6 +828,13 @@ struct task_table {                      /* kernel/local task table data */
 	ulong tgid_cache_hits;
 	long filepages;
 	long anonpages;
+	ulong total_forks;
+	ulong *prev_tasks;
+	ulong prev_task_count;
+	long refresh_span_start;
+	long refresh_span_size;
+	ulong refresh_skipped;
+	ulong refresh_partial;
 };
 
 #define TASK_INIT_DONE       (0x1)
@@ -931,6 +946,22 @@ struct vaddr_range {
 #define MAX_KVADDR_RANGES KVADDR_MODULES
 };
 
+#define UVTOP_RANGE_PAGES (512)
+
+struct uvtop_range {         /* user translations of one page table span */
+	ulong start;
+	ulong end;
+	int type;
+#define UVTOP_RANGE_UNMAPPED  (1)   /* no page table present */
+#define UVTOP_RANGE_HUGE      (2)   /* physically contiguous from base */
+#define UVTOP_RANGE_PTES      (3)   /* paddr[] or non-present pte per page */
+	physaddr_t base;
+	physaddr_t paddr[UVTOP_RANGE_PAGES];
+	char mapped[UVTOP_RANGE_PAGES];
+	ulong mm;
+	ulong cmdgen;
+};
+
 #define MAX_MACHDEP_ARGS 5  /* for --machdep/-m machine-specific args */
 
 struct machdep_table {
@@ -1000,6 +1031,7 @@ struct machdep_table {
         int (*verify_line_number)(ulong, ulong, ulong);
         void (*get_irq_affinity)(int);
         void (*show_interrupts)(int, ulong *);
+	int (*uvtop_range)(struct task_context *, ulong, ulong, struct uvtop_range *);
 };
 
 /*
@@ -2338,6 +2370,9 @@ struct list_data {             /* generic structure used by do_list() to walk */
 #define LIST_ALLOCATE       (VERBOSE << 10)
 #define LIST_CALLBACK       (VERBOSE << 11)
 #define CALLBACK_RETURN     (VERBOSE << 12)
+#define LIST_READ_MEMBER    (VERBOSE << 13)
+#define LIST_BRENT_ALGO     (VERBOSE << 14)
+#define LIST_COUNT_ONLY     (VERBOSE << 15)
 
 struct tree_data {
 	ulong flags;
@@ -2354,6 +2389,8 @@ struct tree_data {
 #define TREE_POSITION_DISPLAY     (VERBOSE << 4)
 #define TREE_STRUCT_RADIX_10      (VERBOSE << 5)
 #define TREE_STRUCT_RADIX_16      (VERBOSE << 6)
+#define TREE_READ_MEMBER          (VERBOSE << 7)
+#define TREE_COUNT_ONLY           (VERBOSE << 8)
 
 #define ALIAS_RUNTIME  (1)
 #define ALIAS_RCLOCAL  (2)
@@ -2479,6 +2516,9 @@ struct symbol_table_data {
 	ulong first_section_start;
 	ulong last_section_end;
 	ulong _stext_vmlinux;
+	char *index_cache;
+	ulong index_cache_hits;
+	ulong index_cache_saves;
 };
 
 /* flags for st */
@@ -2512,6 +2552,9 @@ struct symbol_table_data {
 #define MAX_MOD_NAME     (64)
 #define MAX_MOD_SEC_NAME (64)
 
+#define MOD_SYMFILE(lm) \
+	((lm)->mod_debuginfo[0] ? (lm)->mod_debuginfo : (lm)->mod_namelist)
+
 #define MOD_EXT_SYMS    (0x1)
 #define MOD_LOAD_SYMS   (0x2)
 #define MOD_REMOTE      (0x4)
@@ -2541,6 +2584,7 @@ struct load_module {
 	ulong module_struct;
         long mod_size;
         char mod_namelist[MAX_MOD_NAMELIST];
+        char mod_debuginfo[MAX_MOD_NAMELIST];
         char mod_name[MAX_MOD_NAME];
         ulong mod_flags;
 	struct syment *mod_symtable;
@@ -4335,6 +4379,7 @@ void cmd_s390dbf(void);
 #endif
 void cmd_map(void);          /* kvmdump.c */
 void cmd_ipcs(void);         /* ipcs.c */
+void cmd_copydump(void);     /* diskdump.c */
 
 /*
  *  main.c
@@ -4499,6 +4544,17 @@ int lowest_bit_long(ulong);
 void buf_init(void);
 void sym_buf_init(void);
 void free_all_bufs(void);
+struct arena_scope {
+	void *chunk;
+	ulong used;
+	ulong resets;
+};
+void *arena_alloc(long, ulong);
+#define ARENA_ZERO  (0x1)
+void arena_scope_begin(struct arena_scope *);
+void arena_scope_end(struct arena_scope *);
+void arena_reset(void);
+void dump_arena(void);
 char *getbuf(long);
 void freebuf(char *);
 char *resizebuf(char *, long, long);
@@ -4507,6 +4563,8 @@ char *strdupbuf(char *);
 #define FREEBUF(X)  freebuf((char *)(X))
 #define RESIZEBUF(X,Y,Z) (X) = resizebuf((char *)(X), (long)(Y), (long)(Z));
 #define STRDUPBUF(X) strdupbuf((char *)(X))
+#define ARENA_ALLOC(X)  arena_alloc((long)(X), 0)
+#define ARENA_ZALLOC(X) arena_alloc((long)(X), ARENA_ZERO)
 void sigsetup(int, void *, struct sigaction *, struct sigaction *);
 #define SIGACTION(s, h, a, o) sigsetup(s, h, a, o)
 char *convert_time(ulonglong, char *);
@@ -4627,6 +4685,10 @@ int text_value_cache(ulong, uint32_t, uint32_t *);
 int text_value_cache_byte(ulong, unsigned char *);
 void dump_text_value_cache(int);
 void clear_text_value_cache(void);
+int vmlinux_text_init(void);
+int vmlinux_text_read(ulong, void *, long);
+void vmlinux_text_verify(void);
+void dump_vmlinux_text(void);
 void dump_numargs_cache(void);
 int patch_kernel_symbol(struct gnu_request *);
 struct syment *generic_machdep_value_to_symbol(ulong, ulong *);
@@ -4650,6 +4712,8 @@ struct struct_member_data {
 };
 int fill_struct_member_data(struct struct_member_data *);
 void parse_for_member_extended(struct datatype_member *, ulong);
+char *index_cache_file(char *);
+void index_cache_update(void);
 
 /*  
  *  memory.c 
@@ -4671,6 +4735,7 @@ int write_lkcd_dumpfile(int, void *, int, ulong, physaddr_t);
 int write_daemon(int, void *, int, ulong, physaddr_t);
 int kvtop(struct task_context *, ulong, physaddr_t *, int);
 int uvtop(struct task_context *, ulong, physaddr_t *, int);
+int uvtop_range_lookup(struct task_context *, ulong, ulong, physaddr_t *, ulong *);
 void do_vtop(ulong, struct task_context *, ulong);
 void raw_stack_dump(ulong, ulong);
 void raw_data_dump(ulong, long, int);
@@ -4679,6 +4744,7 @@ ulong vm_area_dump(ulong, ulong, ulong, struct reference *);
 #define IN_TASK_VMA(TASK,VA) (vm_area_dump((TASK), UVADDR|VERIFY_ADDR, (VA), 0))
 char *fill_vma_cache(ulong);
 void clear_vma_cache(void);
+void clear_live_cache(void);
 void dump_vma_cache(ulong);
 int is_page_ptr(ulong, physaddr_t *);
 void dump_vm_table(int);
@@ -4722,12 +4788,25 @@ int file_exists(char *, struct stat *);
 int file_readable(char *);
 int is_directory(char *);
 char *search_directory_tree(char *, char *, int);
+char *search_directory_index(char *, char *, int);
 void open_tmpfile(void);
 void close_tmpfile(void);
 void open_tmpfile2(void);
 void set_tmpfile2(FILE *);
 void close_tmpfile2(void);
 void open_files_dump(ulong, int, struct reference *);
+struct task_fds {
+	ulong files_struct;
+	int status;
+	int max_fds;
+	int count;
+	int *fd;
+	ulong *file;
+};
+#define TASK_FDS_NONE  (0)   /* no files_struct or fdtable */
+#define TASK_FDS_EMPTY (1)   /* no open_fds bitmap or fd array */
+#define TASK_FDS_FOUND (2)
+int get_task_fds(ulong, struct task_fds *);
 void get_pathname(ulong, char *, int, int, ulong);
 char *vfsmount_devname(ulong, char *, int);
 ulong file_to_dentry(ulong);
@@ -4813,6 +4892,7 @@ extern char *help_alias[];
 extern char *help_ascii[];
 extern char *help_bt[];
 extern char *help_btop[];
+extern char *help_copydump[];
 extern char *help_dev[];
 extern char *help_dis[];
 extern char *help_eval[];
@@ -4850,6 +4930,7 @@ extern char *help_swap[];
 extern char *help_sym[];
 extern char *help_sys[];
 extern char *help_task[];
+extern char *help_test[];
 extern char *help_timer[];
 extern char *help_union[];
 extern char *help_vm[];
@@ -4912,6 +4993,7 @@ void do_task(ulong, ulong, struct reference *, unsigned int);
 void clear_task_cache(void);
 int get_active_set(void);
 void clear_active_set(void);
+void task_table_refresh(void);
 void do_sig(ulong, ulong, struct reference *);
 void modify_signame(int, char *, char *);
 ulong generic_get_stackbase(ulong);
@@ -4953,6 +5035,9 @@ void generic_get_irq_affinity(int);
 void generic_show_interrupts(int, ulong *);
 int generic_dis_filter(ulong, char *, unsigned int);
 int kernel_BUG_encoding_bytes(void);
+int disasm_cache_lines(ulong, long, FILE *);
+void clear_disasm_cache(void);
+void dump_disasm_cache(void);
 void display_sys_stats(void);
 char *get_uptime(char *, ulonglong *);
 void clone_bt_info(struct bt_info *, struct bt_info *, struct task_context *);
@@ -5408,6 +5493,9 @@ struct machine_specific {
 	int vmemmap_psize;
 	ulong vmemmap_base;
 	struct ppc64_vmemmap *vmemmap_list;
+	int *vmemmap_index;
+	ulong vmemmap_index_cnt;
+	struct ppc64_vmemmap *vmemmap_last;
 	ulong _page_present;
 	ulong _page_user;
 	ulong _page_rw;
@@ -5662,6 +5750,7 @@ struct machine_specific {
  *  netdump.c 
  */
 int is_netdump(char *, ulong);
+void clear_netdump_data(void);
 uint netdump_page_size(void);
 int read_netdump(int, void *, int, ulong, physaddr_t);
 int write_netdump(int, void *, int, ulong, physaddr_t);
@@ -5679,6 +5768,7 @@ void get_netdump_regs_x86_64(struct bt_info *, ulong *, ulong *);
 void dump_registers_for_elf_dumpfiles(void);
 struct vmcore_data;
 struct vmcore_data *get_kdump_vmcore_data(void);
+int netdump_get_notes(void **, ulong *);
 int read_kdump(int, void *, int, ulong, physaddr_t);
 int write_kdump(int, void *, int, ulong, physaddr_t);
 int is_kdump(char *, ulong);
@@ -5728,6 +5818,7 @@ int is_ramdump_image(void);
  *  diskdump.c
  */
 int is_diskdump(char *);
+void clear_diskdump_data(void);
 uint diskdump_page_size(void);
 int read_diskdump(int, void *, int, ulong, physaddr_t);
 int write_diskdump(int, void *, int, ulong, physaddr_t);
@@ -5847,6 +5938,11 @@ int qemu_init(char *);
 int is_qemu_vm_file(char *);
 void dump_qemu_header(FILE *);
 
+/*
+ *  ipcs.c
+ */
+int do_idr(ulong, int (*)(int, ulong, void *), void *);
+
 /*
  *  net.c
  */
@@ -52,6 +52,9 @@ struct diskdump_data {
 	char	*compressed_page;	/* copy of compressed page data */
 	char	*curbufptr;		/* ptr to uncompressed page buffer */
 	unsigned char *notes_buf;	/* copy of elf notes */
+#ifdef ZSTD
+	ZSTD_DCtx *zstd_dctx;		/* session-long zstd context */
+#endif
 	void	**nt_prstatus_percpu;
 	uint	num_prstatus_notes;
 	void	**nt_qemu_percpu;
@@ -221,6 +224,20 @@ clean_diskdump_data(void)
 	dd = &diskdump_data;
 }
 
+/*
+ *  Forget the current dumpfile so that is_diskdump() may be applied to
+ *  another one.  Only used by "test -b" in a child process, so nothing
+ *  is freed.
+ */
+void
+clear_diskdump_data(void)
+{
+	dd_list = NULL;
+	num_dd = num_dumpfiles = 0;
+	dd = &diskdump_data;
+	BZERO(dd, sizeof(struct diskdump_data));
+}
+
 static inline int 
 get_bit(char *map, int byte, int bit)
 {
@@ -900,6 +917,11 @@ is_diskdump(char *file)
 	dd->flags |= SNAPPY_SUPPORTED;
 #endif
 
+#ifdef ZSTD
+	if ((dd->zstd_dctx = ZSTD_createDCtx()))
+		dd->flags |= ZSTD_SUPPORTED;
+#endif
+
 	pc->read_vmcoreinfo = vmcoreinfo_read_string;
 
 	if ((pc->flags2 & GET_LOG) && KDUMP_CMPRS_VALID()) {
@@ -1138,6 +1160,32 @@ cache_page(physaddr_t paddr)
 			      ret);
 			return READ_ERROR;
 		}
+#endif
+	} else if (pd.flags & DUMP_DH_COMPRESSED_ZSTD) {
+
+		if (!(dd->flags & ZSTD_SUPPORTED)) {
+			error(INFO, "%s: uncompress failed: no zstd compression support\n",
+			      DISKDUMP_VALID() ? "diskdump" : "compressed kdump");
+			return READ_ERROR;
+		}
+
+#ifdef ZSTD
+		/*
+		 *  The decompression context is created once at init time
+		 *  and reused for every page.
+		 */
+		retlen = ZSTD_decompressDCtx(dd->zstd_dctx,
+					     dd->page_cache_hdr[i].pg_bufptr,
+					     block_size,
+					     dd->compressed_page,
+					     pd.size);
+		if (ZSTD_isError(retlen) || (retlen != block_size)) {
+			error(INFO, "%s: uncompress failed: %s\n",
+			      DISKDUMP_VALID() ? "diskdump" : "compressed kdump",
+			      ZSTD_isError(retlen) ? 
+			      ZSTD_getErrorName(retlen) : "short page");
+			return READ_ERROR;
+		}
 #endif
 	} else
 		memcpy(dd->page_cache_hdr[i].pg_bufptr,
@@ -1619,6 +1667,8 @@ __diskdump_memory_dump(FILE *fp)
 		fprintf(fp, "%sLZO_SUPPORTED", others++ ? "|" : "");
 	if (dd->flags & SNAPPY_SUPPORTED)
 		fprintf(fp, "%sSNAPPY_SUPPORTED", others++ ? "|" : "");
+	if (dd->flags & ZSTD_SUPPORTED)
+		fprintf(fp, "%sZSTD_SUPPORTED", others++ ? "|" : "");
         fprintf(fp, ") %s\n", FLAT_FORMAT() ? "[FLAT]" : "");
         fprintf(fp, "               dfd: %d\n", dd->dfd);
         fprintf(fp, "               ofp: %lx\n", (ulong)dd->ofp);
@@ -1683,6 +1733,8 @@ __diskdump_memory_dump(FILE *fp)
 			fprintf(fp, "DUMP_DH_COMPRESSED_LZO");
 		if (dh->status & DUMP_DH_COMPRESSED_SNAPPY)
 			fprintf(fp, "DUMP_DH_COMPRESSED_SNAPPY");
+		if (dh->status & DUMP_DH_COMPRESSED_ZSTD)
+			fprintf(fp, "DUMP_DH_COMPRESSED_ZSTD");
 		if (dh->status & DUMP_DH_COMPRESSED_INCOMPLETE)
 			fprintf(fp, "DUMP_DH_COMPRESSED_INCOMPLETE");
 		break;
@@ -2333,3 +2385,543 @@ dump_registers_for_compressed_kdump(void)
 }
 
 
+
+/*
+ *  Copy the physical memory of the current dumpfile, whatever its
+ *  format, into a new compressed kdump dumpfile.  Pages are read in
+ *  pfn order by way of the dumpfile's readmem function, so that
+ *  sequential-only formats are only read once.  Pages that are
+ *  excluded from the source dumpfile remain excluded, and all zero
+ *  pages share a single page of data.
+ */
+
+#define COPYDUMP_DESC_BATCH	(512)
+
+struct copydump_data {
+	char *filename;
+	int ofd;
+	int block_size;
+	int block_shift;
+	unsigned int compression;
+	ulonglong max_mapnr;
+	char *bitmap;			/* ram bitmap, then dumpable bitmap */
+	off_t bitmap_len;		/* length of each half */
+	char *page;
+	char *cbuf;
+	ulong cbuf_size;
+	void *wrkmem;
+#ifdef ZSTD
+	ZSTD_CCtx *zstd_cctx;
+#endif
+	off_t desc_offset;
+	off_t data_offset;
+	off_t zero_offset;
+	page_desc_t desc[COPYDUMP_DESC_BATCH];
+	ulong desc_cnt;
+	ulonglong desc_index;
+	ulonglong ram_pages;
+	ulonglong dumpable;
+	ulonglong zero_pages;
+	ulonglong excluded;
+	ulonglong compressed;
+	off_t data_bytes;
+};
+
+static physaddr_t
+copydump_pfn_to_paddr(struct copydump_data *cd, ulonglong pfn)
+{
+#ifdef ARM
+	return ((physaddr_t)pfn << cd->block_shift) + machdep->machspec->phys_base;
+#else
+	return (physaddr_t)pfn << cd->block_shift;
+#endif
+}
+
+static ulonglong
+copydump_paddr_to_pfn(struct copydump_data *cd, physaddr_t paddr)
+{
+#ifdef ARM
+	return (paddr - machdep->machspec->phys_base) >> cd->block_shift;
+#else
+	return paddr >> cd->block_shift;
+#endif
+}
+
+static ulong
+copydump_phys_base(void)
+{
+#if defined(X86_64) || defined(ARM)
+	return machdep->machspec->phys_base;
+#elif defined(ARM64)
+	return machdep->machspec->phys_offset;
+#else
+	return 0;
+#endif
+}
+
+/*
+ *  Release the output file and compression context.  Each is cleared
+ *  before it is released, so that this may safely be re-entered.
+ */
+static void
+copydump_release(struct copydump_data *cd)
+{
+	int fd;
+#ifdef ZSTD
+	ZSTD_CCtx *cctx;
+
+	if ((cctx = cd->zstd_cctx)) {
+		cd->zstd_cctx = NULL;
+		ZSTD_freeCCtx(cctx);
+	}
+#endif
+	if ((fd = cd->ofd) >= 0) {
+		cd->ofd = -1;
+		close(fd);
+	}
+}
+
+/*
+ *  Remove an unfinished output file.  This is called on every error
+ *  path before error(FATAL), and is also the command's cleanup function,
+ *  so that the file is removed if the command is aborted by a signal,
+ *  including one received while an earlier cleanup was in progress.
+ */
+static void
+copydump_cleanup(void *arg)
+{
+	struct copydump_data *cd;
+
+	cd = (struct copydump_data *)arg;
+	unlink(cd->filename);
+	copydump_release(cd);
+
+	pc->cmd_cleanup = NULL;
+	pc->cmd_cleanup_arg = NULL;
+}
+
+static void
+copydump_write(struct copydump_data *cd, void *buf, size_t len, off_t offset)
+{
+	ssize_t ret;
+	char *bufptr;
+
+	for (bufptr = buf; len; bufptr += ret, len -= ret, offset += ret) {
+		if ((ret = pwrite(cd->ofd, bufptr, len, offset)) <= 0) {
+			error(INFO, "%s: write error: %s\n", cd->filename,
+				ret < 0 ? strerror(errno) : "short write");
+			copydump_cleanup(cd);
+			error(FATAL, "%s: file removed\n", cd->filename);
+		}
+	}
+}
+
+static void
+copydump_flush_desc(struct copydump_data *cd)
+{
+	if (!cd->desc_cnt)
+		return;
+
+	copydump_write(cd, cd->desc, sizeof(page_desc_t) * cd->desc_cnt,
+		cd->desc_offset + (off_t)sizeof(page_desc_t) * 
+		(cd->desc_index - cd->desc_cnt));
+	cd->desc_cnt = 0;
+}
+
+static int
+copydump_zero_page(struct copydump_data *cd)
+{
+	ulong *p, *end;
+
+	end = (ulong *)(cd->page + cd->block_size);
+	for (p = (ulong *)cd->page; p < end; p++)
+		if (*p)
+			return FALSE;
+
+	return TRUE;
+}
+
+/*
+ *  Compress the page into cd->cbuf, returning the compressed size, 
+ *  or 0 if the page does not compress and should be stored as is.
+ */
+static ulong
+copydump_compress(struct copydump_data *cd)
+{
+	ulong len;
+	int ret;
+
+	switch (cd->compression)
+	{
+	case DUMP_DH_COMPRESSED_ZLIB:
+		len = cd->cbuf_size;
+		ret = compress2((unsigned char *)cd->cbuf, &len, 
+			(unsigned char *)cd->page, cd->block_size, Z_BEST_SPEED);
+		if (ret != Z_OK)
+			return 0;
+		break;
+#ifdef LZO
+	case DUMP_DH_COMPRESSED_LZO: {
+		lzo_uint lzo_len;
+
+		ret = lzo1x_1_compress((unsigned char *)cd->page, cd->block_size,
+			(unsigned char *)cd->cbuf, &lzo_len, cd->wrkmem);
+		if (ret != LZO_E_OK)
+			return 0;
+		len = lzo_len;
+		break;
+	}
+#endif
+#ifdef SNAPPY
+	case DUMP_DH_COMPRESSED_SNAPPY: {
+		size_t snappy_len = cd->cbuf_size;
+
+		if (snappy_compress(cd->page, cd->block_size, cd->cbuf, 
+		    &snappy_len) != SNAPPY_OK)
+			return 0;
+		len = snappy_len;
+		break;
+	}
+#endif
+#ifdef ZSTD
+	case DUMP_DH_COMPRESSED_ZSTD: {
+		size_t zstd_len;
+
+		zstd_len = ZSTD_compressCCtx(cd->zstd_cctx, cd->cbuf, 
+			cd->cbuf_size, cd->page, cd->block_size, 1);
+		if (ZSTD_isError(zstd_len))
+			return 0;
+		len = zstd_len;
+		break;
+	}
+#endif
+	default:
+		return 0;
+	}
+
+	return (len < cd->block_size) ? len : 0;
+}
+
+static void
+copydump_page(struct copydump_data *cd, ulonglong pfn)
+{
+	page_desc_t *pd;
+	ulong len;
+
+	cd->dumpable++;
+	cd->bitmap[cd->bitmap_len + (pfn >> 3)] |= (1 << (pfn & 7));
+
+	pd = &cd->desc[cd->desc_cnt++];
+	cd->desc_index++;
+	pd->page_flags = 0;
+
+	if (copydump_zero_page(cd)) {
+		cd->zero_pages++;
+		if (!cd->zero_offset) {
+			cd->zero_offset = cd->data_offset;
+			copydump_write(cd, cd->page, cd->block_size, 
+				cd->data_offset);
+			cd->data_offset += cd->block_size;
+		}
+		pd->offset = cd->zero_offset;
+		pd->size = cd->block_size;
+		pd->flags = 0;
+	} else if ((len = copydump_compress(cd))) {
+		cd->compressed++;
+		pd->offset = cd->data_offset;
+		pd->size = len;
+		pd->flags = cd->compression;
+		copydump_write(cd, cd->cbuf, len, cd->data_offset);
+		cd->data_offset += len;
+	} else {
+		pd->offset = cd->data_offset;
+		pd->size = cd->block_size;
+		pd->flags = 0;
+		copydump_write(cd, cd->page, cd->block_size, cd->data_offset);
+		cd->data_offset += cd->block_size;
+	}
+
+	if (cd->desc_cnt == COPYDUMP_DESC_BATCH)
+		copydump_flush_desc(cd);
+}
+
+/*
+ *  Locate the VMCOREINFO note within the ELF notes being copied.
+ */
+static int
+copydump_vmcoreinfo(char *notes, ulong size, ulong *offset, ulong *len)
+{
+	Elf64_Nhdr *nhdr;
+	ulong off, next;
+
+	for (off = 0; (off + sizeof(Elf64_Nhdr)) <= size; off = next) {
+		nhdr = (Elf64_Nhdr *)(notes + off);
+		next = off + sizeof(Elf64_Nhdr) + roundup(nhdr->n_namesz, 4) +
+			roundup(nhdr->n_descsz, 4);
+		if (next > size)
+			break;
+		if ((nhdr->n_namesz == sizeof("VMCOREINFO")) &&
+		    STREQ(notes + off + sizeof(Elf64_Nhdr), "VMCOREINFO")) {
+			*offset = off + sizeof(Elf64_Nhdr) + 
+				roundup(nhdr->n_namesz, 4);
+			*len = nhdr->n_descsz;
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static int
+copydump_notes(void **notes, ulong *size)
+{
+	if (KDUMP_CMPRS_VALID() && dd->notes_buf) {
+		*notes = dd->notes_buf;
+		*size = dd->sub_header_kdump->size_note;
+		return TRUE;
+	}
+
+	return netdump_get_notes(notes, size);
+}
+
+static void
+copydump(struct copydump_data *cd)
+{
+	struct disk_dump_header *header;
+	struct kdump_sub_header *sub_header;
+	struct node_table *nt;
+	void *notes;
+	ulong notes_size, vmcoreinfo_offset, vmcoreinfo_size;
+	ulonglong pfn, start, end;
+	int i, ret, sub_hdr_size, bitmap_blocks;
+	off_t offset;
+
+	cd->block_size = PAGESIZE();
+	cd->block_shift = ffs(cd->block_size) - 1;
+
+	/*
+	 *  The candidate RAM pages are those within the memory nodes.
+	 */
+	for (i = 0; i < vt->numnodes; i++) {
+		nt = &vt->node_table[i];
+		end = copydump_paddr_to_pfn(cd, nt->start_paddr) + nt->size;
+		if (end > cd->max_mapnr)
+			cd->max_mapnr = end;
+	}
+	if (!cd->max_mapnr) {
+		copydump_cleanup(cd);
+		error(FATAL, "cannot determine the physical memory layout\n");
+	}
+
+	cd->bitmap_len = roundup(divideup(cd->max_mapnr, 8), cd->block_size);
+	cd->bitmap = GETBUF(cd->bitmap_len * 2);
+	for (i = 0; i < vt->numnodes; i++) {
+		nt = &vt->node_table[i];
+		start = copydump_paddr_to_pfn(cd, nt->start_paddr);
+		for (pfn = start; pfn < (start + nt->size); pfn++) {
+			if (!(cd->bitmap[pfn >> 3] & (1 << (pfn & 7)))) {
+				cd->bitmap[pfn >> 3] |= (1 << (pfn & 7));
+				cd->ram_pages++;
+			}
+		}
+	}
+
+	if (!copydump_notes(&notes, &notes_size))
+		notes_size = 0;
+	if (!notes_size || !copydump_vmcoreinfo(notes, notes_size, 
+	    &vmcoreinfo_offset, &vmcoreinfo_size))
+		vmcoreinfo_offset = vmcoreinfo_size = 0;
+
+	/*
+	 *  Layout: header block, sub-header blocks containing the ELF notes,
+	 *  the ram and dumpable bitmaps, the page descriptors, and then the
+	 *  page data.  Descriptor space is reserved for every candidate page.
+	 */
+	sub_hdr_size = divideup(sizeof(struct kdump_sub_header) + notes_size, 
+		cd->block_size);
+	bitmap_blocks = (cd->bitmap_len * 2) / cd->block_size;
+	cd->desc_offset = (off_t)cd->block_size * 
+		(1 + sub_hdr_size + bitmap_blocks);
+	cd->data_offset = cd->desc_offset + 
+		(off_t)sizeof(page_desc_t) * cd->ram_pages;
+
+	cd->page = GETBUF(cd->block_size);
+	cd->cbuf_size = compressBound(cd->block_size);
+#ifdef LZO
+	if (cd->compression == DUMP_DH_COMPRESSED_LZO) {
+		cd->cbuf_size = cd->block_size + cd->block_size/16 + 64 + 3;
+		cd->wrkmem = GETBUF(LZO1X_1_MEM_COMPRESS);
+	}
+#endif
+#ifdef SNAPPY
+	if (cd->compression == DUMP_DH_COMPRESSED_SNAPPY)
+		cd->cbuf_size = snappy_max_compressed_length(cd->block_size);
+#endif
+#ifdef ZSTD
+	if (cd->compression == DUMP_DH_COMPRESSED_ZSTD) {
+		cd->cbuf_size = ZSTD_compressBound(cd->block_size);
+		if (!(cd->zstd_cctx = ZSTD_createCCtx())) {
+			copydump_cleanup(cd);
+			error(FATAL, 
+			    "cannot create zstd compression context\n");
+		}
+	}
+#endif
+	cd->cbuf = GETBUF(cd->cbuf_size);
+
+	please_wait("copying dumpfile");
+
+	for (pfn = 0; pfn < cd->max_mapnr; pfn++) {
+		if (!(cd->bitmap[pfn >> 3] & (1 << (pfn & 7))))
+			continue;
+
+		if (received_SIGINT())
+			break;
+
+		pc->curcmd_flags &= ~MEMTYPE_KVADDR;
+		ret = READMEM(pc->dfd, cd->page, cd->block_size, 0,
+			copydump_pfn_to_paddr(cd, pfn));
+
+		if (ret == PAGE_EXCLUDED)
+			cd->excluded++;
+		else if (ret != cd->block_size)
+			cd->bitmap[pfn >> 3] &= ~(1 << (pfn & 7));
+		else
+			copydump_page(cd, pfn);
+	}
+
+	please_wait_done();
+
+	if (pfn < cd->max_mapnr) {
+		copydump_cleanup(cd);
+		error(FATAL, "%s: interrupted: file removed\n", cd->filename);
+	}
+
+	copydump_flush_desc(cd);
+
+	offset = (off_t)cd->block_size * (1 + sub_hdr_size);
+	copydump_write(cd, cd->bitmap, cd->bitmap_len * 2, offset);
+
+	sub_header = (struct kdump_sub_header *)
+		GETBUF(cd->block_size * sub_hdr_size);
+	sub_header->phys_base = copydump_phys_base();
+	sub_header->dump_level = cd->excluded ? 1 : 0;
+	sub_header->split = 0;
+	sub_header->start_pfn = 0;
+	sub_header->end_pfn = (unsigned long)cd->max_mapnr;
+	if (notes_size) {
+		sub_header->offset_note = (off_t)cd->block_size + 
+			sizeof(struct kdump_sub_header);
+		sub_header->size_note = notes_size;
+		memcpy((char *)sub_header + sizeof(struct kdump_sub_header), 
+			notes, notes_size);
+	}
+	if (vmcoreinfo_size) {
+		sub_header->offset_vmcoreinfo = sub_header->offset_note + 
+			vmcoreinfo_offset;
+		sub_header->size_vmcoreinfo = vmcoreinfo_size;
+	}
+	sub_header->start_pfn_64 = 0;
+	sub_header->end_pfn_64 = cd->max_mapnr;
+	sub_header->max_mapnr_64 = cd->max_mapnr;
+	copydump_write(cd, sub_header, cd->block_size * sub_hdr_size, 
+		cd->block_size);
+
+	header = (struct disk_dump_header *)GETBUF(cd->block_size);
+	memcpy(header->signature, KDUMP_SIGNATURE, SIG_LEN);
+	header->header_version = 6;
+	memcpy(&header->utsname, &kt->utsname, sizeof(struct new_utsname));
+	header->timestamp.tv_sec = kt->date.tv_sec;
+	header->timestamp.tv_usec = kt->date.tv_nsec / 1000;
+	header->status = cd->compression;
+	header->block_size = cd->block_size;
+	header->sub_hdr_size = sub_hdr_size;
+	header->bitmap_blocks = bitmap_blocks;
+	header->max_mapnr = (cd->max_mapnr > UINT_MAX) ? 
+		UINT_MAX : (unsigned int)cd->max_mapnr;
+	header->nr_cpus = kt->cpus;
+	copydump_write(cd, header, cd->block_size, 0);
+
+	if (close(cd->ofd) < 0) {
+		error(INFO, "%s: close: %s\n", cd->filename, strerror(errno));
+		cd->ofd = -1;
+		copydump_cleanup(cd);
+		error(FATAL, "%s: file removed\n", cd->filename);
+	}
+	cd->ofd = -1;
+	copydump_release(cd);
+
+	pc->cmd_cleanup = NULL;
+	pc->cmd_cleanup_arg = NULL;
+
+	cd->data_bytes = cd->data_offset - cd->desc_offset;
+}
+
+void
+cmd_copydump(void)
+{
+	int c;
+	static struct copydump_data copydump_data;
+	struct copydump_data *cd;
+
+	cd = &copydump_data;
+	BZERO(cd, sizeof(struct copydump_data));
+	cd->ofd = -1;
+	cd->compression = DUMP_DH_COMPRESSED_ZLIB;
+
+	while ((c = getopt(argcnt, args, "lsz")) != EOF) {
+		switch(c)
+		{
+		case 'l':
+#ifdef LZO
+			if (lzo_init() != LZO_E_OK)
+				error(FATAL, "lzo_init() failed\n");
+			cd->compression = DUMP_DH_COMPRESSED_LZO;
+			break;
+#else
+			error(FATAL, "no lzo compression support\n");
+#endif
+		case 's':
+#ifdef SNAPPY
+			cd->compression = DUMP_DH_COMPRESSED_SNAPPY;
+			break;
+#else
+			error(FATAL, "no snappy compression support\n");
+#endif
+		case 'z':
+#ifdef ZSTD
+			cd->compression = DUMP_DH_COMPRESSED_ZSTD;
+			break;
+#else
+			error(FATAL, "no zstd compression support\n");
+#endif
+		default:
+			argerrs++;
+			break;
+		}
+	}
+
+	if (argerrs || !args[optind] || args[optind+1])
+		cmd_usage(pc->curcmd, SYNOPSIS);
+
+	if (!DUMPFILE() || REMOTE())
+		error(FATAL, "only supported on dumpfiles\n");
+
+	cd->filename = args[optind];
+	if (file_exists(cd->filename, NULL))
+		error(FATAL, "%s: file exists\n", cd->filename);
+	if ((cd->ofd = open(cd->filename, O_WRONLY|O_CREAT|O_EXCL, 
+	    S_IRUSR|S_IWUSR)) < 0)
+		error(FATAL, "%s: %s\n", cd->filename, strerror(errno));
+
+	pc->cmd_cleanup_arg = (void *)cd;
+	pc->cmd_cleanup = copydump_cleanup;
+
+	copydump(cd);
+
+	fprintf(fp, "%s: %lld pages (%lld compressed, %lld zero, %lld excluded)\n",
+		cd->filename, cd->dumpable, cd->compressed, cd->zero_pages, 
+		cd->excluded);
+	fprintf(fp, "%s  page data: %lld bytes\n", space(strlen(cd->filename)),
+		(ulonglong)cd->data_bytes);
+}
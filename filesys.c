@@ -18,6 +18,7 @@
 #include "defs.h"
 #include <linux/major.h>
 #include <regex.h>
+#include <fnmatch.h>
 #include <sys/utsname.h>
 
 static void show_mounts(ulong, int, struct task_context *);
@@ -46,37 +47,109 @@ static int get_memory_driver_dev(dev_t *);
 static int memory_driver_init(void);
 static int create_memory_device(dev_t);
 static void *radix_tree_lookup(ulong, ulong, int);
+struct radix_tree_walk;
+static int radix_tree_walk(ulong, ulong, int, struct radix_tree_walk *);
+static int radix_tree_walk_entry(struct radix_tree_walk *, ulong, ulong);
 static int match_file_string(char *, char *, char *);
 static ulong get_root_vfsmount(char *);
 static void check_live_arch_mismatch(void);
 static long get_inode_nrpages(ulong);
 static void dump_inode_page_cache_info(ulong);
+static void dump_directory_index(void);
 
-#define DENTRY_CACHE (20)
-#define INODE_CACHE  (20)
-#define FILE_CACHE   (20)
+/*
+ *  The file, dentry, inode and vfsmount/mount structures read by the
+ *  file-related commands are kept in hashed object caches.  The slots of
+ *  each cache are recycled in FIFO order, so a buffer returned by one of
+ *  the fill functions remains valid for the next FS_CACHE_ENTRIES-1 fills
+ *  of that cache, while a lookup only walks one short hash chain.
+ */
+#define FS_CACHE_ENTRIES   (4096)     /* must be a power of 2 */
+#define FS_CACHE_HASH(X)   ((((X) >> 4) ^ ((X) >> 16)) & (FS_CACHE_ENTRIES-1))
 
-static struct filesys_table {
-        char *dentry_cache;
-	ulong cached_dentry[DENTRY_CACHE];
-	ulong cached_dentry_hits[DENTRY_CACHE];
-	int dentry_cache_index;
-	ulong dentry_cache_fills;
+struct fs_cache {
+	char *name;
+	long size;
+	char *buf;
+	int index;
+	ulong fills;
+	ulong hits;
+	ulong cached[FS_CACHE_ENTRIES];
+	int next[FS_CACHE_ENTRIES];      /* hash chain: slot+1, or 0 */
+	int head[FS_CACHE_ENTRIES];      /* hash heads: slot+1, or 0 */
+};
 
-        char *inode_cache;
-        ulong cached_inode[INODE_CACHE];
-        ulong cached_inode_hits[INODE_CACHE];
-        int inode_cache_index;
-        ulong inode_cache_fills;
+/*
+ *  get_pathname() results are memoized by dentry, vfsmount and the "full"
+ *  argument.  Since the path of a directory is a prefix of the path of 
+ *  each of its entries, the paths of the ancestors that are seen while
+ *  resolving a dentry are entered as well, so that a walk stops at the
+ *  first ancestor whose path is already known.
+ */
+#define PATH_CACHE_ENTRIES (4096)     /* must be a power of 2 */
+#define PATH_CACHE_DEPTH   (64)
+#define PATH_CACHE_HASH(D,V) \
+	((((D) >> 4) ^ ((D) >> 16) ^ ((V) >> 6)) & (PATH_CACHE_ENTRIES-1))
 
-        char *file_cache;
-        ulong cached_file[FILE_CACHE];
-        ulong cached_file_hits[FILE_CACHE];
-        int file_cache_index;
-        ulong file_cache_fills;
+struct path_cache_entry {
+	ulong dentry;
+	ulong vfsmnt;
+	int full;
+	char *pathname;
+};
 
-} filesys_table = { 0 };
+/*
+ *  The open fds of each files_struct seen during a command, gathered
+ *  by get_task_fds().  The fd and file arrays of each entry are slices
+ *  of the shared fd and file arrays, starting at index "first".
+ */
+#define FD_CACHE_HASH_SIZE (1024)     /* must be a power of 2 */
+#define FD_CACHE_HASH(X)   ((((X) >> 6) ^ ((X) >> 16)) & (FD_CACHE_HASH_SIZE-1))
+
+struct fd_cache_entry {
+	ulong files_struct;
+	int status;
+	int max_fds;
+	long first;
+	int count;
+	int next;
+};
+
+struct fd_cache {
+	ulong cmdgen;
+	struct fd_cache_entry *entry;
+	int entries;
+	int max_entries;
+	int *fd;
+	ulong *file;
+	long fds;
+	long max_fds;
+	int head[FD_CACHE_HASH_SIZE];
+	ulong lookups;
+	ulong hits;
+};
 
+static struct filesys_table {
+	struct fs_cache file_cache;
+	struct fs_cache dentry_cache;
+	struct fs_cache inode_cache;
+	struct fs_cache mount_cache;
+
+	struct path_cache_entry path_cache[PATH_CACHE_ENTRIES];
+	ulong path_cache_lookups;
+	ulong path_cache_hits;
+
+	struct fd_cache fd_cache;
+} filesys_table = { { 0 } };
+
+static void fs_cache_init(struct fs_cache *, char *, long);
+static char *fs_cache_fill(struct fs_cache *, ulong);
+static void fs_cache_clear(struct fs_cache *);
+static void dump_fs_cache(struct fs_cache *, int);
+static char *fill_mount_cache(ulong);
+static char *path_cache_lookup(ulong, ulong, int);
+static void path_cache_enter(ulong, ulong, int, char *, int);
+static void clear_path_cache(void);
 
 static struct filesys_table *ft = &filesys_table;
 
@@ -1054,6 +1127,211 @@ search_directory_tree(char *directory, char *file, int follow_links)
 
 	return retbuf;
 }
+
+/*
+ *  The pathnames below a directory tree, gathered by a single find
+ *  command, so that the searches made for each module object file by
+ *  "mod -S" don't each re-walk the same trees.  An index is only used
+ *  during the command that created it.  Trees with more than
+ *  DIRECTORY_INDEX_MAX entries are marked as unindexed for the rest of
+ *  the command, and are searched with find each time.
+ */
+#define DIRECTORY_INDEXES   (8)
+#define DIRECTORY_INDEX_MAX (200000)
+
+static struct directory_index {
+	char *directory;
+	int follow_links;
+	int unindexed;
+	ulong cmdgen;
+	char *paths;
+	ulong size;
+	ulong used;
+	ulong *names;
+	long count;
+	long max;
+} directory_index[DIRECTORY_INDEXES] = { { 0 } };
+
+static int directory_index_next = 0;
+static ulong directory_index_walks = 0;
+static ulong directory_index_searches = 0;
+
+static void
+directory_index_free(struct directory_index *di)
+{
+	free(di->directory);
+	free(di->paths);
+	free(di->names);
+	BZERO(di, sizeof(struct directory_index));
+}
+
+static struct directory_index *
+directory_index_build(char *directory, int follow_links)
+{
+	struct directory_index *di;
+	char command[BUFSIZE];
+	char buf[BUFSIZE];
+	FILE *pipe;
+	int i, done;
+	ulong len;
+	void *p;
+
+	for (i = 0; i < DIRECTORY_INDEXES; i++) {
+		di = &directory_index[i];
+		if (di->directory && (di->cmdgen == pc->cmdgencur) &&
+		    (di->follow_links == follow_links) &&
+		    STREQ(di->directory, directory))
+			return di->unindexed ? NULL : di;
+	}
+
+	di = &directory_index[directory_index_next];
+	directory_index_next = (directory_index_next+1) % DIRECTORY_INDEXES;
+	directory_index_free(di);
+
+	if (!file_exists("/usr/bin/find", NULL) || 
+	    !file_exists("/bin/echo", NULL) ||
+	    !is_directory(directory)) 
+		return NULL;
+
+	if (strlen(directory) > (BUFSIZE/2))
+		return NULL;
+
+	sprintf(command, "/usr/bin/find %s %s -print; /bin/echo search done",
+		follow_links ? "-L" : "", directory);
+
+        if ((pipe = popen(command, "r")) == NULL) {
+                error(INFO, "%s: %s\n", command, strerror(errno));
+                return NULL;
+        }
+
+	directory_index_walks++;
+
+	done = FALSE;
+        while (!done) {
+		if (!fgets(buf, BUFSIZE-1, pipe)) {
+			if (feof(pipe))
+				break;
+			clearerr(pipe);
+			continue;
+		}
+                if (STREQ(buf, "search done\n")) {
+                        done = TRUE;
+                        break;
+                }
+		if (!strlen(strip_linefeeds(buf)))
+			continue;
+
+		len = strlen(buf) + 1;
+		if ((di->used + len) > di->size) {
+			if (!(p = realloc(di->paths, 
+			    MAX(di->size * 2, di->used + len + BUFSIZE*4))))
+				goto fail;
+			di->paths = p;
+			di->size = MAX(di->size * 2, di->used + len + BUFSIZE*4);
+		}
+		if (di->count == di->max) {
+			if ((di->count == DIRECTORY_INDEX_MAX) ||
+			    !(p = realloc(di->names, 
+			    (di->max ? di->max * 2 : 1024) * sizeof(ulong))))
+				goto fail;
+			di->names = p;
+			di->max = di->max ? di->max * 2 : 1024;
+		}
+		di->names[di->count++] = di->used;
+		strcpy(di->paths + di->used, buf);
+		di->used += len;
+		continue;
+fail:
+		free(di->paths);
+		free(di->names);
+		di->paths = NULL;
+		di->names = NULL;
+		di->size = di->used = 0;
+		di->count = di->max = 0;
+		di->unindexed = TRUE;
+		break;
+        }
+
+        pclose(pipe);
+
+	if ((!done && !di->unindexed) || 
+	    !(di->directory = strdup(directory))) {
+		directory_index_free(di);
+		return NULL;
+	}
+	di->follow_links = follow_links;
+	di->cmdgen = pc->cmdgencur;
+
+	return di->unindexed ? NULL : di;
+}
+
+/*
+ *  Equivalent to search_directory_tree(), but searches an index of the
+ *  directory tree that is built upon the first search of that tree 
+ *  during the current command.
+ */
+char *
+search_directory_index(char *directory, char *file, int follow_links)
+{
+	struct directory_index *di;
+	char *retbuf, *start, *end, *path, *module;
+	regex_t regex;
+	int regex_used;
+	long i;
+
+	if (*file == '(')
+		return NULL;
+
+	if (!(di = directory_index_build(directory, follow_links)))
+		return search_directory_tree(directory, file, follow_links);
+
+	directory_index_searches++;
+
+	retbuf = NULL;
+	regex_used = ((start = strstr(file, "[")) && 
+		(end = strstr(file, "]")) && (start < end) &&
+		(regcomp(&regex, file, 0) == 0));
+
+	for (i = 0; i < di->count; i++) {
+		path = di->paths + di->names[i];
+		module = (module = strrchr(path, '/')) ? module+1 : path;
+		if (fnmatch(file, module, 0))
+			continue;
+		if (regex_used ? (regexec(&regex, module, 0, NULL, 0) == 0) :
+		    STREQ(module, file)) {
+			retbuf = GETBUF(strlen(path)+1);
+			strcpy(retbuf, path);
+			break;
+		}
+	}
+
+	if (regex_used)
+		regfree(&regex);
+
+	return retbuf;
+}
+
+static void
+dump_directory_index(void)
+{
+	struct directory_index *di;
+	int i;
+
+	if (!directory_index_walks)
+		return;
+
+	fprintf(fp, "   directory index: walks: %ld searches: %ld\n",
+		directory_index_walks, directory_index_searches);
+	for (i = 0; i < DIRECTORY_INDEXES; i++) {
+		di = &directory_index[i];
+		if (di->unindexed)
+			fprintf(fp, "                    %s: (not indexed)\n",
+				di->directory);
+		else if (di->directory)
+			fprintf(fp, "                    %s: %ld entries\n",
+				di->directory, di->count);
+	}
+}
  
 /*
  *  Determine whether a file exists, and if so, if it's a tty.
@@ -2072,12 +2350,13 @@ vfs_init(void)
 	STRUCT_SIZE_INIT(fs_struct, "fs_struct");
 	STRUCT_SIZE_INIT(super_block, "super_block");
 
-	if (!(ft->file_cache = (char *)malloc(SIZE(file)*FILE_CACHE)))
-		error(FATAL, "cannot malloc file cache\n");
-	if (!(ft->dentry_cache = (char *)malloc(SIZE(dentry)*DENTRY_CACHE)))
-		error(FATAL, "cannot malloc dentry cache\n");
-	if (!(ft->inode_cache = (char *)malloc(SIZE(inode)*INODE_CACHE)))
-		error(FATAL, "cannot malloc inode cache\n");
+	fs_cache_init(&ft->file_cache, "file", SIZE(file));
+	fs_cache_init(&ft->dentry_cache, "dentry", SIZE(dentry));
+	fs_cache_init(&ft->inode_cache, "inode", SIZE(inode));
+	if (VALID_STRUCT(mount))
+		fs_cache_init(&ft->mount_cache, "mount", SIZE(mount));
+	else if (VALID_STRUCT(vfsmount))
+		fs_cache_init(&ft->mount_cache, "vfsmount", SIZE(vfsmount));
 
 	if (symbol_exists("height_to_maxindex")) {
 		int tmp ATTRIBUTE_UNUSED;
@@ -2109,63 +2388,65 @@ vfs_init(void)
 void
 dump_filesys_table(int verbose)
 {
-	int i;
-	ulong fhits, dhits, ihits;
-
-	if (!verbose)
-		goto show_hit_rates;
-
-        for (i = 0; i < FILE_CACHE; i++)
-                fprintf(fp, "   cached_file[%2d]: %lx (%ld)\n",
-                        i, ft->cached_file[i],
-                        ft->cached_file_hits[i]);
-        fprintf(fp, "        file_cache: %lx\n", (ulong)ft->file_cache);
-        fprintf(fp, "  file_cache_index: %d\n", ft->file_cache_index);
-        fprintf(fp, "  file_cache_fills: %ld\n", ft->file_cache_fills);
-
-	for (i = 0; i < DENTRY_CACHE; i++)
-		fprintf(fp, "  cached_dentry[%2d]: %lx (%ld)\n", 
-			i, ft->cached_dentry[i],
-			ft->cached_dentry_hits[i]);
-	fprintf(fp, "      dentry_cache: %lx\n", (ulong)ft->dentry_cache);
-	fprintf(fp, "dentry_cache_index: %d\n", ft->dentry_cache_index);
-	fprintf(fp, "dentry_cache_fills: %ld\n", ft->dentry_cache_fills);
-
-        for (i = 0; i < INODE_CACHE; i++)
-                fprintf(fp, "  cached_inode[%2d]: %lx (%ld)\n",
-                        i, ft->cached_inode[i],
-                        ft->cached_inode_hits[i]);
-        fprintf(fp, "       inode_cache: %lx\n", (ulong)ft->inode_cache);
-        fprintf(fp, " inode_cache_index: %d\n", ft->inode_cache_index);
-        fprintf(fp, " inode_cache_fills: %ld\n", ft->inode_cache_fills);
-
-show_hit_rates:
-        if (ft->file_cache_fills) {
-                for (i = fhits = 0; i < FILE_CACHE; i++)
-                        fhits += ft->cached_file_hits[i];
-
-                fprintf(fp, "     file hit rate: %2ld%% (%ld of %ld)\n",
-                        (fhits * 100)/ft->file_cache_fills,
-                        fhits, ft->file_cache_fills);
-	} 
+	int i, paths;
+
+	dump_fs_cache(&ft->file_cache, verbose);
+	dump_fs_cache(&ft->dentry_cache, verbose);
+	dump_fs_cache(&ft->inode_cache, verbose);
+	dump_fs_cache(&ft->mount_cache, verbose);
+
+	if (verbose) {
+		for (i = paths = 0; i < PATH_CACHE_ENTRIES; i++)
+			if (ft->path_cache[i].pathname)
+				paths++;
+		fprintf(fp, "        path_cache: %d entries (%d in use)\n",
+			PATH_CACHE_ENTRIES, paths);
+	}
 
-        if (ft->dentry_cache_fills) {
-                for (i = dhits = 0; i < DENTRY_CACHE; i++)
-                        dhits += ft->cached_dentry_hits[i];
+	if (ft->path_cache_lookups)
+		fprintf(fp, "     path hit rate: %2ld%% (%ld of %ld)\n",
+			(ft->path_cache_hits * 100)/ft->path_cache_lookups,
+			ft->path_cache_hits, ft->path_cache_lookups);
 
-		fprintf(fp, "   dentry hit rate: %2ld%% (%ld of %ld)\n",
-			(dhits * 100)/ft->dentry_cache_fills,
-			dhits, ft->dentry_cache_fills);
-	}
+	if (ft->fd_cache.lookups)
+		fprintf(fp, "       fd hit rate: %2ld%% (%ld of %ld)\n",
+			(ft->fd_cache.hits * 100)/ft->fd_cache.lookups,
+			ft->fd_cache.hits, ft->fd_cache.lookups);
 
-        if (ft->inode_cache_fills) {
-                for (i = ihits = 0; i < INODE_CACHE; i++)
-                        ihits += ft->cached_inode_hits[i];
+	dump_directory_index();
+}
+
+static void
+dump_fs_cache(struct fs_cache *fc, int verbose)
+{
+	int i, inuse, chain, maxchain, slot;
 
-		fprintf(fp, "    inode hit rate: %2ld%% (%ld of %ld)\n",
-                        (ihits * 100)/ft->inode_cache_fills,
-                        ihits, ft->inode_cache_fills);
+	if (!fc->buf)
+		return;
+
+	if (verbose) {
+		for (i = inuse = maxchain = 0; i < FS_CACHE_ENTRIES; i++) {
+			if (fc->cached[i])
+				inuse++;
+			for (chain = 0, slot = fc->head[i]; slot; 
+			     slot = fc->next[slot-1])
+				chain++;
+			if (chain > maxchain)
+				maxchain = chain;
+		}
+		fprintf(fp, "%*s_cache: %lx\n", 12, fc->name, (ulong)fc->buf);
+		fprintf(fp, "              size: %ld\n", fc->size);
+		fprintf(fp, "           entries: %d (%d in use)\n", 
+			FS_CACHE_ENTRIES, inuse);
+		fprintf(fp, "             index: %d\n", fc->index);
+		fprintf(fp, "             fills: %ld\n", fc->fills);
+		fprintf(fp, "      longest hash: %d\n", maxchain);
 	}
+
+	if (fc->fills)
+		fprintf(fp, "%*s hit rate: %2ld%% (%ld of %ld)\n", 
+			9, fc->name, (fc->hits * 100)/fc->fills,
+			fc->hits, fc->fills);
 }
 
 /*
@@ -2380,22 +2661,15 @@ open_files_dump(ulong task, int flags, struct reference *ref)
 {
         struct task_context *tc;
 	ulong files_struct_addr; 
-	ulong fdtable_addr = 0;
-	char *files_struct_buf, *fdtable_buf = NULL;
+	struct task_fds tf;
 	ulong fs_struct_addr;
 	char *dentry_buf, *fs_struct_buf;
 	char *ret ATTRIBUTE_UNUSED;
 	ulong root_dentry, pwd_dentry;
 	ulong root_inode, pwd_inode;
 	ulong vfsmnt;
-	int max_fdset = 0;
-	int max_fds = 0;
-	ulong open_fds_addr;
-	fd_set open_fds;
-	ulong fd;
-	ulong file;
 	ulong value;
-	int i, j, use_path;
+	int i, use_path;
 	int header_printed = 0;
 	char root_pathname[BUFSIZE];
 	char pwd_pathname[BUFSIZE];
@@ -2410,9 +2684,6 @@ open_files_dump(ulong task, int flags, struct reference *ref)
 
 	BZERO(root_pathname, BUFSIZE);
 	BZERO(pwd_pathname, BUFSIZE);
-	files_struct_buf = GETBUF(SIZE(files_struct));
-	if (VALID_STRUCT(fdtable))
-		fdtable_buf = GETBUF(SIZE(fdtable));
 	fill_task_struct(task);
 
 	if (flags & PRINT_NRPAGES) {
@@ -2527,46 +2798,12 @@ open_files_dump(ulong task, int flags, struct reference *ref)
 
 	files_struct_addr = ULONG(tt->task_struct + OFFSET(task_struct_files));
 
-	if (files_struct_addr) {
-		readmem(files_struct_addr, KVADDR, files_struct_buf,
-			SIZE(files_struct), "files_struct buffer",
-			FAULT_ON_ERROR);
-	
-		if (VALID_MEMBER(files_struct_max_fdset)) {
-			max_fdset = INT(files_struct_buf +
-			OFFSET(files_struct_max_fdset));
-
-			max_fds = INT(files_struct_buf +
-			OFFSET(files_struct_max_fds));
-		}
-	}
-
-	if (VALID_MEMBER(files_struct_fdt)) {
-		fdtable_addr = ULONG(files_struct_buf + OFFSET(files_struct_fdt));
-
-		if (fdtable_addr) {
-			readmem(fdtable_addr, KVADDR, fdtable_buf,
-	 			SIZE(fdtable), "fdtable buffer", FAULT_ON_ERROR); 
-			if (VALID_MEMBER(fdtable_max_fdset))
-				max_fdset = INT(fdtable_buf +
-					OFFSET(fdtable_max_fdset));
-			else
-				max_fdset = -1;
-			max_fds = INT(fdtable_buf +
-        	                OFFSET(fdtable_max_fds));
-		}
-	}
-
-	if ((VALID_MEMBER(files_struct_fdt) && !fdtable_addr) || 
-	    !files_struct_addr || max_fdset == 0 || max_fds == 0) {
+	if (get_task_fds(files_struct_addr, &tf) == TASK_FDS_NONE) {
 		if (ref) {
 			if (ref->cmdflags & FILES_REF_FOUND)
 				fprintf(fp, "\n");
 		} else
 			fprintf(fp, "No open files\n");
-		if (fdtable_buf)
-			FREEBUF(fdtable_buf);
-		FREEBUF(files_struct_buf);
 		return;
 	}
 
@@ -2576,7 +2813,7 @@ open_files_dump(ulong task, int flags, struct reference *ref)
                         ref->cmdflags |= FILES_REF_HEXNUM;
                 } else {
 			value = dtol(ref->str, FAULT_ON_ERROR, NULL);
-			if (value <= MAX(max_fdset, max_fds)) {
+			if (value <= tf.max_fds) {
                               	ref->decval = value;
                                	ref->cmdflags |= FILES_REF_DECNUM;
 			} else {
@@ -2587,37 +2824,9 @@ open_files_dump(ulong task, int flags, struct reference *ref)
 		}
         }
 
-	if (VALID_MEMBER(fdtable_open_fds))
-		open_fds_addr = ULONG(fdtable_buf +
-			OFFSET(fdtable_open_fds));
-	else
-		open_fds_addr = ULONG(files_struct_buf +
-			OFFSET(files_struct_open_fds));
-
-	if (open_fds_addr) {
-		if (VALID_MEMBER(files_struct_open_fds_init) && 
-		    (open_fds_addr == (files_struct_addr + 
-		    OFFSET(files_struct_open_fds_init)))) 
-			BCOPY(files_struct_buf + 
-			        OFFSET(files_struct_open_fds_init),
-				&open_fds, sizeof(fd_set));
-		else
-			readmem(open_fds_addr, KVADDR, &open_fds,
-				sizeof(fd_set), "fdtable open_fds",
-				FAULT_ON_ERROR);
-	} 
-
-	if (VALID_MEMBER(fdtable_fd))
-		fd = ULONG(fdtable_buf + OFFSET(fdtable_fd));
-	else
-		fd = ULONG(files_struct_buf + OFFSET(files_struct_fd));
-
-	if (!open_fds_addr || !fd) {
+	if (tf.status == TASK_FDS_EMPTY) {
                 if (ref && (ref->cmdflags & FILES_REF_FOUND))
                 	fprintf(fp, "\n");
-		if (fdtable_buf)
-			FREEBUF(fdtable_buf);
-		FREEBUF(files_struct_buf);
 		return;
 	}
 
@@ -2625,45 +2834,27 @@ open_files_dump(ulong task, int flags, struct reference *ref)
 	if (flags & PRINT_NRPAGES)
 		file_dump_flags |= DUMP_FILE_NRPAGES;
 
-	j = 0;
-	for (;;) {
-		unsigned long set;
-		i = j * __NFDBITS;
-		if (((max_fdset >= 0) && (i >= max_fdset)) || 
-		    (i >= max_fds))
-			 break;
-		set = open_fds.__fds_bits[j++];
-		while (set) {
-			if (set & 1) {
-        			readmem(fd + i*sizeof(struct file *), KVADDR, 
-					&file, sizeof(struct file *), 
-					"fd file", FAULT_ON_ERROR);
-
-				if (ref && file) {
-					open_tmpfile();
-                                        if (file_dump(file, 0, 0, i, file_dump_flags)) {
-						BZERO(buf4, BUFSIZE);
-						rewind(pc->tmpfile);
-						ret = fgets(buf4, BUFSIZE, 
-							pc->tmpfile);
-						close_tmpfile();
-						ref->refp = buf4;
-						if (open_file_reference(ref)) { 
-							PRINT_FILE_REFERENCE();
-						}
-					} else
-						close_tmpfile();
-				}
-				else if (file) {
-					if (!header_printed) {
-						fprintf(fp, "%s", files_header);
-						header_printed = 1;
-					}
-					file_dump(file, 0, 0, i, file_dump_flags);
+	for (i = 0; i < tf.count; i++) {
+		if (ref) {
+			open_tmpfile();
+			if (file_dump(tf.file[i], 0, 0, tf.fd[i], 
+			    file_dump_flags)) {
+				BZERO(buf4, BUFSIZE);
+				rewind(pc->tmpfile);
+				ret = fgets(buf4, BUFSIZE, pc->tmpfile);
+				close_tmpfile();
+				ref->refp = buf4;
+				if (open_file_reference(ref)) { 
+					PRINT_FILE_REFERENCE();
 				}
+			} else
+				close_tmpfile();
+		} else {
+			if (!header_printed) {
+				fprintf(fp, "%s", files_header);
+				header_printed = 1;
 			}
-			i++;
-			set >>= 1;
+			file_dump(tf.file[i], 0, 0, tf.fd[i], file_dump_flags);
 		}
 	}
 
@@ -2672,10 +2863,182 @@ open_files_dump(ulong task, int flags, struct reference *ref)
 
 	if (ref && (ref->cmdflags & FILES_REF_FOUND))
 		fprintf(fp, "\n");
+}
+
+/*
+ *  Gather the open file descriptors of a files_struct.  The open_fds
+ *  bitmap and the fd pointer array, up to the highest open descriptor,
+ *  are each read with a single readmem(), and the results are kept for
+ *  the rest of the command, so that the threads of a process, which 
+ *  share their files_struct, only cost one sweep.  The fd and file
+ *  arrays returned in the task_fds structure are only valid until the
+ *  next call.
+ */
+int
+get_task_fds(ulong files_struct_addr, struct task_fds *tf)
+{
+	struct fd_cache_entry *fe;
+	char *files_struct_buf, *fdtable_buf;
+	ulong fdtable_addr, open_fds_addr, fd, *open_fds, *files;
+	long max_fdset, max_fds, nbits, nlongs, top, i, len;
+	int h, e;
+	void *p;
+
+	BZERO(tf, sizeof(struct task_fds));
+	tf->files_struct = files_struct_addr;
+
+	if (!files_struct_addr)
+		return TASK_FDS_NONE;
+
+	if (ft->fd_cache.cmdgen != pc->cmdgencur) {
+		ft->fd_cache.cmdgen = pc->cmdgencur;
+		ft->fd_cache.entries = ft->fd_cache.fds = 0;
+		for (h = 0; h < FD_CACHE_HASH_SIZE; h++)
+			ft->fd_cache.head[h] = -1;
+	}
+
+	ft->fd_cache.lookups++;
+	h = FD_CACHE_HASH(files_struct_addr);
+	for (e = ft->fd_cache.head[h]; e >= 0; e = fe->next) {
+		fe = &ft->fd_cache.entry[e];
+		if (fe->files_struct == files_struct_addr) {
+			ft->fd_cache.hits++;
+			goto found;
+		}
+	}
+
+	if (ft->fd_cache.entries == ft->fd_cache.max_entries) {
+		len = ft->fd_cache.max_entries ? 
+			ft->fd_cache.max_entries * 2 : 256;
+		if (!(p = realloc(ft->fd_cache.entry, 
+		    len * sizeof(struct fd_cache_entry))))
+			error(FATAL, "cannot realloc fd cache\n");
+		ft->fd_cache.entry = p;
+		ft->fd_cache.max_entries = len;
+	}
+	e = ft->fd_cache.entries++;
+	fe = &ft->fd_cache.entry[e];
+	BZERO(fe, sizeof(struct fd_cache_entry));
+	fe->files_struct = files_struct_addr;
+	fe->first = ft->fd_cache.fds;
+	fe->status = TASK_FDS_NONE;
+
+	files_struct_buf = GETBUF(SIZE(files_struct));
+	fdtable_buf = VALID_STRUCT(fdtable) ? GETBUF(SIZE(fdtable)) : NULL;
+	open_fds = files = NULL;
+	max_fdset = max_fds = 0;
+	fdtable_addr = 0;
+
+	readmem(files_struct_addr, KVADDR, files_struct_buf,
+		SIZE(files_struct), "files_struct buffer", FAULT_ON_ERROR);
+
+	if (VALID_MEMBER(files_struct_max_fdset)) {
+		max_fdset = INT(files_struct_buf + OFFSET(files_struct_max_fdset));
+		max_fds = INT(files_struct_buf + OFFSET(files_struct_max_fds));
+	}
+
+	if (VALID_MEMBER(files_struct_fdt)) {
+		fdtable_addr = ULONG(files_struct_buf + OFFSET(files_struct_fdt));
+
+		if (fdtable_addr) {
+			readmem(fdtable_addr, KVADDR, fdtable_buf,
+	 			SIZE(fdtable), "fdtable buffer", FAULT_ON_ERROR); 
+			if (VALID_MEMBER(fdtable_max_fdset))
+				max_fdset = INT(fdtable_buf +
+					OFFSET(fdtable_max_fdset));
+			else
+				max_fdset = -1;
+			max_fds = INT(fdtable_buf + OFFSET(fdtable_max_fds));
+		}
+	}
+
+	if ((VALID_MEMBER(files_struct_fdt) && !fdtable_addr) || 
+	    (max_fdset == 0) || (max_fds <= 0))
+		goto done;
+
+	fe->max_fds = MAX(max_fdset, max_fds);
+	fe->status = TASK_FDS_EMPTY;
+
+	if (VALID_MEMBER(fdtable_open_fds))
+		open_fds_addr = ULONG(fdtable_buf + OFFSET(fdtable_open_fds));
+	else
+		open_fds_addr = ULONG(files_struct_buf + 
+			OFFSET(files_struct_open_fds));
+
+	if (VALID_MEMBER(fdtable_fd))
+		fd = ULONG(fdtable_buf + OFFSET(fdtable_fd));
+	else
+		fd = ULONG(files_struct_buf + OFFSET(files_struct_fd));
+
+	if (!open_fds_addr || !fd)
+		goto done;
+
+	fe->status = TASK_FDS_FOUND;
+
+	nbits = (max_fdset >= 0) ? MIN(max_fdset, max_fds) : max_fds;
+	nlongs = (nbits + BITS_PER_LONG - 1) / BITS_PER_LONG;
+	open_fds = (ulong *)GETBUF(nlongs * sizeof(ulong));
+
+	if (VALID_MEMBER(files_struct_open_fds_init) && 
+	    (open_fds_addr == (files_struct_addr + 
+	    OFFSET(files_struct_open_fds_init)))) {
+		len = MIN(nlongs * sizeof(ulong), 
+			SIZE(files_struct) - OFFSET(files_struct_open_fds_init));
+		BCOPY(files_struct_buf + OFFSET(files_struct_open_fds_init),
+			open_fds, len);
+	} else
+		readmem(open_fds_addr, KVADDR, open_fds, 
+			nlongs * sizeof(ulong), "fdtable open_fds", 
+			FAULT_ON_ERROR);
 
+	for (top = -1, i = 0; i < nbits; i++)
+		if (NUM_IN_BITMAP(open_fds, i))
+			top = i;
+	if (top < 0)
+		goto done;
+
+	files = (ulong *)GETBUF((top+1) * sizeof(ulong));
+	readmem(fd, KVADDR, files, (top+1) * sizeof(ulong), "fd file", 
+		FAULT_ON_ERROR);
+
+	for (i = 0; i <= top; i++) {
+		if (!NUM_IN_BITMAP(open_fds, i) || !files[i])
+			continue;
+		if (ft->fd_cache.fds == ft->fd_cache.max_fds) {
+			len = ft->fd_cache.max_fds ? 
+				ft->fd_cache.max_fds * 2 : 4096;
+			if (!(p = realloc(ft->fd_cache.fd, len * sizeof(int))))
+				error(FATAL, "cannot realloc fd cache\n");
+			ft->fd_cache.fd = p;
+			if (!(p = realloc(ft->fd_cache.file, len * sizeof(ulong))))
+				error(FATAL, "cannot realloc fd cache\n");
+			ft->fd_cache.file = p;
+			ft->fd_cache.max_fds = len;
+		}
+		ft->fd_cache.fd[ft->fd_cache.fds] = i;
+		ft->fd_cache.file[ft->fd_cache.fds] = files[i];
+		ft->fd_cache.fds++;
+		fe->count++;
+	}
+done:
+	if (files)
+		FREEBUF(files);
+	if (open_fds)
+		FREEBUF(open_fds);
 	if (fdtable_buf)
 		FREEBUF(fdtable_buf);
 	FREEBUF(files_struct_buf);
+
+	fe->next = ft->fd_cache.head[h];
+	ft->fd_cache.head[h] = e;
+found:
+	tf->status = fe->status;
+	tf->max_fds = fe->max_fds;
+	tf->count = fe->count;
+	tf->fd = ft->fd_cache.fd + fe->first;
+	tf->file = ft->fd_cache.file + fe->first;
+
+	return tf->status;
 }
 
 /*
@@ -3053,33 +3416,48 @@ get_pathname(ulong dentry, char *pathname, int length, int full, ulong vfsmnt)
 	int d_name_len = 0;
 	ulong d_name_name;
 	ulong tmp_vfsmnt, mnt_parent;
-	char *dentry_buf, *vfsmnt_buf, *mnt_buf;
+	char *dentry_buf, *vfsmnt_buf, *cached;
+	int i, depth, len, truncated;
+	struct {
+		ulong dentry;
+		int len;
+		int root;
+	} walk[PATH_CACHE_DEPTH];
 
 	BZERO(buf, BUFSIZE);
 	BZERO(tmpname, BUFSIZE);
 	BZERO(pathname, length);
-	if (VALID_STRUCT(mount)) {
-		if (VALID_MEMBER(mount_mnt_mountpoint)) {
-			mnt_buf = GETBUF(SIZE(mount));
-			vfsmnt_buf = mnt_buf + OFFSET(mount_mnt);
-		} else {
-			mnt_buf = NULL;
-			vfsmnt_buf = NULL;
-		}
-	} else {
-		mnt_buf = NULL;
-		vfsmnt_buf = VALID_MEMBER(vfsmount_mnt_mountpoint) ? 
-			GETBUF(SIZE(vfsmount)) : NULL;
+
+	if ((cached = path_cache_lookup(dentry, vfsmnt, full))) {
+		strncpy(pathname, cached, length-1);
+		return;
 	}
 
 	parent = dentry;
 	tmp_vfsmnt = vfsmnt;
+	depth = 0;
+	truncated = FALSE;
 
 	do {
 		tmp_dentry = parent;
 
 		dentry_buf = fill_dentry_cache(tmp_dentry);
 
+		parent = ULONG(dentry_buf + OFFSET(dentry_d_parent)); 
+
+		/*
+		 *  The remainder of the path of any ancestor other than a
+		 *  root dentry is that ancestor's own pathname.
+		 */
+		if ((tmp_dentry != dentry) && (tmp_dentry != parent) &&
+		    (cached = path_cache_lookup(tmp_dentry, tmp_vfsmnt, full)) &&
+		    ((strlen(cached) + strlen(pathname) + 1) < length)) {
+			strncpy(tmpname, pathname, BUFSIZE);
+			sprintf(pathname, "%s%s%s", cached,
+				STRNEQ(tmpname, "/") ? "" : "/", tmpname);
+			break;
+		}
+
 		d_name_len = INT(dentry_buf +
 			OFFSET(dentry_d_name) + OFFSET(qstr_len));
 
@@ -3107,22 +3485,25 @@ get_pathname(ulong dentry, char *pathname, int length, int full, ulong vfsmnt)
 					sprintf(pathname, 
 						"%s%s", buf, tmpname);
 				}
-			}
+			} else
+				truncated = TRUE;
 		} else {
 			strncpy(pathname, buf, BUFSIZE);
 		}
 
-		parent = ULONG(dentry_buf + OFFSET(dentry_d_parent)); 
-			
+		if (!truncated && (depth < PATH_CACHE_DEPTH)) {
+			walk[depth].dentry = tmp_dentry;
+			walk[depth].len = d_name_len;
+			walk[depth].root = (tmp_dentry == parent);
+			depth++;
+		}
+
 		if (tmp_dentry == parent && full) {
 			if (VALID_MEMBER(vfsmount_mnt_mountpoint)) {
 				if (tmp_vfsmnt) {
 					if (strncmp(pathname, "//", 2) == 0)
 						shift_string_left(pathname, 1);
-                                        readmem(tmp_vfsmnt, KVADDR, vfsmnt_buf,
-						SIZE(vfsmount), 
-						"vfsmount buffer", 
-						FAULT_ON_ERROR);
+					vfsmnt_buf = fill_mount_cache(tmp_vfsmnt);
         				parent = ULONG(vfsmnt_buf + 
 					    OFFSET(vfsmount_mnt_mountpoint));
         				mnt_parent = ULONG(vfsmnt_buf + 
@@ -3136,14 +3517,10 @@ get_pathname(ulong dentry, char *pathname, int length, int full, ulong vfsmnt)
 				if (tmp_vfsmnt) {
 					if (strncmp(pathname, "//", 2) == 0)
 						shift_string_left(pathname, 1);
-                                        readmem(tmp_vfsmnt - OFFSET(mount_mnt),
-						KVADDR, mnt_buf,
-						SIZE(mount), 
-						"mount buffer", 
-						FAULT_ON_ERROR);
-        				parent = ULONG(mnt_buf + 
+					vfsmnt_buf = fill_mount_cache(tmp_vfsmnt);
+        				parent = ULONG(vfsmnt_buf - OFFSET(mount_mnt) +
 					    OFFSET(mount_mnt_mountpoint));
-        				mnt_parent = ULONG(mnt_buf + 
+        				mnt_parent = ULONG(vfsmnt_buf - OFFSET(mount_mnt) +
 					    OFFSET(mount_mnt_parent));
 					if ((tmp_vfsmnt - OFFSET(mount_mnt)) == mnt_parent)
 						break;
@@ -3159,10 +3536,22 @@ get_pathname(ulong dentry, char *pathname, int length, int full, ulong vfsmnt)
 						
 	} while (tmp_dentry != parent && parent);
 
-	if (mnt_buf)
-		FREEBUF(mnt_buf);
-	else if (vfsmnt_buf)
-		FREEBUF(vfsmnt_buf);
+	/*
+	 *  Enter the pathname, and then peel off one trailing component
+	 *  at a time to enter the pathnames of the non-root ancestors 
+	 *  that were walked through, all of which are on the same mount.
+	 */
+	len = strlen(pathname);
+	path_cache_enter(dentry, vfsmnt, full, pathname, len);
+
+	for (i = 0; !truncated && ((i+1) < depth); i++) {
+		if (walk[i].root || walk[i+1].root)
+			break;
+		len -= walk[i].len + 1;
+		if ((len <= 0) || (pathname[len] != '/'))
+			break;
+		path_cache_enter(walk[i+1].dentry, vfsmnt, full, pathname, len);
+	}
 }
 
 /*
@@ -3190,35 +3579,78 @@ get_pathname_component(ulong dentry,
 	return len;
 }
 
+static void
+fs_cache_init(struct fs_cache *fc, char *name, long size)
+{
+	fc->name = name;
+	fc->size = size;
+	if (!(fc->buf = (char *)malloc(size * FS_CACHE_ENTRIES)))
+		error(FATAL, "cannot malloc %s cache\n", name);
+}
+
 /*
- *  Cache the passed-in file structure.
+ *  Return the cached copy of the structure at addr, reading it into the
+ *  oldest slot if it is not cached.
  */
-char *
-fill_file_cache(ulong file)
+static char *
+fs_cache_fill(struct fs_cache *fc, ulong addr)
 {
-        int i;
-        char *cache;
+	int slot, *sp;
+	char *cache;
 
-        ft->file_cache_fills++;
+	fc->fills++;
 
-        for (i = 0; i < DENTRY_CACHE; i++) {
-                if (ft->cached_file[i] == file) {
-                        ft->cached_file_hits[i]++;
-                        cache = ft->file_cache + (SIZE(file)*i);
-                        return(cache);
-                }
-        }
+	for (slot = fc->head[FS_CACHE_HASH(addr)]; slot; 
+	     slot = fc->next[slot-1]) {
+		if (fc->cached[slot-1] == addr) {
+			fc->hits++;
+			return(fc->buf + (fc->size * (slot-1)));
+		}
+	}
+
+	slot = fc->index;
+
+	if (fc->cached[slot]) {
+		for (sp = &fc->head[FS_CACHE_HASH(fc->cached[slot])]; *sp; 
+		     sp = &fc->next[*sp-1]) {
+			if (*sp == (slot+1)) {
+				*sp = fc->next[slot];
+				break;
+			}
+		}
+		fc->cached[slot] = 0;
+	}
 
-        cache = ft->file_cache + (SIZE(file)*ft->file_cache_index);
+	cache = fc->buf + (fc->size * slot);
 
-        readmem(file, KVADDR, cache, SIZE(file),
-                "fill_file_cache", FAULT_ON_ERROR);
+	readmem(addr, KVADDR, cache, fc->size, fc->name, FAULT_ON_ERROR);
 
-        ft->cached_file[ft->file_cache_index] = file;
+	fc->cached[slot] = addr;
+	fc->next[slot] = fc->head[FS_CACHE_HASH(addr)];
+	fc->head[FS_CACHE_HASH(addr)] = slot+1;
 
-        ft->file_cache_index = (ft->file_cache_index+1) % DENTRY_CACHE;
+	fc->index = (slot+1) % FS_CACHE_ENTRIES;
 
-        return(cache);
+	return(cache);
+}
+
+static void
+fs_cache_clear(struct fs_cache *fc)
+{
+	BZERO(fc->cached, sizeof(fc->cached));
+	BZERO(fc->next, sizeof(fc->next));
+	BZERO(fc->head, sizeof(fc->head));
+	fc->fills = fc->hits = 0;
+	fc->index = 0;
+}
+
+/*
+ *  Cache the passed-in file structure.
+ */
+char *
+fill_file_cache(ulong file)
+{
+	return fs_cache_fill(&ft->file_cache, file);
 }
 
 /*
@@ -3227,51 +3659,20 @@ fill_file_cache(ulong file)
 void
 clear_file_cache(void)
 {
-        int i;
-
         if (DUMPFILE())
                 return;
 
-        for (i = 0; i < DENTRY_CACHE; i++) {
-                ft->cached_file[i] = 0;
-                ft->cached_file_hits[i] = 0;
-        }
-
-        ft->file_cache_fills = 0;
-        ft->file_cache_index = 0;
+	fs_cache_clear(&ft->file_cache);
+	fs_cache_clear(&ft->mount_cache);
 }
 
-
-
 /*
  *  Cache the passed-in dentry structure.
  */
 char *
 fill_dentry_cache(ulong dentry)
 {
-	int i;
-	char *cache;
-
-	ft->dentry_cache_fills++;
-
-        for (i = 0; i < DENTRY_CACHE; i++) {
-                if (ft->cached_dentry[i] == dentry) {
-			ft->cached_dentry_hits[i]++;
-			cache = ft->dentry_cache + (SIZE(dentry)*i);
-			return(cache);
-		}
-	}
-
-	cache = ft->dentry_cache + (SIZE(dentry)*ft->dentry_cache_index);
-
-        readmem(dentry, KVADDR, cache, SIZE(dentry),
-        	"fill_dentry_cache", FAULT_ON_ERROR);
-
-	ft->cached_dentry[ft->dentry_cache_index] = dentry;
-
-	ft->dentry_cache_index = (ft->dentry_cache_index+1) % DENTRY_CACHE;
-
-	return(cache);
+	return fs_cache_fill(&ft->dentry_cache, dentry);
 }
 
 /*
@@ -3280,18 +3681,11 @@ fill_dentry_cache(ulong dentry)
 void
 clear_dentry_cache(void)
 {
-	int i;
-
 	if (DUMPFILE())
 		return;
 
-        for (i = 0; i < DENTRY_CACHE; i++) {
-                ft->cached_dentry[i] = 0;
-        	ft->cached_dentry_hits[i] = 0;
-	}
-
-        ft->dentry_cache_fills = 0;
-	ft->dentry_cache_index = 0;
+	fs_cache_clear(&ft->dentry_cache);
+	clear_path_cache();
 }
 
 /*
@@ -3300,29 +3694,7 @@ clear_dentry_cache(void)
 char *
 fill_inode_cache(ulong inode)
 {
-        int i;
-        char *cache;
-
-        ft->inode_cache_fills++;
-
-        for (i = 0; i < INODE_CACHE; i++) {
-                if (ft->cached_inode[i] == inode) {
-                        ft->cached_inode_hits[i]++;
-                        cache = ft->inode_cache + (SIZE(inode)*i);
-                        return(cache);
-                }
-        }
-
-        cache = ft->inode_cache + (SIZE(inode)*ft->inode_cache_index);
-
-        readmem(inode, KVADDR, cache, SIZE(inode),
-                "fill_inode_cache", FAULT_ON_ERROR);
-
-        ft->cached_inode[ft->inode_cache_index] = inode;
-
-        ft->inode_cache_index = (ft->inode_cache_index+1) % INODE_CACHE;
-
-        return(cache);
+	return fs_cache_fill(&ft->inode_cache, inode);
 }
 
 /*      
@@ -3331,18 +3703,75 @@ fill_inode_cache(ulong inode)
 void
 clear_inode_cache(void)
 {
-        int i; 
- 
         if (DUMPFILE())
                 return;
  
-        for (i = 0; i < DENTRY_CACHE; i++) {
-                ft->cached_inode[i] = 0;
-                ft->cached_inode_hits[i] = 0;
-        }
+	fs_cache_clear(&ft->inode_cache);
+}
 
-        ft->inode_cache_fills = 0;
-        ft->inode_cache_index = 0;
+/*
+ *  Cache the mount structure containing the passed-in vfsmount, or the
+ *  vfsmount itself on kernels without a separate mount structure; the 
+ *  returned buffer points to the vfsmount in either case.
+ */
+static char *
+fill_mount_cache(ulong vfsmnt)
+{
+	if (VALID_STRUCT(mount))
+		return fs_cache_fill(&ft->mount_cache, 
+			vfsmnt - OFFSET(mount_mnt)) + OFFSET(mount_mnt);
+	else
+		return fs_cache_fill(&ft->mount_cache, vfsmnt);
+}
+
+static char *
+path_cache_lookup(ulong dentry, ulong vfsmnt, int full)
+{
+	struct path_cache_entry *pce;
+
+	ft->path_cache_lookups++;
+
+	pce = &ft->path_cache[PATH_CACHE_HASH(dentry, vfsmnt)];
+	if (pce->pathname && (pce->dentry == dentry) && 
+	    (pce->vfsmnt == vfsmnt) && (pce->full == full)) {
+		ft->path_cache_hits++;
+		return pce->pathname;
+	}
+
+	return NULL;
+}
+
+static void
+path_cache_enter(ulong dentry, ulong vfsmnt, int full, char *pathname, int len)
+{
+	struct path_cache_entry *pce;
+
+	pce = &ft->path_cache[PATH_CACHE_HASH(dentry, vfsmnt)];
+	if (pce->pathname)
+		free(pce->pathname);
+	if (!(pce->pathname = (char *)malloc(len+1)))
+		return;
+
+	strncpy(pce->pathname, pathname, len);
+	pce->pathname[len] = NULLCHAR;
+	pce->dentry = dentry;
+	pce->vfsmnt = vfsmnt;
+	pce->full = full;
+}
+
+static void
+clear_path_cache(void)
+{
+	int i;
+
+	for (i = 0; i < PATH_CACHE_ENTRIES; i++) {
+		if (ft->path_cache[i].pathname) {
+			free(ft->path_cache[i].pathname);
+			ft->path_cache[i].pathname = NULL;
+		}
+	}
+
+	ft->path_cache_lookups = ft->path_cache_hits = 0;
 }
 
 
@@ -3388,6 +3817,19 @@ cmd_fuser(void)
 	sprintf(fuser_header, " PID   %s  COMM             USAGE\n",
 		mkstring(buf, VADDR_PRLEN, CENTER, "TASK"));
 
+	/*
+	 *  Gather the files and vm data of all tasks once, and then
+	 *  search it for each of the arguments.
+	 */
+	open_tmpfile();
+	BZERO(&foreach_data, sizeof(struct foreach_data));
+	fd = &foreach_data;
+	fd->keyword_array[0] = FOREACH_FILES;
+	fd->keyword_array[1] = FOREACH_VM;
+	fd->keys = 2;
+	fd->flags |= FOREACH_i_FLAG;
+	foreach(fd);
+
 	doing_fds = doing_mmap = 0;
 	while (args[optind]) {
                 spec_string = args[optind];
@@ -3396,14 +3838,6 @@ cmd_fuser(void)
 		len = strlen(spec_string);
 		fuser_header_printed = 0;
 		lockd_header_printed = 0;
-		open_tmpfile();
-		BZERO(&foreach_data, sizeof(struct foreach_data));
-		fd = &foreach_data;
-		fd->keyword_array[0] = FOREACH_FILES;
-		fd->keyword_array[1] = FOREACH_VM;
-		fd->keys = 2;
-		fd->flags |= FOREACH_i_FLAG;
-		foreach(fd);
 		rewind(pc->tmpfile);
 		BZERO(uses, 20);
 		while (fgets(buf, BUFSIZE, pc->tmpfile)) {
@@ -3473,12 +3907,13 @@ cmd_fuser(void)
 			show_fuser(task_buf, uses);
 			BZERO(uses, 20);
 		}
-		close_tmpfile();
 		optind++;
 		if (!fuser_header_printed && !lockd_header_printed) {
-			fprintf(fp, "No users of %s found\n", spec_string);
+			fprintf(pc->saved_fp, "No users of %s found\n", 
+				spec_string);
 		}
 	}
+	close_tmpfile();
 }
 
 static void
@@ -3978,6 +4413,22 @@ ulong RADIX_TREE_MAP_SHIFT = UNINITIALIZED;
 ulong RADIX_TREE_MAP_SIZE = UNINITIALIZED;
 ulong RADIX_TREE_MAP_MASK = UNINITIALIZED;
 
+/*
+ *  State of a do_radix_tree() walk.  The walk reads each radix_tree_node's
+ *  slots[] array with a single readmem() into the buffer for its height,
+ *  and only descends through the non-empty slots, so that the cost is
+ *  proportional to the number of populated nodes rather than to the
+ *  tree's maximum index.
+ */
+struct radix_tree_walk {
+	int flag;
+	ulong count;
+	ulong maxcount;
+	ulong *slots;
+	struct radix_tree_pair *rtp;
+	int (*cb)(ulong);
+};
+
 /*
  *  do_radix_tree argument usage: 
  *
@@ -4012,13 +4463,12 @@ do_radix_tree(ulong root, int flag, struct radix_tree_pair *rtp)
 {
 	int i, ilen, height; 
 	long nlen;
-	ulong index, maxindex, count, maxcount;
+	ulong maxindex, count;
 	long *height_to_maxindex;
 	char *radix_tree_root_buf;
-	struct radix_tree_pair *r;
-	ulong root_rnode;
+	ulong root_rnode, rnode;
 	void *ret;
-	int (*cb)(ulong) = NULL;
+	struct radix_tree_walk walk;
 
 	count = 0;
 
@@ -4077,13 +4527,6 @@ do_radix_tree(ulong root, int flag, struct radix_tree_pair *rtp)
 
 	switch (flag)
 	{
-	case RADIX_TREE_COUNT:
-		for (index = count = 0; index <= maxindex; index++) {
-			if (radix_tree_lookup(root_rnode, index, height))
-				count++;
-		}
-		break;
-
 	case RADIX_TREE_SEARCH:
 		count = 0;
 		if (rtp->index > maxindex) 
@@ -4095,51 +4538,45 @@ do_radix_tree(ulong root, int flag, struct radix_tree_pair *rtp)
 		}
 		break;
 
+	case RADIX_TREE_COUNT:
 	case RADIX_TREE_DUMP:
-		for (index = count = 0; index <= maxindex; index++) {
-			if ((ret = 
-			    radix_tree_lookup(root_rnode, index, height))) {
-				fprintf(fp, "[%ld] %lx\n", index, (ulong)ret);
-				count++;
-			}
-		}
-		break;
-
 	case RADIX_TREE_GATHER:
-		if (!(maxcount = rtp->index))
-			maxcount = (ulong)(-1);   /* caller beware */
-
-                for (index = count = 0, r = rtp; index <= maxindex; index++) {
-                        if ((ret = 
-			    radix_tree_lookup(root_rnode, index, height))) {
-				r->index = index;
-				r->value = ret;
-				count++;
-                                if (--maxcount <= 0)
-					break;
-				r++;
-                        }
-                }
-		break;
-
 	case RADIX_TREE_DUMP_CB:
-		if (rtp->value == NULL) {
-			error(FATAL, "do_radix_tree: need set callback function");
-			return -EINVAL;
+		BZERO(&walk, sizeof(struct radix_tree_walk));
+		walk.flag = flag;
+		walk.rtp = rtp;
+
+		if (flag == RADIX_TREE_GATHER) {
+			if (!(walk.maxcount = rtp->index))
+				walk.maxcount = (ulong)(-1);   /* caller beware */
 		}
-		cb = (int (*)(ulong))rtp->value;
-		for (index = count = 0; index <= maxindex; index++) {
-			if ((ret =
-			    radix_tree_lookup(root_rnode, index, height))) {
-				/* Caller defined operation */
-				if (!cb((ulong)ret)) {
-					error(FATAL, "do_radix_tree: callback "
-					    "operation failed: entry: %ld  item: %lx\n",
-					    count, (ulong)ret);
-				}
-				count++;
+
+		if (flag == RADIX_TREE_DUMP_CB) {
+			if (rtp->value == NULL) {
+				error(FATAL, 
+				    "do_radix_tree: need set callback function");
+				return -EINVAL;
 			}
+			walk.cb = (int (*)(ulong))rtp->value;
 		}
+
+		readmem(root_rnode, KVADDR, &rnode, sizeof(void *),
+			"radix_tree_root rnode", FAULT_ON_ERROR);
+		if (rnode & 1)
+			rnode &= ~1;
+
+		if (!rnode)
+			break;
+
+		if (height == 0) {
+			radix_tree_walk_entry(&walk, 0, rnode);
+		} else {
+			walk.slots = (ulong *)GETBUF(sizeof(void *) * 
+				RADIX_TREE_MAP_SIZE * height);
+			radix_tree_walk(rnode, 0, height, &walk);
+			FREEBUF(walk.slots);
+		}
+		count = walk.count;
 		break;
 
 	default:
@@ -4149,6 +4586,76 @@ do_radix_tree(ulong root, int flag, struct radix_tree_pair *rtp)
 	return count;
 }
 
+/*
+ *  Walk the subtree at node, whose first index is index; the entries 
+ *  are visited in ascending index order.  Returns FALSE if the walk
+ *  should be terminated.
+ */
+static int
+radix_tree_walk(ulong node, ulong index, int height, struct radix_tree_walk *w)
+{
+	int i;
+	uint shift;
+	ulong *slots;
+
+	shift = (height-1) * RADIX_TREE_MAP_SHIFT;
+	slots = w->slots + ((height-1) * RADIX_TREE_MAP_SIZE);
+
+	readmem(node+OFFSET(radix_tree_node_slots), KVADDR, 
+		&slots[0], sizeof(void *) * RADIX_TREE_MAP_SIZE,
+		"radix_tree_node.slots array", FAULT_ON_ERROR);
+
+	for (i = 0; i < RADIX_TREE_MAP_SIZE; i++) {
+		if (!slots[i])
+			continue;
+
+		if (height > 1) {
+			if (!radix_tree_walk(slots[i], 
+			    index | ((ulong)i << shift), height-1, w))
+				return FALSE;
+		} else if (!radix_tree_walk_entry(w, index | i, slots[i]))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static int
+radix_tree_walk_entry(struct radix_tree_walk *w, ulong index, ulong item)
+{
+	struct radix_tree_pair *r;
+
+	switch (w->flag)
+	{
+	case RADIX_TREE_DUMP:
+		fprintf(fp, "[%ld] %lx\n", index, item);
+		break;
+
+	case RADIX_TREE_GATHER:
+		r = w->rtp + w->count;
+		r->index = index;
+		r->value = (void *)item;
+		if (--w->maxcount <= 0) {
+			w->count++;
+			return FALSE;
+		}
+		break;
+
+	case RADIX_TREE_DUMP_CB:
+		/* Caller defined operation */
+		if (!w->cb(item)) {
+			error(FATAL, "do_radix_tree: callback "
+			    "operation failed: entry: %ld  item: %lx\n",
+			    w->count, item);
+		}
+		break;
+	}
+
+	w->count++;
+
+	return TRUE;
+}
+
 static void *
 radix_tree_lookup(ulong root_rnode, ulong index, int height)
 {
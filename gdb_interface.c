@@ -46,17 +46,17 @@ gdb_main_loop(int argc, char **argv)
 		if (pc->flags & READNOW)
 			argv[argc++] = "--readnow";
 		argv[argc++] = "--quiet";
-		argv[argc++] = pc->namelist_debug ? 
+		argv[argc++] = index_cache_file(pc->namelist_debug ? 
 			pc->namelist_debug : 
 			(pc->debuginfo_file && (st->flags & CRC_MATCHES) ?
-			pc->debuginfo_file : pc->namelist);
+			pc->debuginfo_file : pc->namelist));
 	} else {
 		if (pc->flags & READNOW)
 			argv[argc++] = "--readnow";
-		argv[argc++] = pc->namelist_debug ? 
+		argv[argc++] = index_cache_file(pc->namelist_debug ? 
 			pc->namelist_debug : 
 			(pc->debuginfo_file && (st->flags & CRC_MATCHES) ?
-			pc->debuginfo_file : pc->namelist);
+			pc->debuginfo_file : pc->namelist));
 	}
 
 	if (CRASHDEBUG(1)) {
@@ -305,6 +305,7 @@ retry:
 	} else if (!(pc->flags & SILENT))
 		fprintf(fp, "\n");
 
+	index_cache_update();
 
 	FREEBUF(req->buf);
 	FREEBUF(req);
@@ -74,6 +74,7 @@ struct command_table_entry linux_command_table[] = {
         {"ascii",   cmd_ascii,   help_ascii,   0},
         {"bt",      cmd_bt,      help_bt,      REFRESH_TASK_TABLE},
 	{"btop",    cmd_btop,    help_btop,    0},
+	{"copydump", cmd_copydump, help_copydump, 0},
 	{"dev",     cmd_dev,     help_dev,     0},
 	{"dis",     cmd_dis,     help_dis,     MINIMAL},
 	{"eval",    cmd_eval,    help_eval,    MINIMAL},
@@ -112,7 +113,7 @@ struct command_table_entry linux_command_table[] = {
         {"sym",     cmd_sym,     help_sym,     MINIMAL},
         {"sys",     cmd_sys,     help_sys,     REFRESH_TASK_TABLE},
         {"task",    cmd_task,    help_task,    REFRESH_TASK_TABLE},
-	{"test",    cmd_test,    NULL,         HIDDEN_COMMAND},
+	{"test",    cmd_test,    help_test,    HIDDEN_COMMAND},
         {"timer",   cmd_timer,   help_timer,   0},
 	{"union",   cmd_union,   help_union,   0},
 	{"vm",      cmd_vm,      help_vm,      REFRESH_TASK_TABLE},
@@ -49,6 +49,7 @@ char *program_usage_info[] = {
     "",
     "  crash [OPTION]... NAMELIST MEMORY-IMAGE[@ADDRESS]	(dumpfile form)",
     "  crash [OPTION]... [NAMELIST]             		(live system form)",
+    "  crash [OPTION]... --batch listfile -i file NAMELIST	(batch form)",
     "",
     "OPTIONS:",
     "",
@@ -237,6 +238,15 @@ char *program_usage_info[] = {
     "    from the NAMELIST.  If module symbol tables are loaded during",
     "    runtime with the \"mod\" command, the same override will occur.",
     "",
+    "  --index_cache directory",
+    "    Keep a cache of debuginfo files with a gdb index in directory, keyed",
+    "    by the build-id of each file.  The first time that a NAMELIST or",
+    "    module object file without an index is loaded, an indexed copy is",
+    "    saved in directory using objcopy(1); in later sessions, the indexed",
+    "    copy is loaded instead, so that the embedded gdb module only reads",
+    "    the debug data of each compilation unit when it is first needed.",
+    "    This has no effect if the --readnow option or \"mod -r\" is used.",
+    "",
     "  --smp  ",
     "    Specify that the system being analyzed is an SMP kernel.",
     "",
@@ -345,6 +355,22 @@ char *program_usage_info[] = {
     "    Show or hide command output that is associated with offline cpus,",
     "    overriding any settings in either ./.crashrc or $HOME/.crashrc.",
     "",
+    "  --batch listfile [--batch_jobs count] [--batch_dir directory]",
+    "    Run a separate non-interactive session for each of the dumpfiles",
+    "    named in listfile, one per line, or read from stdin if listfile",
+    "    is \"-\".  Each session is given the same NAMELIST and options, and",
+    "    must be given an -i input file of commands to run.  Up to count",
+    "    sessions run concurrently, by default one per online cpu.  The",
+    "    output of each session is written to a file in directory, by",
+    "    default the current directory, whose name is derived from the",
+    "    dumpfile pathname.  The exit status and elapsed time of each",
+    "    session are displayed when all of them have completed.",
+    "",
+    "  --test \"arguments\"",
+    "    Run the \"test\" command with the quoted arguments to generate and",
+    "    benchmark synthetic dumpfiles without a NAMELIST or dumpfile, and",
+    "    then exit.  See \"help test\" from within a session.",
+    "",
     "FILES:",
     "",
     "  .crashrc",
@@ -375,6 +401,10 @@ char *program_usage_info[] = {
     "    Specifies a directory containing extension modules that will be",
     "    loaded automatically if the -x command line option is used.",
     "",
+    "  CRASH_INDEX_CACHE",
+    "    Specifies an index cache directory if the --index_cache command line",
+    "    option is not used.",
+    "",
     NULL
 };
 
@@ -537,6 +567,8 @@ cmd_help(void)
 
 		case 'x':
 			dump_text_value_cache(VERBOSE);
+			dump_vmlinux_text();
+			dump_disasm_cache();
 			return;
 
 		case 'd':
@@ -625,7 +657,7 @@ cmd_help(void)
 		case 'z':
 			fprintf(fp, "help options:\n");
 			fprintf(fp, " -a - alias data\n");
-			fprintf(fp, " -b - shared buffer data\n");
+			fprintf(fp, " -b - shared buffer and arena data\n");
 			fprintf(fp, " -B - build data\n");
 			fprintf(fp, " -c - numargs cache\n");
 			fprintf(fp, " -d - device table\n");
@@ -978,7 +1010,7 @@ char *help_help[] = {
 "  data is available with the following options:",
 " ",
 "    -a - alias data",
-"    -b - shared buffer data",
+"    -b - shared buffer and arena data",
 "    -B - build data",
 "    -c - numargs cache",
 "    -d - device table",
@@ -1063,6 +1095,21 @@ char *help_set[] = {
 "                               value.",
 "         offline  show | hide  Show or hide command output that is associated",
 "                               with offline cpus.",
+"      live_cache  on | off | frozen",
+"                               on a live system, memory pages that are read",
+"                               are cached until the command completes (on),",
+"                               not cached at all (off), or kept cached across",
+"                               commands until the setting is changed (frozen).",
+"    vmlinux_text  on | off | verify",
+"                               if on, reads of kernel .text and .rodata are",
+"                               served from the vmlinux file once each page",
+"                               has been compared against memory; pages that",
+"                               were patched at runtime by alternatives, jump",
+"                               labels, ftrace or paravirt are read from",
+"                               memory.  If verify, every page is compared",
+"                               up front.  On a live system, the comparisons",
+"                               are repeated in each command, since the text",
+"                               may be re-patched at any time.",
 " ",
 "  Internal variables may be set in four manners:\n",
 "    1. entering the set command in $HOME/.%src.",
@@ -1112,6 +1159,8 @@ char *help_set[] = {
 "               gdb: off",
 "             scope: (not set)",
 "           offline: show",
+"        live_cache: on",
+"      vmlinux_text: off",
 " ",
 "  Show the current context:\n",
 "    %s> set",
@@ -2074,6 +2123,34 @@ char *help_btop[] = {
 NULL               
 };
 
+char *help_copydump[] = {
+"copydump",
+"copy the dumpfile into a compressed kdump dumpfile",
+"[-l | -s | -z] outputfile",
+"  This command copies the physical memory of the current dumpfile, whatever",
+"  its format, into a new compressed kdump dumpfile, which can subsequently",
+"  be used in place of the original.  Compressed kdump dumpfiles have a",
+"  per-page index, and so are quick to access randomly, whereas some other",
+"  dumpfile formats can only be read efficiently in sequential order.",
+"",
+"  Pages that are excluded from the current dumpfile remain excluded, and",
+"  pages that are filled with zeroes share a single copy of page data.  The",
+"  ELF notes, including the VMCOREINFO data, are copied from ELF and",
+"  compressed kdump dumpfiles.  By default the pages are compressed with",
+"  zlib; if crash has been built with the relevant library, this option may",
+"  be used to select a different compression method:\n",
+"         -l  compress the pages with LZO.",
+"         -s  compress the pages with snappy.",
+"         -z  compress the pages with zstd.",
+"  outputfile  the name of the new dumpfile, which must not already exist.",
+"\nEXAMPLES",
+"  Copy an ELF vmcore into a compressed kdump dumpfile:\n",
+"    %s> copydump /var/crash/vmcore.kdump",
+"    /var/crash/vmcore.kdump: 2031127 pages (1402322 compressed, 628805 zero, 0 excluded)",
+"                              page data: 2183254016 bytes",
+NULL               
+};
+
 char *help_extend[] = {
 "extend",
 "extend the %s command set",  
@@ -2329,6 +2406,54 @@ char *help_map[] = {
 NULL
 };
 
+char *help_test[] = {
+"test",
+"benchmark and regression harness",
+"[-g dumpfile [-f elf|kdump] [-m megabytes] [-c zlib|none] [-s percent]]\n        [-b] [-k] [-n count] [dumpfile ...]",
+"  This command generates synthetic dumpfiles, and measures the throughput",
+"  and latency of the dumpfile backends and of the memory access paths",
+"  built on top of them.  It is not advertised in the help menu.\n",
+"    -g dumpfile  Generate a synthetic dumpfile.  Each page begins with its",
+"                 own physical address, which is verified when the dumpfile",
+"                 is read back with -b.",
+"     -f format  The synthetic dumpfile format, either \"elf\" for an ELF kdump",
+"                 or \"kdump\" for a compressed kdump (default).",
+"  -m megabytes  The physical memory size of the synthetic dumpfile; the",
+"                 default is 64.",
+"   -c compress  The page compression of a compressed kdump, either \"zlib\"",
+"                 (default) or \"none\".",
+"    -s percent  The percentage of physical memory that is excluded from the",
+"                 synthetic dumpfile, in runs of at least 512 pages.",
+"            -b  Benchmark sequential, random, and random 64-byte reads of the",
+"                 dumpfile generated with -g and/or of each dumpfile argument,",
+"                 using the ELF or compressed kdump backend directly.  Each",
+"                 dumpfile is read in a child process, so the current session",
+"                 is not affected.",
+"            -k  Benchmark readmem(), kvtop(), value_search(), hq_enter(),",
+"                 do_list() and the search command against the kernel text",
+"                 and task list of the current session.",
+"      -n count  The number of random operations of each type; the default",
+"                 is 10000.",
+"\n  For each test, the number of operations, megabytes read, elapsed",
+"  seconds, throughput, average and maximum latency in microseconds, the",
+"  number of failed or excluded reads, and the number of pages whose",
+"  contents did not match their physical address are displayed.  The -g",
+"  and -b options may also be run without a kernel session by entering",
+"  \"crash --test '<arguments>'\".",
+"\nEXAMPLES",
+"  Generate a 1GB compressed kdump with 25%% of its memory excluded, and",
+"  benchmark its backend:\n",
+"    %s> test -g /tmp/vmcore.kdump -m 1024 -s 25 -b",
+"\n  Generate an uncompressed kdump and an ELF kdump of the same size, and",
+"  benchmark both backends with 100000 random reads each:\n",
+"    %s> test -g /tmp/vmcore.raw -c none",
+"    %s> test -g /tmp/vmcore.elf -f elf",
+"    %s> test -b -n 100000 /tmp/vmcore.raw /tmp/vmcore.elf",
+"\n  Benchmark the memory access paths of the current session:\n",
+"    %s> test -k",
+NULL
+};
+
 char *help_timer[] = {
 "timer",
 "timer queue data",
@@ -5024,7 +5149,7 @@ NULL
 char *help__list[] = {
 "list",
 "linked list",
-"[[-o] offset][-e end][-s struct[.member[,member]] -[xd]] [-r|-h|-H] start",
+"[[-o] offset][-e end][-[s|S] struct[.member[,member]] -[xd]] [-r|-h|-H] [-B] [-c]\n       start",
 "  This command dumps the contents of a linked list.  The entries in a linked",
 "  list are typically data structures that are tied together in one of two",
 "  formats:",
@@ -5097,11 +5222,23 @@ char *help__list[] = {
 "               \"struct.member.member\" or \"struct.member[index]\"; embedded",
 "               member specifications may extend beyond one level deep by ",
 "               expressing the argument as \"struct.member.member.member...\".",
+"    -S struct  Similar to -s, but the structure type and member offsets are",
+"               looked up only once, and each structure in the list is read",
+"               from memory with a single read.  Members that are 1, 2, 4 or",
+"               8-byte integers or pointers are displayed directly from that",
+"               buffer, which is much faster than -s on long lists; integers",
+"               are displayed as unsigned values, and all other member types",
+"               are formatted by gdb as with -s.",
 "           -x  Override the default output format with hexadecimal format.",
 "           -d  Override the default output format with decimal format.",
 "           -r  For a list linked with list_head structures, traverse the list",
 "               in the reverse order by using the \"prev\" pointer instead",
 "               of \"next\".",
+"           -B  Use Brent's algorithm to detect a loop in the list instead of",
+"               hashing each entry.  This requires no memory for very long",
+"               lists, but a looping list may be displayed for a few laps",
+"               before the duplicate entry is reported.",
+"           -c  Only display the number of entries in the list.",
 " ",
 "  The meaning of the \"start\" argument, which can be expressed symbolically,",
 "  in hexadecimal format, or an expression evaluating to an address, depends",
@@ -5350,7 +5487,7 @@ NULL
 char *help_tree[] = {
 "tree",
 "display radix tree or red-black tree",
-"-t [radix|rbtree] [-r offset] [-s struct[.member[,member]] -[x|d]]\n          [-o offset] [-p] [-N] start",
+"-t [radix|rbtree] [-r offset] [-[s|S] struct[.member[,member]] -[x|d]]\n          [-o offset] [-p] [-N] [-c] start",
 "  This command dumps the contents of a radix tree or a red-black tree.",
 "  The arguments are as follows:\n",
 "    -t type  The type of tree to dump; the type string can be either ",
@@ -5380,8 +5517,15 @@ char *help_tree[] = {
 "             or \"struct.member[index]\"; embedded member specifications may",
 "             extend beyond one level deep by expressing the struct argument as", 
 "             \"struct.member.member.member...\".",
+"  -S struct  Similar to -s, but the structure type and member offsets are",
+"             looked up only once, and each entry is read from memory with a",
+"             single read.  Members that are 1, 2, 4 or 8-byte integers or",
+"             pointers are displayed directly from that buffer; integers are",
+"             displayed as unsigned values, and all other member types are",
+"             formatted by gdb as with -s.",
 "         -x  Override default output format with hexadecimal format.",
 "         -d  Override default output format with decimal format.",
+"         -c  Only display the number of entries in the tree.",
 "         -p  Display the node's position information, showing the relationship",
 "             between it and the root.  For red-black trees, a position that",
 "             indicates \"root/l/r\" means that the node is the right child",
@@ -8256,8 +8400,9 @@ README_ENTER_DIRECTORY,
 "  Traditionally when vmcores are compressed via the makedumpfile(8) facility",
 "  the libz compression library is used, and by default the crash utility",
 "  only supports libz.  Recently makedumpfile has been enhanced to optionally",
-"  use either the LZO or snappy compression libraries.  To build crash with",
-"  either or both of those libraries, type \"make lzo\" or \"make snappy\".",
+"  use either the LZO, snappy or zstd compression libraries.  To build crash",
+"  with any or all of those libraries, type \"make lzo\", \"make snappy\" or",
+"  \"make zstd\".",
 "",
 "  All of the alternate build commands above are \"sticky\" in that the",
 "  special \"make\" targets only have to be entered one time; all subsequent",
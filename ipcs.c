@@ -73,6 +73,25 @@ struct ipcs_table {
 	int seq_multiplier;
 };
 
+struct ipc_search {
+	int (*fn)(ulong, int, ulong, int, int);
+	int specified;
+	ulong specified_value;
+	int verbose;
+	int in_use;
+	int total;
+	int found;
+};
+
+struct idr_walk {
+	int (*fn)(int, ulong, void *);
+	void *arg;
+	int slots;
+	int count;
+	int done;
+	ulong *ary;
+};
+
 /*
  * function declaration
  */
@@ -83,7 +102,8 @@ static int dump_semaphore_arrays(int, ulong, int, ulong);
 static int dump_message_queues(int, ulong, int, ulong);
 static int ipc_search_idr(ulong, int, ulong, int (*)(ulong, int, ulong, int, int), int);
 static int ipc_search_array(ulong, int, ulong, int (*)(ulong, int, ulong, int, int), int);
-static ulong idr_find(ulong, int);
+static int ipc_search_idr_entry(int, ulong, void *);
+static void idr_walk_layer(struct idr_walk *, ulong, int, ulong, ulong *);
 static int dump_shm_info(ulong, int, ulong, int, int);
 static int dump_sem_info(ulong, int, ulong, int, int);
 static int dump_msg_info(ulong, int, ulong, int, int);
@@ -576,9 +596,8 @@ ipc_search_idr(ulong ipc_ids_p, int specified, ulong specified_value, int (*fn)(
 {
 	int in_use;
 	ulong ipcs_idr_p;
-	ulong ipc;
-	int next_id, total;
-	int found = 0;
+	struct ipc_search is;
+	int found;
 
 	readmem(ipc_ids_p + OFFSET(ipc_ids_in_use), KVADDR, &in_use, 
 		sizeof(int), "ipc_ids.in_use", FAULT_ON_ERROR);
@@ -591,19 +610,17 @@ ipc_search_idr(ulong ipc_ids_p, int specified, ulong specified_value, int (*fn)(
 		return 0;
 	}
 
-	for (total = 0, next_id = 0; total < in_use; next_id++) {
-		ipc = idr_find(ipcs_idr_p, next_id);
-		if (ipc == 0)
-			continue;
-		
-		total++;
-		if (fn(ipc, specified, specified_value, next_id, verbose)) {
-			found = 1;
-			if (specified != SPECIFIED_NOTHING)
-				break;
-		}
-	}
-	
+	is.fn = fn;
+	is.specified = specified;
+	is.specified_value = specified_value;
+	is.verbose = verbose;
+	is.in_use = in_use;
+	is.total = 0;
+	is.found = 0;
+
+	do_idr(ipcs_idr_p, ipc_search_idr_entry, &is);
+	found = is.found;
+
 	if (!verbose && specified == SPECIFIED_NOTHING)
 		fprintf(fp, "\n");
 
@@ -613,17 +630,37 @@ ipc_search_idr(ulong ipc_ids_p, int specified, ulong specified_value, int (*fn)(
 		return 0;
 }
 
+static int
+ipc_search_idr_entry(int id, ulong ipc, void *arg)
+{
+	struct ipc_search *is = (struct ipc_search *)arg;
+
+	is->total++;
+	if (is->fn(ipc, is->specified, is->specified_value, id, is->verbose)) {
+		is->found = 1;
+		if (is->specified != SPECIFIED_NOTHING)
+			return FALSE;
+	}
+
+	return is->total < is->in_use;
+}
+
 /*
- * search every idr_layer
+ *  Walk an idr in ascending id order, calling fn() with the id and the
+ *  pointer stored in each populated slot, until fn() returns FALSE.
+ *  The ary[] of each idr_layer is read in its entirety with one
+ *  readmem(), and empty subtrees are skipped, so a sparse idr costs
+ *  one read per populated layer rather than a walk from the top for
+ *  every candidate id.  Returns the number of populated slots visited.
  */
-static ulong
-idr_find(ulong idp, int id)
+int
+do_idr(ulong idp, int (*fn)(int, ulong, void *), void *arg)
 {
+	struct idr_walk iw;
 	ulong idr_layer_p;
-	int layer;
-	int idr_layers;
-	int n;
-	int index;
+	int layer, idr_layers, n;
+
+	ipcs_init();
 
 	readmem(idp + OFFSET(idr_top), KVADDR, &idr_layer_p,
 		sizeof(ulong), "idr.top", FAULT_ON_ERROR);
@@ -641,20 +678,53 @@ idr_find(ulong idp, int id)
 			sizeof(int), "idr.layers", FAULT_ON_ERROR);
 		n = idr_layers * ipcs_table.idr_bits;
 	}
-	id &= MAX_ID_MASK;
 
-	if (id >= (1 << n))
+	if (n <= 0)
 		return 0;
 
-	while (n > 0 && idr_layer_p) {
-		n -= ipcs_table.idr_bits;
-		index = (id >> n) & ((1 << ipcs_table.idr_bits) - 1);
-		readmem(idr_layer_p + OFFSET(idr_layer_ary) +
-			sizeof(ulong) * index, KVADDR, &idr_layer_p,
-			sizeof(ulong), "idr_layer.ary", FAULT_ON_ERROR);
+	iw.fn = fn;
+	iw.arg = arg;
+	iw.count = 0;
+	iw.done = FALSE;
+	iw.slots = 1 << ipcs_table.idr_bits;
+	iw.ary = (ulong *)GETBUF(sizeof(ulong) * iw.slots *
+		((n / ipcs_table.idr_bits) + 1));
+
+	idr_walk_layer(&iw, idr_layer_p, n - ipcs_table.idr_bits, 0, iw.ary);
+
+	FREEBUF(iw.ary);
+
+	return iw.count;
+}
+
+static void
+idr_walk_layer(struct idr_walk *iw, ulong idr_layer_p, int shift, 
+	ulong base, ulong *ary)
+{
+	ulong id;
+	int i;
+
+	readmem(idr_layer_p + OFFSET(idr_layer_ary), KVADDR, ary,
+		sizeof(ulong) * iw->slots, "idr_layer.ary", FAULT_ON_ERROR);
+
+	for (i = 0; (i < iw->slots) && !iw->done; i++) {
+		if (!ary[i])
+			continue;
+
+		id = base | ((ulong)i << shift);
+		if (id > MAX_ID_MASK)
+			break;
+
+		if (shift) {
+			idr_walk_layer(iw, ary[i], shift - ipcs_table.idr_bits,
+				id, ary + iw->slots);
+			continue;
+		}
+
+		iw->count++;
+		if (!iw->fn((int)id, ary[i], iw->arg))
+			iw->done = TRUE;
 	}
-	
-	return idr_layer_p;
 }
 
 /*
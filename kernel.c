@@ -46,8 +46,10 @@ static void dump_timer_data(void);
 static void dump_timer_data_tvec_bases_v1(void);
 static void dump_timer_data_tvec_bases_v2(void);
 struct tv_range;
+struct timer_data_array;
 static void init_tv_ranges(struct tv_range *, int, int, int);
-static int do_timer_list(ulong,int, ulong *, void *,ulong *,struct tv_range *);
+static int do_timer_list(ulong,int, ulong *, struct timer_data_array *, struct tv_range *);
+static void timer_data_append(struct timer_data_array *, ulong, ulong, ulong);
 static int compare_timer_data(const void *, const void *);
 static void panic_this_kernel(void);
 static void dump_waitq(ulong, char *);
@@ -75,6 +77,7 @@ static void dump_log_legacy(void);
 static void dump_variable_length_record(void);
 static int is_livepatch(void);
 static void show_kernel_taints(char *, int);
+static struct disasm_function *disasm_cache_fill(ulong);
 
 
 /*
@@ -1869,6 +1872,275 @@ kernel_BUG_encoding_bytes(void)
 	return kt->BUG_bytes;
 }
 
+/*
+ *  Cache of gdb "x/i" output for entire kernel text functions, used by 
+ *  the backtrace code that repeatedly disassembles the same functions to
+ *  determine frame sizes and call targets.  Each function is disassembled
+ *  once; subsequent requests are replayed from the saved lines, which are
+ *  indexed by instruction address.  On a live system, the text may be
+ *  re-patched by ftrace, jump labels or livepatch at any time, so the
+ *  cache is only kept for the duration of a command.
+ */
+#define DISASM_CACHE_ENTRIES   (256)
+#define DISASM_CACHE_HASH(X)   (((X) >> 4) % DISASM_CACHE_ENTRIES)
+#define DISASM_MAX_FUNCTION    (64*1024)
+#define DISASM_MAX_INSN_LEN()  \
+	(machine_type("X86") || machine_type("X86_64") ? 15 : \
+	 machine_type("S390X") ? 6 : 4)
+
+struct disasm_function {
+	ulong start;
+	ulong end;
+	uint radix;
+	int count;
+	ulong *addrs;
+	char **lines;
+	char *text;
+	struct disasm_function *next;
+};
+
+static struct disasm_cache {
+	struct disasm_function *hash[DISASM_CACHE_ENTRIES];
+	struct disasm_function *fifo[DISASM_CACHE_ENTRIES];
+	int index;
+	FILE *tmpfile;
+	ulong cmdgen;
+	ulong refs;
+	ulong hits;
+	ulong fills;
+} disasm_cache = { { 0 } };
+
+static void
+free_disasm_function(struct disasm_function *df)
+{
+	struct disasm_function **dfp;
+
+	for (dfp = &disasm_cache.hash[DISASM_CACHE_HASH(df->start)]; *dfp;
+	     dfp = &(*dfp)->next) {
+		if (*dfp == df) {
+			*dfp = df->next;
+			break;
+		}
+	}
+
+	free(df->addrs);
+	free(df->lines);
+	free(df->text);
+	free(df);
+}
+
+static struct disasm_function *
+disasm_cache_fill(ulong start)
+{
+	struct syment *sp, *spn;
+	struct disasm_function *df;
+	struct disasm_cache *dc;
+	char buf[BUFSIZE];
+	char *p1;
+	long size, len, textlen, count;
+	ulong addr, next, last;
+	int c;
+
+	dc = &disasm_cache;
+
+	if (!(sp = value_search(start, NULL)) || (sp->value != start) ||
+	    !(spn = next_symbol(NULL, sp)))
+		return NULL;
+
+	size = spn->value - sp->value;
+	if ((size <= 0) || (size > DISASM_MAX_FUNCTION))
+		return NULL;
+
+	if (!dc->tmpfile && !(dc->tmpfile = tmpfile()))
+		return NULL;
+
+	if ((df = (struct disasm_function *)
+	    calloc(1, sizeof(struct disasm_function))) == NULL)
+		return NULL;
+	df->start = start;
+	df->end = spn->value;
+	df->radix = *gdb_output_radix;
+
+	/*
+	 *  Disassemble no more instructions than can start before the end
+	 *  of the function, plus one more whose address is where the next
+	 *  request picks up; on fixed-length architectures that takes one
+	 *  request.  Save the lines up to the end of the function, along
+	 *  with the address of each.
+	 */
+	textlen = 0;
+	next = start;
+	while (next < df->end) {
+		rewind(dc->tmpfile);
+		if (ftruncate(fileno(dc->tmpfile), 0) < 0)
+			goto fill_failed;
+
+		count = (df->end - next + DISASM_MAX_INSN_LEN() - 1) / 
+			DISASM_MAX_INSN_LEN();
+		sprintf(buf, "x/%ldi 0x%lx", count + 1, next);
+		if (!gdb_pass_through(buf, dc->tmpfile, GNU_RETURN_ON_ERROR))
+			goto fill_failed;
+		fflush(dc->tmpfile);
+
+		last = next;
+		rewind(dc->tmpfile);
+		while (fgets(buf, BUFSIZE, dc->tmpfile)) {
+			for (p1 = buf; whitespace(*p1); p1++)
+				;
+			if (!STRNEQ(p1, "0x"))
+				continue;
+			addr = strtoul(p1, NULL, 16);
+			if (addr >= df->end) {
+				last = df->end;
+				break;
+			}
+			if (addr < last)
+				break;
+			last = addr;
+
+			len = strlen(buf) + 1;
+			if (((df->count % 64) == 0) &&
+			    (!(df->addrs = (ulong *)realloc(df->addrs,
+			    sizeof(ulong) * (df->count + 64))) ||
+			    !(df->lines = (char **)realloc(df->lines,
+			    sizeof(char *) * (df->count + 64))))) 
+				goto fill_failed;
+			if (!(p1 = (char *)realloc(df->text, textlen + len)))
+				goto fill_failed;
+			df->text = p1;
+
+			df->addrs[df->count] = addr;
+			df->lines[df->count] = (char *)textlen;
+			strcpy(df->text + textlen, buf);
+			textlen += len;
+			df->count++;
+		}
+
+		/*
+		 *  The last line read starts the next request, which 
+		 *  disassembles it again; give up if no progress was made.
+		 */
+		if (last <= next)
+			goto fill_failed;
+		if (last < df->end) {
+			df->count--;
+			textlen = (ulong)df->lines[df->count];
+		}
+		next = last;
+	}
+
+	if (!df->count)
+		goto fill_failed;
+
+	for (c = 0; c < df->count; c++)
+		df->lines[c] = df->text + (ulong)df->lines[c];
+
+	if (dc->fifo[dc->index])
+		free_disasm_function(dc->fifo[dc->index]);
+	dc->fifo[dc->index] = df;
+	dc->index = (dc->index + 1) % DISASM_CACHE_ENTRIES;
+
+	df->next = dc->hash[DISASM_CACHE_HASH(start)];
+	dc->hash[DISASM_CACHE_HASH(start)] = df;
+	dc->fills++;
+
+	return df;
+
+fill_failed:
+	free(df->addrs);
+	free(df->lines);
+	free(df->text);
+	free(df);
+	return NULL;
+}
+
+/*
+ *  Write the output of "x/<count>i <addr>" to ofp, stopping at the end 
+ *  of the kernel function containing addr.  Returns FALSE if the request 
+ *  cannot be served from the cache, in which case the caller should
+ *  pass the command through to gdb as usual.
+ */
+int
+disasm_cache_lines(ulong addr, long count, FILE *ofp)
+{
+	struct syment *sp;
+	struct disasm_function *df;
+	struct disasm_cache *dc;
+	ulong offset;
+	int i;
+
+	dc = &disasm_cache;
+
+	if ((count <= 0) || !is_kernel_text(addr) ||
+	    (ACTIVE() && module_symbol(addr, NULL, NULL, NULL, 0)) ||
+	    !(sp = value_search(addr, &offset)))
+		return FALSE;
+
+	if (ACTIVE() && (dc->cmdgen != pc->cmdgencur)) {
+		clear_disasm_cache();
+		dc->cmdgen = pc->cmdgencur;
+	}
+
+	dc->refs++;
+
+	for (df = dc->hash[DISASM_CACHE_HASH(sp->value)]; df; df = df->next) {
+		if ((df->start == sp->value) && (df->radix == *gdb_output_radix))
+			break;
+	}
+
+	if (df)
+		dc->hits++;
+	else if (!(df = disasm_cache_fill(sp->value)))
+		return FALSE;
+
+	for (i = 0; i < df->count; i++) {
+		if (df->addrs[i] >= addr)
+			break;
+	}
+
+	if ((i == df->count) || (df->addrs[i] != addr))
+		return FALSE;
+
+	for ( ; (i < df->count) && count; i++, count--)
+		fputs(df->lines[i], ofp);
+
+	return TRUE;
+}
+
+void
+clear_disasm_cache(void)
+{
+	struct disasm_cache *dc;
+	int i;
+
+	dc = &disasm_cache;
+
+	for (i = 0; i < DISASM_CACHE_ENTRIES; i++) {
+		if (dc->fifo[i])
+			free_disasm_function(dc->fifo[i]);
+		dc->fifo[i] = NULL;
+	}
+	dc->index = 0;
+}
+
+void
+dump_disasm_cache(void)
+{
+	struct disasm_cache *dc;
+	int i, functions;
+
+	dc = &disasm_cache;
+
+	for (i = functions = 0; i < DISASM_CACHE_ENTRIES; i++) {
+		if (dc->fifo[i])
+			functions++;
+	}
+
+	fprintf(fp, "disasm_cache functions: %d fills: %ld hit rate: %ld%% "
+		"(%ld of %ld)\n", functions, dc->fills, 
+		dc->refs ? (dc->hits * 100)/dc->refs : 0, dc->hits, dc->refs);
+}
+
 #ifdef NOT_USED
 /*
  *  To avoid premature stoppage/extension of a dis <function> that includes
@@ -3841,6 +4113,7 @@ do_module_cmd(ulong flag, char *modref, ulong address,
 	case LOAD_SPECIFIED_MODULE_SYMBOLS:
 		if (!load_module_symbols(modref, objfile, address)) 
 			error(FATAL, "cannot load symbols from: %s\n", objfile);
+		index_cache_update();
 		do_module_cmd(LIST_MODULE_HDR, 0, address, 0, NULL);
 		do_module_cmd(REMOTE_MODULE_SAVE_MSG, 0, 0, 0, NULL);
 		break;
@@ -3887,6 +4160,7 @@ do_module_cmd(ulong flag, char *modref, ulong address,
                               "cannot find or load object file for %s module\n",
 					modref);
 		}
+		index_cache_update();
 		do_module_cmd(REMOTE_MODULE_SAVE_MSG, 0, 0, 0, tree);
 		break;
 
@@ -3928,6 +4202,7 @@ reinit_modules(void)
         st->load_modules = NULL;
         kt->mods_installed = 0;
 	clear_text_value_cache();
+	clear_disasm_cache();
 
         module_init();
 }
@@ -4045,15 +4320,15 @@ module_objfile_search(char *modref, char *filename, char *tree)
 	}
 
 	if (tree) {
-		if (!(retbuf = search_directory_tree(tree, file, 1))) {
+		if (!(retbuf = search_directory_index(tree, file, 1))) {
 			switch (kt->flags & (KMOD_V1|KMOD_V2))
 			{
 			case KMOD_V2:
 				sprintf(file, "%s.ko", modref);
-				retbuf = search_directory_tree(tree, file, 1);
+				retbuf = search_directory_index(tree, file, 1);
 				if (!retbuf) {
 					sprintf(file, "%s.ko.debug", modref);
-					retbuf = search_directory_tree(tree, file, 1);
+					retbuf = search_directory_index(tree, file, 1);
 				}
 			}
 		}
@@ -4062,19 +4337,19 @@ module_objfile_search(char *modref, char *filename, char *tree)
 
 	sprintf(dir, "%s/%s", DEFAULT_REDHAT_DEBUG_LOCATION, 
 		kt->utsname.release);
-	retbuf = search_directory_tree(dir, file, 0);
+	retbuf = search_directory_index(dir, file, 0);
 
 	if (!retbuf && (env = getenv("CRASH_MODULE_PATH"))) {
 		sprintf(dir, "%s", env);
-		if (!(retbuf = search_directory_tree(dir, file, 0))) {
+		if (!(retbuf = search_directory_index(dir, file, 0))) {
 			switch (kt->flags & (KMOD_V1|KMOD_V2))
 			{
 			case KMOD_V2:
 				sprintf(file, "%s.ko", modref);
-				retbuf = search_directory_tree(dir, file, 0);
+				retbuf = search_directory_index(dir, file, 0);
 				if (!retbuf) {
 					sprintf(file, "%s.ko.debug", modref);
-					retbuf = search_directory_tree(dir, file, 0);
+					retbuf = search_directory_index(dir, file, 0);
 				}
 			}
 		}
@@ -4082,39 +4357,39 @@ module_objfile_search(char *modref, char *filename, char *tree)
 
 	if (!retbuf) {
 		sprintf(dir, "/lib/modules/%s/updates", kt->utsname.release);
-		if (!(retbuf = search_directory_tree(dir, file, 0))) {
+		if (!(retbuf = search_directory_index(dir, file, 0))) {
 			switch (kt->flags & (KMOD_V1|KMOD_V2))
 			{
 			case KMOD_V2:
 				sprintf(file, "%s.ko", modref);
-				retbuf = search_directory_tree(dir, file, 0);
+				retbuf = search_directory_index(dir, file, 0);
 			}
 		}
 	}
 
 	if (!retbuf) {
 		sprintf(dir, "/lib/modules/%s", kt->utsname.release);
-		if (!(retbuf = search_directory_tree(dir, file, 0))) {
+		if (!(retbuf = search_directory_index(dir, file, 0))) {
 			switch (kt->flags & (KMOD_V1|KMOD_V2))
 			{
 			case KMOD_V2:
 				sprintf(file, "%s.ko", modref);
-				retbuf = search_directory_tree(dir, file, 0);
+				retbuf = search_directory_index(dir, file, 0);
 			}
 		}
 	}
 
 	if (!retbuf && !filename && !tree && kt->module_tree) {
 		sprintf(dir, "%s", kt->module_tree);
-		if (!(retbuf = search_directory_tree(dir, file, 0))) {
+		if (!(retbuf = search_directory_index(dir, file, 0))) {
 			switch (kt->flags & (KMOD_V1|KMOD_V2))
 			{
 			case KMOD_V2:
 				sprintf(file, "%s.ko", modref);
-				retbuf = search_directory_tree(dir, file, 0);
+				retbuf = search_directory_index(dir, file, 0);
 				if (!retbuf) {
 					sprintf(file, "%s.ko.debug", modref);
-					retbuf = search_directory_tree(dir, file, 0);
+					retbuf = search_directory_index(dir, file, 0);
 				}
 			}
 		}
@@ -4127,15 +4402,15 @@ module_objfile_search(char *modref, char *filename, char *tree)
 	    (namelist = realpath(pc->namelist_orig ? 
 		pc->namelist_orig : pc->namelist, NULL))) {
 		sprintf(dir, "%s", dirname(namelist));
-		if (!(retbuf = search_directory_tree(dir, file, 0))) {
+		if (!(retbuf = search_directory_index(dir, file, 0))) {
 			switch (kt->flags & (KMOD_V1|KMOD_V2))
 			{
 			case KMOD_V2:
 				sprintf(file, "%s.ko", modref);
-				retbuf = search_directory_tree(dir, file, 0);
+				retbuf = search_directory_index(dir, file, 0);
 				if (!retbuf) {
 					sprintf(file, "%s.ko.debug", modref);
-					retbuf = search_directory_tree(dir, file, 0);
+					retbuf = search_directory_index(dir, file, 0);
 				}
 			}
 		}
@@ -4145,11 +4420,11 @@ module_objfile_search(char *modref, char *filename, char *tree)
 	if (!retbuf && is_livepatch()) {
 		sprintf(file, "%s.ko", modref);
 		sprintf(dir, "/usr/lib/kpatch/%s", kt->utsname.release);
-		if (!(retbuf = search_directory_tree(dir, file, 0))) {
+		if (!(retbuf = search_directory_index(dir, file, 0))) {
 			sprintf(file, "%s.ko.debug", modref);
 			sprintf(dir, "/usr/lib/debug/usr/lib/kpatch/%s", 
 				kt->utsname.release);
-			retbuf = search_directory_tree(dir, file, 0);
+			retbuf = search_directory_index(dir, file, 0);
 		}
 	}
 
@@ -6895,7 +7170,7 @@ dump_hrtimer_base(const void *hrtimer_bases, const int num)
 static void
 dump_active_timers(const void *base, ulonglong now)
 {
-	int next, i, t;
+	int t;
 	struct rb_node *curr;
 	int timer_cnt;
 	ulong *timer_list;
@@ -6905,14 +7180,11 @@ dump_active_timers(const void *base, ulonglong now)
 	char buf3[BUFSIZE];
 	char buf4[BUFSIZE];
 
-	next = 0;
 	timer_list = 0;
 
 	/* search hrtimers */
 	hq_open();
 	timer_cnt = 0;
-next_one:
-	i = 0;
 
 	/* get the first node */
 	if (VALID_MEMBER(hrtimer_base_pending))
@@ -6934,20 +7206,16 @@ next_one:
 			KVADDR, &curr, sizeof(curr), "hrtimer_clock base",
 			FAULT_ON_ERROR);
 
-	while (curr && i < next) {
-		curr = rb_next(curr);
-		i++;
-	}
-
-	if (curr) {
+	/* walk the rbtree in order from the first node */
+	while (curr) {
 		if (!hq_enter((ulong)curr)) {
 			error(INFO, "duplicate rb_node: %lx\n", curr);
+			hq_close();
 			return;
 		}
 
 		timer_cnt++;
-		next++;
-		goto next_one;
+		curr = rb_next(curr);
 	}
 
 	if (timer_cnt) {
@@ -7149,6 +7417,17 @@ struct tv_range {
         ulong end;
 };
 
+/*
+ *  The timers gathered from all of the timer vectors of a cpu in a
+ *  single pass, along with the highest expiration value seen.
+ */
+struct timer_data_array {
+	struct timer_data *td;
+	int count;
+	int size;
+	ulong highest;
+};
+
 #define TVN (6)
 
 static void
@@ -7166,7 +7445,7 @@ dump_timer_data(void)
         ulong mask, highest, function;
 	ulong jiffies, timer_jiffies;
 	ulong *vec;
-	long count;
+	struct timer_data_array tda;
         int vec_root_size, vec_size;
 	struct timer_data *td;
 	int flen, tdx, old_timers_exist;
@@ -7199,44 +7478,15 @@ dump_timer_data(void)
 	} else
 		old_timers_exist = FALSE;
 
-	/*
- 	 * Get rough count first, and then gather a bunch of timer_data
-	 * structs to stuff in a sortable array.
-	 */
-
-	count = 0;
-        for (mask = 1, tp = timer_table+0; old_timers_exist && mask; 
-	     tp++, mask += mask) {
-                if (mask > timer_active)
-                        break;
-                if (!(mask & timer_active))
-                        continue;
-		count++;
-        }
-
 	init_tv_ranges(tv, vec_root_size, vec_size, 0);
 
-        count += do_timer_list(symbol_value("tv1") + OFFSET(timer_vec_root_vec),
-		vec_root_size, vec, NULL, NULL, tv);
-        count += do_timer_list(symbol_value("tv2") + OFFSET(timer_vec_vec),
-		vec_size, vec, NULL, NULL, tv);
-        count += do_timer_list(symbol_value("tv3") + OFFSET(timer_vec_vec),
-		vec_size, vec, NULL, NULL, tv);
-        count += do_timer_list(symbol_value("tv4") + OFFSET(timer_vec_vec),
-		vec_size, vec, NULL, NULL, tv);
-        count += do_timer_list(symbol_value("tv4") + OFFSET(timer_vec_vec),
-		vec_size, vec, NULL, NULL, tv);
-
-	td = (struct timer_data *)
-		GETBUF((count*2) * sizeof(struct timer_data));
-	tdx = 0;
-
 	get_symbol_data("jiffies", sizeof(ulong), &jiffies);
 	get_symbol_data("timer_jiffies", sizeof(ulong), &timer_jiffies);
 	if (old_timers_exist)
 		get_symbol_data("timer_active", sizeof(ulong), &timer_active);
 
-	highest = 0;
+	BZERO(&tda, sizeof(struct timer_data_array));
+
         for (i = 0, mask = 1, tp = timer_table+0; old_timers_exist && mask; 
 	     i++, tp++, mask += mask) {
                 if (mask > timer_active) 
@@ -7245,24 +7495,23 @@ dump_timer_data(void)
                 if (!(mask & timer_active)) 
                         continue;
 
-		td[tdx].address = i;
-		td[tdx].expires = tp->expires;
-		td[tdx].function = (ulong)tp->fn;
-		if (td[tdx].expires > highest)
-			highest = td[tdx].expires;
-		tdx++;
+		timer_data_append(&tda, i, tp->expires, (ulong)tp->fn);
         }
 
 	do_timer_list(symbol_value("tv1") + OFFSET(timer_vec_root_vec),
-		vec_root_size, vec, (void *)td, &highest, tv);
+		vec_root_size, vec, &tda, tv);
 	do_timer_list(symbol_value("tv2") + OFFSET(timer_vec_vec),
-		vec_size, vec, (void *)td, &highest, tv);
+		vec_size, vec, &tda, tv);
 	do_timer_list(symbol_value("tv3") + OFFSET(timer_vec_vec),
-		vec_size, vec, (void *)td, &highest, tv);
+		vec_size, vec, &tda, tv);
 	do_timer_list(symbol_value("tv4") + OFFSET(timer_vec_vec),
-		vec_size, vec, (void *)td, &highest, tv);
-	tdx = do_timer_list(symbol_value("tv5") + OFFSET(timer_vec_vec),
-		vec_size, vec, (void *)td, &highest, tv);
+		vec_size, vec, &tda, tv);
+	do_timer_list(symbol_value("tv5") + OFFSET(timer_vec_vec),
+		vec_size, vec, &tda, tv);
+
+	td = tda.td;
+	tdx = tda.count;
+	highest = tda.highest;
 
         qsort(td, tdx, sizeof(struct timer_data), compare_timer_data);
 
@@ -7325,7 +7574,7 @@ dump_timer_data_tvec_bases_v1(void)
         int vec_root_size, vec_size;
         struct tv_range tv[TVN];
 	ulong *vec, jiffies, highest, function;
-	long count;
+	struct timer_data_array tda;
 	char buf1[BUFSIZE];
 	char buf2[BUFSIZE];
 	char buf3[BUFSIZE];
@@ -7344,41 +7593,27 @@ dump_timer_data_tvec_bases_v1(void)
 
 next_cpu:
 
-        count = 0;
-        td = (struct timer_data *)NULL;
-
 	BZERO(tv, sizeof(struct tv_range) * TVN);
 
         init_tv_ranges(tv, vec_root_size, vec_size, cpu);
 
-        count += do_timer_list(tv[1].base + OFFSET(tvec_root_s_vec),
-                vec_root_size, vec, NULL, NULL, tv);
-        count += do_timer_list(tv[2].base + OFFSET(tvec_s_vec),
-                vec_size, vec, NULL, NULL, tv);
-        count += do_timer_list(tv[3].base + OFFSET(tvec_s_vec),
-                vec_size, vec, NULL, NULL, tv);
-        count += do_timer_list(tv[4].base + OFFSET(tvec_s_vec),
-                vec_size, vec, NULL, NULL, tv);
-        count += do_timer_list(tv[5].base + OFFSET(tvec_s_vec),
-                vec_size, vec, NULL, NULL, tv);
-
-	if (count)
-        	td = (struct timer_data *)
-                	GETBUF((count*2) * sizeof(struct timer_data));
-        tdx = 0;
-	highest = 0;
+	BZERO(&tda, sizeof(struct timer_data_array));
         get_symbol_data("jiffies", sizeof(ulong), &jiffies);
 
         do_timer_list(tv[1].base + OFFSET(tvec_root_s_vec),
-                vec_root_size, vec, (void *)td, &highest, tv);
+                vec_root_size, vec, &tda, tv);
         do_timer_list(tv[2].base + OFFSET(tvec_s_vec),
-                vec_size, vec, (void *)td, &highest, tv);
+                vec_size, vec, &tda, tv);
         do_timer_list(tv[3].base + OFFSET(tvec_s_vec),
-                vec_size, vec, (void *)td, &highest, tv);
+                vec_size, vec, &tda, tv);
         do_timer_list(tv[4].base + OFFSET(tvec_s_vec),
-                vec_size, vec, (void *)td, &highest, tv);
-        tdx = do_timer_list(tv[5].base + OFFSET(tvec_s_vec),
-                vec_size, vec, (void *)td, &highest, tv);
+                vec_size, vec, &tda, tv);
+        do_timer_list(tv[5].base + OFFSET(tvec_s_vec),
+                vec_size, vec, &tda, tv);
+
+	td = tda.td;
+	tdx = tda.count;
+	highest = tda.highest;
 
         qsort(td, tdx, sizeof(struct timer_data), compare_timer_data);
 
@@ -7443,7 +7678,7 @@ dump_timer_data_tvec_bases_v2(void)
         struct tv_range tv[TVN];
 	ulong *vec, jiffies, highest, function;
 	ulong tvec_bases;
-	long count;
+	struct timer_data_array tda;
 	struct syment *sp;
 	char buf1[BUFSIZE];
 	char buf2[BUFSIZE];
@@ -7484,41 +7719,27 @@ next_cpu:
 	}
 
 
-	count = 0;
-	td = (struct timer_data *)NULL;
-
 	BZERO(tv, sizeof(struct tv_range) * TVN);
 
         init_tv_ranges(tv, vec_root_size, vec_size, cpu);
 
-        count += do_timer_list(tv[1].base + OFFSET(tvec_root_s_vec),
-                vec_root_size, vec, NULL, NULL, tv);
-        count += do_timer_list(tv[2].base + OFFSET(tvec_s_vec),
-                vec_size, vec, NULL, NULL, tv);
-        count += do_timer_list(tv[3].base + OFFSET(tvec_s_vec),
-                vec_size, vec, NULL, NULL, tv);
-        count += do_timer_list(tv[4].base + OFFSET(tvec_s_vec),
-                vec_size, vec, NULL, NULL, tv);
-        count += do_timer_list(tv[5].base + OFFSET(tvec_s_vec),
-                vec_size, vec, NULL, NULL, tv);
-
-	if (count)
-        	td = (struct timer_data *)
-                	GETBUF((count*2) * sizeof(struct timer_data));
-        tdx = 0;
-	highest = 0;
+	BZERO(&tda, sizeof(struct timer_data_array));
         get_symbol_data("jiffies", sizeof(ulong), &jiffies);
 
         do_timer_list(tv[1].base + OFFSET(tvec_root_s_vec),
-                vec_root_size, vec, (void *)td, &highest, tv);
+                vec_root_size, vec, &tda, tv);
         do_timer_list(tv[2].base + OFFSET(tvec_s_vec),
-                vec_size, vec, (void *)td, &highest, tv);
+                vec_size, vec, &tda, tv);
         do_timer_list(tv[3].base + OFFSET(tvec_s_vec),
-                vec_size, vec, (void *)td, &highest, tv);
+                vec_size, vec, &tda, tv);
         do_timer_list(tv[4].base + OFFSET(tvec_s_vec),
-                vec_size, vec, (void *)td, &highest, tv);
-        tdx = do_timer_list(tv[5].base + OFFSET(tvec_s_vec),
-                vec_size, vec, (void *)td, &highest, tv);
+                vec_size, vec, &tda, tv);
+        do_timer_list(tv[5].base + OFFSET(tvec_s_vec),
+                vec_size, vec, &tda, tv);
+
+	td = tda.td;
+	tdx = tda.count;
+	highest = tda.highest;
 
         qsort(td, tdx, sizeof(struct timer_data), compare_timer_data);
 
@@ -7679,21 +7900,49 @@ init_tv_ranges(struct tv_range *tv, int vec_root_size, int vec_size, int cpu)
 	 (((vaddr) >= tv[5].base) && ((vaddr) < tv[5].end)))
 
 /*
- *  Count, or stash, the entries of a linked timer_list -- depending
- *  upon the option value.
+ *  Append a timer to a timer_data_array, growing it as required.
+ */
+static void
+timer_data_append(struct timer_data_array *tda, ulong address, 
+	ulong expires, ulong function)
+{
+	struct timer_data *td;
+	int size;
+
+	if (tda->count == tda->size) {
+		size = tda->size ? tda->size * 2 : 1024;
+		td = (struct timer_data *)GETBUF(sizeof(struct timer_data) * size);
+		if (tda->td) {
+			BCOPY(tda->td, td, sizeof(struct timer_data) * tda->count);
+			FREEBUF(tda->td);
+		}
+		tda->td = td;
+		tda->size = size;
+	}
+
+	tda->td[tda->count].address = address;
+	tda->td[tda->count].expires = expires;
+	tda->td[tda->count].function = function;
+	tda->count++;
+
+	if (expires > tda->highest)
+		tda->highest = expires;
+}
+
+/*
+ *  Gather the entries of a timer vector's linked timer_lists into
+ *  a timer_data_array.  Returns the number of entries found.
  */
 static int
 do_timer_list(ulong vec_kvaddr,
 	      int size, 
 	      ulong *vec, 
-	      void *option, 
-	      ulong *highest,
+	      struct timer_data_array *tda,
 	      struct tv_range *tv)
 {
 	int i, t; 
-	int count, tdx;
+	int count;
 	ulong expires, function;
-	struct timer_data *td;
 	char *timer_list_buf;
 	ulong *timer_list;
 	int timer_cnt;
@@ -7701,13 +7950,6 @@ do_timer_list(ulong vec_kvaddr,
 	long sz;
 	ulong offset;
 
-	tdx = 0;
-	td = option ? (struct timer_data *)option : NULL;
-	if (td) {
-		while (td[tdx].function)
-			tdx++;
-	}
-
         if (VALID_MEMBER(timer_list_list))
 		sz = SIZE(list_head) * size;
 	else if (VALID_MEMBER(timer_list_entry))
@@ -7760,14 +8002,8 @@ do_timer_list(ulong vec_kvaddr,
                                 function = ULONG(timer_list_buf +
                                         OFFSET(timer_list_function));
 
-                                if (td) {
-                                        td[tdx].address = timer_list[t];
-                                        td[tdx].expires = expires;
-                                        td[tdx].function = function;
-                                        if (highest && (expires > *highest))
-                                                *highest = expires;
-                                        tdx++;
-                                }
+				timer_data_append(tda, timer_list[t], 
+					expires, function);
 			}
 			FREEBUF(timer_list);
 			count += timer_cnt;
@@ -7776,7 +8012,7 @@ do_timer_list(ulong vec_kvaddr,
 
 	FREEBUF(timer_list_buf);
 
-	return(td ? tdx : count);
+	return count;
 
 new_timer_list_format:
 
@@ -7824,21 +8060,14 @@ new_timer_list_format:
                         function = ULONG(timer_list_buf +
                         	OFFSET(timer_list_function));
 
-                        if (td) {
-                                td[tdx].address = timer_list[t];
-                                td[tdx].expires = expires;
-                                td[tdx].function = function;
-                                if (highest && (expires > *highest))
-                                        *highest = expires;
-                                tdx++;
-                        }
+			timer_data_append(tda, timer_list[t], expires, function);
 		}
 		FREEBUF(timer_list);
 	}
 
 	FREEBUF(timer_list_buf);
 
-	return(td ? tdx : count);
+	return count;
 }
 
 /*
@@ -30,6 +30,12 @@ static void show_untrusted_files(void);
 static void get_osrelease(char *);
 static void get_log(char *);
 static char *no_vmcoreinfo(const char *);
+static void batch_run(int, char **);
+static void run_test(char *);
+
+static char *batch_list = NULL;
+static int batch_jobs = 0;
+static char *batch_dir = ".";
 
 static struct option long_options[] = {
         {"memory_module", required_argument, 0, 0},
@@ -72,6 +78,11 @@ static struct option long_options[] = {
 	{"no_strip", 0, 0, 0},
 	{"hash", required_argument, 0, 0},
 	{"offline", required_argument, 0, 0},
+	{"batch", required_argument, 0, 0},
+	{"batch_jobs", required_argument, 0, 0},
+	{"batch_dir", required_argument, 0, 0},
+	{"test", required_argument, 0, 0},
+	{"index_cache", required_argument, 0, 0},
         {0, 0, 0, 0}
 };
 
@@ -293,6 +304,26 @@ main(int argc, char **argv)
 				}
 			}
 
+			else if (STREQ(long_options[option_index].name, "batch"))
+				batch_list = optarg;
+
+			else if (STREQ(long_options[option_index].name, "batch_jobs")) {
+				if ((batch_jobs = atoi(optarg)) <= 0) {
+					error(INFO, "invalid --batch_jobs argument: %s\n", 
+						optarg);
+					program_usage(SHORT_FORM);
+				}
+			}
+
+			else if (STREQ(long_options[option_index].name, "batch_dir"))
+				batch_dir = optarg;
+
+			else if (STREQ(long_options[option_index].name, "index_cache"))
+				st->index_cache = optarg;
+
+			else if (STREQ(long_options[option_index].name, "test"))
+				run_test(optarg);
+
 			else {
 				error(INFO, "internal error: option %s unhandled\n",
 					long_options[option_index].name);
@@ -411,6 +442,12 @@ main(int argc, char **argv)
 	}
 	opterr = 1;
 
+	if (!st->index_cache)
+		st->index_cache = getenv("CRASH_INDEX_CACHE");
+
+	if (batch_list)
+		batch_run(argc, argv);
+
 	display_version();
 
 	/*
@@ -828,7 +865,7 @@ reattempt:
         			error(FATAL, XEN_HYPERVISOR_NOT_SUPPORTED);
 #endif
 			} else if (!(pc->flags & MINIMAL_MODE)) {
-				tt->refresh_task_table();
+				task_table_refresh();
 				sort_context_array();
 				sort_tgid_array();	
 			}
@@ -1903,3 +1940,224 @@ no_vmcoreinfo(const char *unused)
 {
 	return NULL;
 }
+
+/*
+ *  Batch mode: run the same crash invocation against each of the 
+ *  dumpfiles listed in the --batch file, with up to --batch_jobs 
+ *  sessions running concurrently.  Each session is a separate crash
+ *  process that is given the original command line options and 
+ *  arguments plus its dumpfile, and whose output is written to a file
+ *  in the --batch_dir directory.  The exit status and elapsed time of
+ *  each session are reported when all of them have completed.
+ */
+struct batch_job {
+	char *dumpfile;
+	char *output;
+	pid_t pid;
+	int status;
+	struct timeval start;
+	struct timeval end;
+};
+
+static void
+batch_output_name(struct batch_job *job)
+{
+	char *p, *q;
+
+	if (!(job->output = malloc(strlen(batch_dir) + 
+	    strlen(job->dumpfile) + strlen("/.out") + 1)))
+		error(FATAL, "cannot malloc batch output filename\n");
+
+	/*
+	 *  Dumpfiles are commonly all named "vmcore", so the output 
+	 *  filename is derived from the full dumpfile path.
+	 */
+	q = job->output + sprintf(job->output, "%s/", batch_dir);
+	for (p = job->dumpfile; *p == '/' || *p == '.'; p++)
+		;
+	for ( ; *p; p++)
+		*q++ = (*p == '/') ? '_' : *p;
+	strcpy(q, ".out");
+}
+
+static void
+batch_exec(struct batch_job *job, char **argv, int argc)
+{
+	int fd;
+
+	if ((fd = open(job->output, O_WRONLY|O_CREAT|O_TRUNC, 0644)) < 0) {
+		fprintf(stderr, "%s: %s: %s\n", pc->program_name, 
+			job->output, strerror(errno));
+		_exit(1);
+	}
+	dup2(fd, STDOUT_FILENO);
+	dup2(fd, STDERR_FILENO);
+	close(fd);
+	if ((fd = open("/dev/null", O_RDONLY)) >= 0) {
+		dup2(fd, STDIN_FILENO);
+		close(fd);
+	}
+
+	argv[argc] = job->dumpfile;
+	execvp(pc->program_path, argv);
+
+	fprintf(stderr, "%s: cannot execute %s: %s\n", pc->program_name, 
+		pc->program_path, strerror(errno));
+	_exit(1);
+}
+
+static void
+batch_run(int argc, char **argv)
+{
+	FILE *lfp;
+	char buf[BUFSIZE];
+	char **wargv;
+	struct batch_job *jobs, *job;
+	struct timeval now;
+	int i, j, wargc, njobs, next, running, failed, status;
+	pid_t pid;
+
+	if (!pc->input_file) {
+		error(INFO, "--batch requires an -i input file\n");
+		program_usage(SHORT_FORM);
+	}
+
+	if (STREQ(batch_list, "-"))
+		lfp = stdin;
+	else if ((lfp = fopen(batch_list, "r")) == NULL)
+		error(FATAL, "%s: %s\n", batch_list, strerror(errno));
+
+	jobs = NULL;
+	njobs = 0;
+	while (fgets(buf, BUFSIZE, lfp)) {
+		clean_line(buf);
+		if (!strlen(buf) || (buf[0] == '#'))
+			continue;
+		if (!(jobs = realloc(jobs, sizeof(struct batch_job) * (njobs+1))))
+			error(FATAL, "cannot realloc batch job table\n");
+		job = &jobs[njobs++];
+		BZERO(job, sizeof(struct batch_job));
+		job->dumpfile = strdup(buf);
+		batch_output_name(job);
+	}
+	if (lfp != stdin)
+		fclose(lfp);
+
+	if (!njobs)
+		error(FATAL, "%s: no dumpfiles listed\n", batch_list);
+
+	if (!batch_jobs && ((batch_jobs = sysconf(_SC_NPROCESSORS_ONLN)) <= 0))
+		batch_jobs = 1;
+
+	/*
+	 *  getopt_long() has moved the options ahead of the arguments.
+	 *  Pass everything on to each session except for the batch 
+	 *  options, and leave a slot for the dumpfile.
+	 */
+	if (!(wargv = (char **)malloc(sizeof(char *) * (argc + 3))))
+		error(FATAL, "cannot malloc batch argument vector\n");
+	wargc = 0;
+	wargv[wargc++] = pc->program_path;
+	wargv[wargc++] = "-s";
+	for (i = 1; i < argc; i++) {
+		if ((i < optind) && STRNEQ(argv[i], "--batch")) {
+			if (!strchr(argv[i], '='))
+				i++;
+			continue;
+		}
+		wargv[wargc++] = argv[i];
+	}
+	wargv[wargc+1] = NULL;
+
+	fflush(stdout);
+	fflush(stderr);
+
+	for (next = running = 0; (next < njobs) || running; ) {
+		while ((next < njobs) && (running < batch_jobs)) {
+			job = &jobs[next++];
+			gettimeofday(&job->start, NULL);
+			if ((pid = fork()) == 0)
+				batch_exec(job, wargv, wargc);
+			else if (pid < 0) {
+				error(INFO, "%s: fork: %s\n", job->dumpfile,
+					strerror(errno));
+				job->status = -1;
+				job->end = job->start;
+				continue;
+			}
+			job->pid = pid;
+			running++;
+		}
+
+		if (!running)
+			break;
+
+		if ((pid = waitpid(-1, &status, 0)) < 0) {
+			if (errno == EINTR)
+				continue;
+			error(FATAL, "waitpid: %s\n", strerror(errno));
+		}
+
+		gettimeofday(&now, NULL);
+		for (j = 0; j < next; j++) {
+			if (jobs[j].pid == pid) {
+				jobs[j].status = status;
+				jobs[j].end = now;
+				jobs[j].pid = 0;
+				running--;
+				break;
+			}
+		}
+	}
+
+	fprintf(fp, "%d dumpfile%s, %d job%s, output in %s\n\n", njobs,
+		njobs > 1 ? "s" : "", batch_jobs, batch_jobs > 1 ? "s" : "",
+		batch_dir);
+	fprintf(fp, "  STATUS   ELAPSED  DUMPFILE / OUTPUT\n");
+	for (i = failed = 0; i < njobs; i++) {
+		job = &jobs[i];
+		if (job->status < 0)
+			sprintf(buf, "fork");
+		else if (WIFEXITED(job->status))
+			sprintf(buf, "exit %d", WEXITSTATUS(job->status));
+		else if (WIFSIGNALED(job->status))
+			sprintf(buf, "sig %d", WTERMSIG(job->status));
+		else
+			sprintf(buf, "?");
+		if ((job->status < 0) || !WIFEXITED(job->status) || 
+		    WEXITSTATUS(job->status))
+			failed++;
+		fprintf(fp, "  %-7s %8.2fs  %s\n", buf,
+			(double)(job->end.tv_sec - job->start.tv_sec) +
+			(double)(job->end.tv_usec - job->start.tv_usec)/1000000,
+			job->dumpfile);
+		fprintf(fp, "                    %s\n", job->output);
+	}
+
+	clean_exit(failed ? 1 : 0);
+}
+
+/*
+ *  Run the "test" command without a kernel session, i.e., to generate
+ *  and benchmark synthetic dumpfiles, and exit.
+ */
+static void
+run_test(char *arglist)
+{
+	char *buf;
+
+	if ((buf = malloc(strlen("test ") + strlen(arglist) + 1)) == NULL)
+		error(FATAL, "cannot malloc --test argument buffer\n");
+	sprintf(buf, "test %s", arglist);
+
+	if (setjmp(pc->main_loop_env))
+		clean_exit(1);
+
+	argcnt = parse_line(buf, args);
+	optind = 0;
+	pc->curcmd = "test";
+	cmd_test();
+
+	fflush(fp);
+	clean_exit(0);
+}
@@ -265,6 +265,11 @@ int section_has_mem_map(ulong);
 ulong section_mem_map_addr(ulong);
 ulong valid_section_nr(ulong);
 ulong pfn_to_map(ulong);
+static void mem_section_table_init(void);
+static struct mem_section_entry *mem_section_entry(ulong);
+static struct mem_section_entry *mem_section_entry_addr(ulong);
+static ulong mem_section_limit(void);
+static void dump_mem_section_table(void);
 static int get_nodes_online(void);
 static int next_online_node(int);
 static ulong next_online_pgdat(int);
@@ -292,6 +297,14 @@ static void dump_per_cpu_offsets(void);
 static void dump_page_flags(ulonglong);
 static ulong kmem_cache_nodelists(ulong);
 static void dump_hstates(void);
+static int live_cache_active(int);
+static int live_cache_read(int, char *, int, ulong, physaddr_t);
+static void live_cache_invalidate(physaddr_t);
+static void dump_live_cache(void);
+struct mm_usage;
+static struct mm_usage *mm_usage_lookup(int, ulong);
+static long tgid_split_rss(ulong);
+static void dump_mm_usage_cache(void);
 
 /*
  *  Memory display modes specific to this file.
@@ -2082,7 +2095,7 @@ int
 readmem(ulonglong addr, int memtype, void *buffer, long size,
 	char *type, ulong error_handle)
 {
-	int fd;
+	int fd, ret;
 	long cnt, orig_size;
 	physaddr_t paddr;
 	ulonglong pseudo;
@@ -2132,6 +2145,10 @@ readmem(ulonglong addr, int memtype, void *buffer, long size,
                                 error(INFO, INVALID_KVADDR, addr, type);
                         goto readmem_error;
                 }
+
+		if ((pc->flags2 & VMLINUX_TEXT) &&
+		    vmlinux_text_read(addr, buffer, size))
+			return TRUE;
                 break;
 
         case PHYSADDR:
@@ -2195,8 +2212,14 @@ readmem(ulonglong addr, int memtype, void *buffer, long size,
 		else
 			pc->curcmd_flags &= ~MEMTYPE_KVADDR;
 
-		switch (READMEM(fd, bufptr, cnt, 
-		    (memtype == PHYSADDR) || (memtype == XENMACHADDR) ? 0 : addr, paddr))
+		if (live_cache_active(memtype))
+			ret = live_cache_read(fd, bufptr, cnt, 
+				memtype == PHYSADDR ? 0 : addr, paddr);
+		else
+			ret = READMEM(fd, bufptr, cnt, (memtype == PHYSADDR) || 
+				(memtype == XENMACHADDR) ? 0 : addr, paddr);
+
+		switch (ret)
 		{
 		case SEEK_ERROR:
                         if (PRINT_ERROR_MESSAGE)
@@ -2249,6 +2272,149 @@ readmem_error:
 	return FALSE;
 }
 
+/*
+ *  Per-command page cache for live systems.  Live memory can change at 
+ *  any time, so the cache is cleared before each command and each foreach
+ *  iteration; within a command, repeated reads of the same task_struct,
+ *  mm_struct or page table pages are satisfied without a system call.
+ *  "set live_cache off" disables it, and "set live_cache frozen" keeps
+ *  its contents across commands.
+ */
+#define LIVE_CACHE_BYTES    (4*1024*1024)
+#define LIVE_CACHE_INVALID  ((physaddr_t)(-1))
+
+static struct live_cache {
+	int entries;
+	physaddr_t *tag;
+	char *data;
+	ulong hits;
+	ulong fills;
+	ulong clears;
+} live_cache = { 0 };
+
+static int
+live_cache_active(int memtype)
+{
+	int i;
+
+	if (!ACTIVE() || REMOTE_MEMSRC() || (memtype == XENMACHADDR) ||
+	    (pc->flags2 & LIVE_CACHE_OFF) || !PAGESIZE())
+		return FALSE;
+
+	if ((pc->readmem != read_dev_mem) && 
+	    (pc->readmem != read_memory_device) &&
+	    (pc->readmem != read_proc_kcore))
+		return FALSE;
+
+	if (live_cache.entries)
+		return TRUE;
+
+	live_cache.entries = MAX(LIVE_CACHE_BYTES/PAGESIZE(), 64);
+	if (!(live_cache.tag = (physaddr_t *)
+	    malloc(sizeof(physaddr_t) * live_cache.entries)) ||
+	    !(live_cache.data = (char *)
+	    malloc((size_t)live_cache.entries * PAGESIZE()))) {
+		error(INFO, "cannot malloc live memory cache\n");
+		if (live_cache.tag)
+			free(live_cache.tag);
+		live_cache.tag = NULL;
+		live_cache.entries = 0;
+		pc->flags2 |= LIVE_CACHE_OFF;
+		return FALSE;
+	}
+
+	for (i = 0; i < live_cache.entries; i++)
+		live_cache.tag[i] = LIVE_CACHE_INVALID;
+
+	return TRUE;
+}
+
+/*
+ *  Read the whole page containing paddr into its cache slot, and copy 
+ *  the request from there.  If the whole page cannot be read, fall back
+ *  to reading just the request.
+ */
+static int
+live_cache_read(int fd, char *bufptr, int cnt, ulong addr, physaddr_t paddr)
+{
+	physaddr_t page;
+	ulong offset, curcmd_flags;
+	char *data;
+	int i;
+
+	offset = PAGEOFFSET(paddr);
+	page = paddr - offset;
+	i = (int)((page >> PAGESHIFT()) & (live_cache.entries-1));
+	data = live_cache.data + ((ulong)i * PAGESIZE());
+
+	if (live_cache.tag[i] == page) {
+		live_cache.hits++;
+		BCOPY(data + offset, bufptr, cnt);
+		return cnt;
+	}
+
+	curcmd_flags = pc->curcmd_flags;
+
+	if (READMEM(fd, data, PAGESIZE(), addr ? addr - offset : 0, 
+	    page) == PAGESIZE()) {
+		live_cache.tag[i] = page;
+		live_cache.fills++;
+		BCOPY(data + offset, bufptr, cnt);
+		return cnt;
+	}
+
+	live_cache.tag[i] = LIVE_CACHE_INVALID;
+	pc->curcmd_flags = curcmd_flags;
+
+	return READMEM(fd, bufptr, cnt, addr, paddr);
+}
+
+static void
+live_cache_invalidate(physaddr_t paddr)
+{
+	physaddr_t page;
+	int i;
+
+	if (!live_cache.entries)
+		return;
+
+	page = paddr - PAGEOFFSET(paddr);
+	i = (int)((page >> PAGESHIFT()) & (live_cache.entries-1));
+	if (live_cache.tag[i] == page)
+		live_cache.tag[i] = LIVE_CACHE_INVALID;
+}
+
+/*
+ *  Clear the live memory cache -- a no-op if DUMPFILE(), or if the
+ *  cache has been frozen.
+ */
+void
+clear_live_cache(void)
+{
+	int i;
+
+	if (!live_cache.entries || (pc->flags2 & LIVE_CACHE_FROZEN))
+		return;
+
+	for (i = 0; i < live_cache.entries; i++)
+		live_cache.tag[i] = LIVE_CACHE_INVALID;
+	live_cache.clears++;
+}
+
+static void
+dump_live_cache(void)
+{
+	fprintf(fp, "         live_cache: %s\n", 
+		pc->flags2 & LIVE_CACHE_OFF ? "off" :
+		pc->flags2 & LIVE_CACHE_FROZEN ? "frozen" : "on");
+	if (!live_cache.entries)
+		return;
+	fprintf(fp, "            entries: %d\n", live_cache.entries);
+	fprintf(fp, "               hits: %ld\n", live_cache.hits);
+	fprintf(fp, "              fills: %ld\n", live_cache.fills);
+	fprintf(fp, "             clears: %ld\n", live_cache.clears);
+}
+
 /*
  *  Accept anything...
  */
@@ -2754,6 +2920,8 @@ writemem(ulonglong addr, int memtype, void *buffer, long size,
                 if (cnt > size)
                         cnt = size;
 
+		live_cache_invalidate(paddr);
+
 		switch (pc->writemem(fd, bufptr, cnt, addr, paddr))
 		{
 		case SEEK_ERROR:
@@ -2917,6 +3085,64 @@ uvtop(struct task_context *tc, ulong vaddr, physaddr_t *paddr, int verbose)
 	return(machdep->uvtop(tc, vaddr, paddr, verbose));
 }
 
+/*
+ *  Quietly translate a user virtual address as uvtop() does, but from a
+ *  stash of translations gathered by the machine-specific uvtop_range()
+ *  function, which descends the page tables once for each page table
+ *  page, huge page, or unpopulated span instead of once per page.  The
+ *  end argument limits how far the span may extend.  Upon return, *next
+ *  contains the next user virtual page that may be mapped.
+ */
+static struct uvtop_range uvtop_range_data = { 0 };
+
+int
+uvtop_range_lookup(struct task_context *tc, ulong vaddr, ulong end, 
+	physaddr_t *paddr, ulong *next)
+{
+	struct uvtop_range *ur;
+	ulong page, i;
+
+	ur = &uvtop_range_data;
+	page = VIRTPAGEBASE(vaddr);
+	*next = page + PAGESIZE();
+
+	if (!machdep->uvtop_range || !tc || !tc->mm_struct || IS_KVADDR(vaddr))
+		return uvtop(tc, vaddr, paddr, 0);
+
+	if (!ur->type || (ur->mm != tc->mm_struct) || 
+	    (ur->cmdgen != pc->cmdgencur) || 
+	    (page < ur->start) || (page >= ur->end)) {
+		if (!machdep->uvtop_range(tc, page, MAX(end, *next), ur)) {
+			ur->type = 0;
+			return uvtop(tc, vaddr, paddr, 0);
+		}
+		ur->mm = tc->mm_struct;
+		ur->cmdgen = pc->cmdgencur;
+	}
+
+	switch (ur->type)
+	{
+	case UVTOP_RANGE_HUGE:
+		*paddr = ur->base + (vaddr - ur->start);
+		return TRUE;
+
+	case UVTOP_RANGE_PTES:
+		i = (page - ur->start) / PAGESIZE();
+		if (!ur->mapped[i]) {
+			*paddr = ur->paddr[i];
+			return FALSE;
+		}
+		*paddr = ur->paddr[i] + PAGEOFFSET(vaddr);
+		return TRUE;
+
+	case UVTOP_RANGE_UNMAPPED:
+	default:
+		*paddr = 0;
+		*next = ur->end;
+		return FALSE;
+	}
+}
+
 /*
  *  The vtop command does a verbose translation of a user or kernel virtual
  *  address into it physical address.  The pte translation is shown by
@@ -3972,9 +4198,10 @@ vm_area_page_dump(ulong vma,
 		  struct reference *ref)
 {
 	physaddr_t paddr;
-	ulong offs;
+	ulong offs, next;
 	char *p1, *p2;
 	int display;
+	struct task_context *tc;
 	char buf1[BUFSIZE];
 	char buf2[BUFSIZE];
 	char buf3[BUFSIZE];
@@ -3983,6 +4210,8 @@ vm_area_page_dump(ulong vma,
 	if (mm == symbol_value("init_mm"))
 		return FALSE;
 
+	tc = task_to_context(task);
+
 	if (!ref || DO_REF_DISPLAY(ref))
 		fprintf(fp, "%s  %s\n",
 			mkstring(buf1, UVADDR_PRLEN, LJUST, "VIRTUAL"),
@@ -4007,7 +4236,7 @@ vm_area_page_dump(ulong vma,
 			}
 		}
 
-                if (uvtop(task_to_context(task), start, &paddr, 0)) {
+                if (uvtop_range_lookup(tc, start, end, &paddr, &next)) {
 			sprintf(buf3, "%s  %s\n",
 				mkstring(buf1, UVADDR_PRLEN, LJUST|LONG_HEX,
 				MKSTR(start)),
@@ -4487,6 +4716,130 @@ unsupported:
 	return bufferindex += sprintf(outputbuffer+bufferindex, "\n");
 }
 
+/*
+ *  Per-command cache of memory usage data.  Every thread of a process
+ *  shares its mm_struct, and with SPLIT_RSS_COUNTING each thread group's
+ *  task_struct.rss_stat counters are summed for every one of its threads.
+ *  The mm_struct counters are therefore cached by mm_struct address, and
+ *  the summed task rss_stat counters by tgid, so that each is gathered
+ *  just once per command.  The tables are malloc'd, since foreach frees
+ *  all GETBUF() buffers between tasks, and are cleared whenever a new
+ *  command is run.
+ */
+struct mm_usage {
+	ulong key;
+	ulong rss;
+	ulong total_vm;
+	ulong pgd;
+	int valid;
+};
+
+static struct mm_usage_cache {
+	ulong cmdgen;
+	ulong slots;
+	ulong size;
+	struct mm_usage *mm;
+	struct mm_usage *tgid;
+	ulong hits;
+	ulong fills;
+} mm_usage_cache = { 0 };
+
+static struct mm_usage *
+mm_usage_lookup(int tgid, ulong key)
+{
+	struct mm_usage_cache *mc;
+	struct mm_usage *table, *mu;
+	ulong i, slot, slots;
+
+	mc = &mm_usage_cache;
+	if ((mc->cmdgen != pc->cmdgencur) || !mc->mm) {
+		for (slots = 256; 
+		     slots < (RUNNING_TASKS() + RUNNING_TASKS()/2); 
+		     slots <<= 1)
+			;
+		if (slots > mc->size) {
+			mc->slots = mc->size = 0;
+			if (!(mu = realloc(mc->mm, 
+			    sizeof(struct mm_usage) * slots)))
+				return NULL;
+			mc->mm = mu;
+			if (!(mu = realloc(mc->tgid, 
+			    sizeof(struct mm_usage) * slots)))
+				return NULL;
+			mc->tgid = mu;
+			mc->size = slots;
+		}
+		mc->slots = slots;
+		BZERO(mc->mm, sizeof(struct mm_usage) * slots);
+		BZERO(mc->tgid, sizeof(struct mm_usage) * slots);
+		mc->cmdgen = pc->cmdgencur;
+	}
+
+	table = tgid ? mc->tgid : mc->mm;
+	slot = ((key >> 6) ^ (key >> 20) ^ key) & (mc->slots - 1);
+
+	for (i = 0; i < mc->slots; i++) {
+		mu = &table[(slot + i) & (mc->slots - 1)];
+		if (!mu->valid) {
+			mu->key = key;
+			return mu;
+		}
+		if (mu->key == key) {
+			mc->hits++;
+			return mu;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ *  Sum the task_struct.rss_stat counters of all threads in a thread group.
+ */
+static long
+tgid_split_rss(ulong task)
+{
+	int sync_rss[2];
+	long rss;
+	struct tgid_context tgid, *tgid_array, *tg, *first, *last;
+
+	rss = 0;
+	tgid_array = tt->tgid_array;
+	tgid.tgid = task_tgid(task);
+
+	if (!(tg = tgid_quick_search(tgid.tgid)))
+		tg = (struct tgid_context *)bsearch(&tgid, tgid_array, RUNNING_TASKS(), 
+			sizeof(struct tgid_context), sort_by_tgid);
+
+	if (!tg)
+		return rss;
+
+	/* find the first element which has the same tgid */
+	first = tg;
+	while ((first > tgid_array) && ((first - 1)->tgid == first->tgid)) 
+		first--;
+
+	/* find the last element which have same tgid */
+	last = tg;
+	while ((last < (tgid_array + (RUNNING_TASKS() - 1))) && 
+		(last->tgid == (last + 1)->tgid))
+		last++;
+
+	/* count 0 -> filepages, count 1 -> anonpages */
+	for (tg = first; tg <= last; tg++) {
+		if (!readmem(tg->task + OFFSET(task_struct_rss_stat) +
+		    OFFSET(task_rss_stat_count), KVADDR, sync_rss,
+		    sizeof(int) * 2, "task_struct rss_stat", RETURN_ON_ERROR))
+			continue;
+
+		rss += sync_rss[0] + sync_rss[1];
+	}
+
+	tt->last_tgid = last;
+
+	return rss;
+}
+
 /*
  *  Fill in the task_mem_usage structure with the RSS, virtual memory size,
  *  percent of physical memory being used, and the mm_struct address.
@@ -4495,6 +4848,8 @@ void
 get_task_mem_usage(ulong task, struct task_mem_usage *tm)
 {
 	struct task_context *tc;
+	struct mm_usage *mu, *tu;
+	ulong mm;
 	long rss = 0;
 
 	BZERO(tm, sizeof(struct task_mem_usage));
@@ -4509,105 +4864,76 @@ get_task_mem_usage(ulong task, struct task_mem_usage *tm)
 
 	tm->mm_struct_addr = tc->mm_struct;
 
-	if (!task_mm(task, TRUE))
+	if (!(mm = task_mm(task, FALSE)))
 		return;
 
-	if (VALID_MEMBER(mm_struct_rss))
-		/*  
-		 *  mm_struct.rss or mm_struct._rss exist. 
-		 */
-        	tm->rss = ULONG(tt->mm_struct + OFFSET(mm_struct_rss));
-	else {
-		/*
-		 *  Latest kernels have mm_struct.mm_rss_stat[].
-		 */ 
-		if (VALID_MEMBER(mm_struct_rss_stat)) {
-			long anonpages, filepages;
-
-			anonpages = tt->anonpages;
-			filepages = tt->filepages;
-			rss += LONG(tt->mm_struct +
-				OFFSET(mm_struct_rss_stat) +
-				OFFSET(mm_rss_stat_count) +
-				(filepages * sizeof(long)));
-			rss += LONG(tt->mm_struct +
-				OFFSET(mm_struct_rss_stat) +
-				OFFSET(mm_rss_stat_count) +
-				(anonpages * sizeof(long)));
-		}
-
-		/* Check whether SPLIT_RSS_COUNTING is enabled */
-		if (VALID_MEMBER(task_struct_rss_stat)) {
-			int sync_rss;
-			struct tgid_context tgid, *tgid_array, *tg, *first, *last;
-
-			tgid_array = tt->tgid_array;
-			tgid.tgid = task_tgid(task);
-
-			if (!(tg = tgid_quick_search(tgid.tgid)))
-				tg = (struct tgid_context *)bsearch(&tgid, tgid_array, RUNNING_TASKS(), 
-					sizeof(struct tgid_context), sort_by_tgid);
-
-			if (tg) {
-				/* find the first element which has the same tgid */
-				first = tg;
-				while ((first > tgid_array) && ((first - 1)->tgid == first->tgid)) 
-					first--;
-
-				/* find the last element which have same tgid */
-				last = tg;
-				while ((last < (tgid_array + (RUNNING_TASKS() - 1))) && 
-					(last->tgid == (last + 1)->tgid))
-					last++;
-
-				while (first <= last)
-				{
-					/* count 0 -> filepages */
-					if (!readmem(first->task +
-						OFFSET(task_struct_rss_stat) +
-						OFFSET(task_rss_stat_count), KVADDR,
-						&sync_rss,
-						sizeof(int),
-						"task_struct rss_stat MM_FILEPAGES",
-						RETURN_ON_ERROR))
-							continue;
+	if (!(mu = mm_usage_lookup(FALSE, mm)) || !mu->valid) {
+		fill_mm_struct(mm);
 
-					rss += sync_rss;
-
-					/* count 1 -> anonpages */
-					if (!readmem(first->task +
-						OFFSET(task_struct_rss_stat) +
-						OFFSET(task_rss_stat_count) +
-						sizeof(int),
-						KVADDR, &sync_rss,
-						sizeof(int),
-						"task_struct rss_stat MM_ANONPAGES",
-						RETURN_ON_ERROR))
-							continue;
+		if (VALID_MEMBER(mm_struct_rss))
+			/*  
+			 *  mm_struct.rss or mm_struct._rss exist. 
+			 */
+			rss = ULONG(tt->mm_struct + OFFSET(mm_struct_rss));
+		else {
+			/*
+			 *  Latest kernels have mm_struct.mm_rss_stat[].
+			 */ 
+			if (VALID_MEMBER(mm_struct_rss_stat)) {
+				long anonpages, filepages;
+
+				anonpages = tt->anonpages;
+				filepages = tt->filepages;
+				rss += LONG(tt->mm_struct +
+					OFFSET(mm_struct_rss_stat) +
+					OFFSET(mm_rss_stat_count) +
+					(filepages * sizeof(long)));
+				rss += LONG(tt->mm_struct +
+					OFFSET(mm_struct_rss_stat) +
+					OFFSET(mm_rss_stat_count) +
+					(anonpages * sizeof(long)));
+			}
 
-					rss += sync_rss;
+			/*  
+			 *  mm_struct._anon_rss and mm_struct._file_rss should exist. 
+			 */
+			if (VALID_MEMBER(mm_struct_anon_rss))
+				rss +=  LONG(tt->mm_struct + OFFSET(mm_struct_anon_rss));
+			if (VALID_MEMBER(mm_struct_file_rss))
+				rss +=  LONG(tt->mm_struct + OFFSET(mm_struct_file_rss));
+		}
 
-					if (first == last)
-						break;
-					first++;
-				}
+		tm->rss = (unsigned long)rss;
+		tm->total_vm = ULONG(tt->mm_struct + OFFSET(mm_struct_total_vm));
+		tm->pgd_addr = ULONG(tt->mm_struct + OFFSET(mm_struct_pgd));
 
-				tt->last_tgid = last;
-			}
+		if (mu) {
+			mu->rss = tm->rss;
+			mu->total_vm = tm->total_vm;
+			mu->pgd = tm->pgd_addr;
+			mu->valid = TRUE;
+			mm_usage_cache.fills++;
 		}
+	} else {
+		tm->rss = mu->rss;
+		tm->total_vm = mu->total_vm;
+		tm->pgd_addr = mu->pgd;
+	}
+
+	/* Check whether SPLIT_RSS_COUNTING is enabled */
+	if (!VALID_MEMBER(mm_struct_rss) && VALID_MEMBER(task_struct_rss_stat)) {
+		if (!(tu = mm_usage_lookup(TRUE, task_tgid(task))) || !tu->valid) {
+			rss = tgid_split_rss(task);
+			if (tu) {
+				tu->rss = (ulong)rss;
+				tu->valid = TRUE;
+				mm_usage_cache.fills++;
+			}
+		} else
+			rss = (long)tu->rss;
 
-		/*  
-		 *  mm_struct._anon_rss and mm_struct._file_rss should exist. 
-		 */
-		if (VALID_MEMBER(mm_struct_anon_rss))
-			rss +=  LONG(tt->mm_struct + OFFSET(mm_struct_anon_rss));
-		if (VALID_MEMBER(mm_struct_file_rss))
-			rss +=  LONG(tt->mm_struct + OFFSET(mm_struct_file_rss));
-
-		tm->rss = (unsigned long)rss;
+		tm->rss += (ulong)rss;
 	}
-        tm->total_vm = ULONG(tt->mm_struct + OFFSET(mm_struct_total_vm));
-        tm->pgd_addr = ULONG(tt->mm_struct + OFFSET(mm_struct_pgd));
 
 	if (is_kernel_thread(task))
 		return;
@@ -4617,6 +4943,14 @@ get_task_mem_usage(ulong task, struct task_mem_usage *tm)
 		vt->num_physpages ? vt->num_physpages : vt->total_pages)));
 }
 
+static void
+dump_mm_usage_cache(void)
+{
+	fprintf(fp, "     mm_usage_cache: %ld slots\n", mm_usage_cache.slots);
+	fprintf(fp, "               hits: %ld\n", mm_usage_cache.hits);
+	fprintf(fp, "              fills: %ld\n", mm_usage_cache.fills);
+}
+
 
 /*
  *  cmd_kmem() is designed as a multi-purpose kernel memory investigator with
@@ -5385,7 +5719,7 @@ dump_mem_map_SPARSEMEM(struct meminfo *mi)
 	done = FALSE;
 	total_pages = 0;
 
-	nr_mem_sections = NR_MEM_SECTIONS();
+	nr_mem_sections = mem_section_limit();
 
 	bufferindex = 0;
 
@@ -11810,9 +12144,11 @@ verify_slab_overload_page(struct meminfo *si, ulong last, int s)
 	ulong s_mem;
 	char *list;
 	int errcnt;
+	struct arena_scope scope;
 
 	list = slab_chain_name_v2[s];
-	page_buf = GETBUF(SIZE(page));
+	arena_scope_begin(&scope);
+	page_buf = ARENA_ALLOC(SIZE(page));
 
 	errcnt = 0;
 
@@ -11820,7 +12156,7 @@ verify_slab_overload_page(struct meminfo *si, ulong last, int s)
             SIZE(page), "page (slab) buffer", QUIET|RETURN_ON_ERROR)) {
                 error(INFO, "%s: %s list: bad slab pointer: %lx\n",
                         si->curname, list, si->slab);
-		FREEBUF(page_buf);
+		arena_scope_end(&scope);
 		return FALSE;
         }                        
 
@@ -11890,7 +12226,7 @@ no_inuse_check_v2:
 
 	si->errors += errcnt;
 
-	FREEBUF(page_buf);
+	arena_scope_end(&scope);
 
 	return(errcnt ? FALSE : TRUE);
 }
@@ -13190,7 +13526,7 @@ is_page_ptr(ulong addr, physaddr_t *phys)
 	physaddr_t section_paddr;
 
 	if (IS_SPARSEMEM()) {
-		nr_mem_sections = NR_MEM_SECTIONS();
+		nr_mem_sections = mem_section_limit();
 	        for (nr = 0; nr < nr_mem_sections ; nr++) {
 	                if ((sec_addr = valid_section_nr(nr))) {
 	                        coded_mem_map = section_mem_map_addr(sec_addr);
@@ -13548,6 +13884,9 @@ dump_vm_table(int verbose)
 			vt->pageflags_data[i].name);
 	}
 
+	dump_live_cache();
+	dump_mm_usage_cache();
+	dump_mem_section_table();
 	dump_vma_cache(VERBOSE);
 }
 
@@ -14725,7 +15064,7 @@ static void
 search_virtual(struct searchinfo *si)
 {
 	ulong start, end;
-	ulong pp, next, *ubp;
+	ulong pp, next, nextpp, *ubp;
 	int wordcnt, lastpage;
 	ulong page;
 	physaddr_t paddr; 
@@ -14776,8 +15115,13 @@ search_virtual(struct searchinfo *si)
                 switch (si->memtype)
                 {
                 case UVADDR:
-                        if (!uvtop(CURRENT_CONTEXT(), pp, &paddr, 0) ||
-                            !phys_to_page(paddr, &page)) { 
+                        if (!uvtop_range_lookup(CURRENT_CONTEXT(), pp, end, 
+			    &paddr, &nextpp) || !phys_to_page(paddr, &page)) { 
+				/*
+				 *  Skip an unpopulated page table span.
+				 */
+				if (nextpp > (pp + PAGESIZE()))
+					pp = nextpp - PAGESIZE();
 				if (!next_upage(CURRENT_CONTEXT(), pp, &pp)) 
 					goto done;
                                 continue;
@@ -15617,8 +15961,10 @@ vma_file_offset(ulong vma, ulong vaddr, char *buf)
 {
 	ulong vm_file, vm_start, vm_offset, vm_pgoff, dentry, offset;
 	ulong vfsmnt;
-	char file[BUFSIZE];
 	char *vma_buf, *file_buf;
+	static char file[BUFSIZE];
+	static ulong last_file = 0;
+	static ulong cmdgencur = BADVAL;
 
 	if (!vma)
 		return NULL;
@@ -15636,12 +15982,20 @@ vma_file_offset(ulong vma, ulong vaddr, char *buf)
 	if (!dentry) 
 		goto no_file_offset;
 
-	file[0] = NULLCHAR;
-	if (VALID_MEMBER(file_f_vfsmnt)) {
-        	vfsmnt = ULONG(file_buf + OFFSET(file_f_vfsmnt));
-               	get_pathname(dentry, file, BUFSIZE, 1, vfsmnt);
-	} else 
-               	get_pathname(dentry, file, BUFSIZE, 1, 0);
+	/*
+	 *  vm -p calls this for every page of a vma, so the pathname of
+	 *  the backing file is only gathered once per file per command.
+	 */
+	if ((vm_file != last_file) || (cmdgencur != pc->cmdgencur)) {
+		file[0] = NULLCHAR;
+		if (VALID_MEMBER(file_f_vfsmnt)) {
+        		vfsmnt = ULONG(file_buf + OFFSET(file_f_vfsmnt));
+               		get_pathname(dentry, file, BUFSIZE, 1, vfsmnt);
+		} else 
+               		get_pathname(dentry, file, BUFSIZE, 1, 0);
+		last_file = vm_file;
+		cmdgencur = pc->cmdgencur;
+	}
 
 	if (!strlen(file)) 
 		goto no_file_offset;
@@ -16727,6 +17081,17 @@ dumpfile_memory(int cmd)
 /* 
  *  Functions for sparse mem support 
  */
+
+/*
+ * We use the lower bits of the mem_map pointer to store
+ * a little bit of information.  There should be at least
+ * 3 bits here due to 32-bit alignment.
+ */
+#define SECTION_MARKED_PRESENT	(1UL<<0)
+#define SECTION_HAS_MEM_MAP	(1UL<<1)
+#define SECTION_MAP_LAST_BIT	(1UL<<2)
+#define SECTION_MAP_MASK	(~(SECTION_MAP_LAST_BIT-1))
+
 ulong 
 sparse_decode_mem_map(ulong coded_mem_map, ulong section_nr)
 {
@@ -16783,6 +17148,219 @@ sparse_mem_init(void)
 	addr = symbol_value("mem_section");
 	readmem(addr, KVADDR,vt->mem_sec ,mem_section_size,
 		"memory section root table", FAULT_ON_ERROR);
+
+	mem_section_table_init();
+}
+
+/*
+ *  The section_mem_map of every mem_section is decoded once into a
+ *  table indexed by section number, which runs up to the highest
+ *  section in use.  Each SPARSEMEM_EX root is read with a single
+ *  readmem(); the static mem_section[] array of other kernels has
+ *  already been read into vt->mem_sec.  On live systems vt->mem_sec
+ *  and the table are refreshed for each command, since memory may be
+ *  hot-(un)plugged.
+ *  If any root cannot be read, the table is not used and each
+ *  mem_section is read individually as before.
+ */
+struct mem_section_entry {
+	ulong addr;		/* mem_section address */
+	ulong coded;		/* section_mem_map contents */
+	ulong mem_map;		/* decoded mem_map base */
+};
+
+static struct mem_section_table {
+	int valid;
+	struct mem_section_entry *table;
+	ulong count;
+	ulong size;
+	ulong last;
+	ulong cmdgen;
+	ulong builds;
+	ulong hits;
+	ulong misses;
+} mem_section_table = { 0 };
+
+static void
+mem_section_table_build(void)
+{
+	struct mem_section_table *mst;
+	struct mem_section_entry *mse;
+	ulong *mem_sec;
+	ulong root, roots, nr, count, per_root, addr, base;
+	char *buf, *ms;
+
+	mst = &mem_section_table;
+	mst->valid = FALSE;
+	mst->cmdgen = pc->cmdgencur;
+	mem_sec = vt->mem_sec;
+	roots = NR_SECTION_ROOTS();
+	per_root = SECTIONS_PER_ROOT();
+
+	if (ACTIVE() && mst->builds &&
+	    !readmem(symbol_value("mem_section"), KVADDR, vt->mem_sec,
+	    IS_SPARSEMEM_EX() ? sizeof(void *) * roots : 
+	    SIZE(mem_section) * roots, "memory section root table",
+	    RETURN_ON_ERROR|QUIET))
+		return;
+
+	for (count = 0, root = 0; root < roots; root++) {
+		if (IS_SPARSEMEM_EX()) {
+			if (mem_sec[root] && IS_KVADDR(mem_sec[root]))
+				count = (root+1) * per_root;
+		} else if (ULONG((char *)vt->mem_sec + (root * SIZE(mem_section)) +
+		    OFFSET(mem_section_section_mem_map)))
+			count = root+1;
+	}
+	count = MIN(count, NR_MEM_SECTIONS());
+
+	if (count > mst->size) {
+		if (!(mse = realloc(mst->table,
+		    count * sizeof(struct mem_section_entry)))) {
+			error(INFO, "cannot malloc mem_section table\n");
+			return;
+		}
+		mst->table = mse;
+		mst->size = count;
+	}
+	if (count)
+		BZERO(mst->table, count * sizeof(struct mem_section_entry));
+	mst->count = count;
+
+	if (IS_SPARSEMEM_EX()) {
+		buf = GETBUF(per_root * SIZE(mem_section));
+		base = 0;
+	} else {
+		buf = NULL;
+		base = symbol_value("mem_section");
+	}
+
+	for (root = 0; (root * per_root) < count; root++) {
+		if (IS_SPARSEMEM_EX()) {
+			if (!mem_sec[root] || !IS_KVADDR(mem_sec[root]))
+				continue;
+			if (!readmem(mem_sec[root], KVADDR, buf,
+			    per_root * SIZE(mem_section), "memory section root",
+			    RETURN_ON_ERROR|QUIET)) {
+				FREEBUF(buf);
+				return;
+			}
+			ms = buf;
+			addr = mem_sec[root];
+		} else {
+			ms = (char *)vt->mem_sec + (root * SIZE(mem_section));
+			addr = base + (root * SIZE(mem_section));
+		}
+
+		for (nr = root * per_root; 
+		     (nr < count) && (nr < (root+1) * per_root); 
+		     nr++, ms += SIZE(mem_section), addr += SIZE(mem_section)) {
+			mse = &mst->table[nr];
+			mse->addr = addr;
+			mse->coded = ULONG(ms + OFFSET(mem_section_section_mem_map));
+			if (mse->coded)
+				mse->mem_map = sparse_decode_mem_map(mse->coded & 
+					SECTION_MAP_MASK, nr);
+		}
+	}
+
+	if (buf)
+		FREEBUF(buf);
+
+	mst->last = 0;
+	mst->valid = TRUE;
+	mst->builds++;
+}
+
+static void
+mem_section_table_init(void)
+{
+	mem_section_table_build();
+	if (!mem_section_table.valid)
+		error(WARNING, 
+		    "cannot decode mem_section table: reading sections individually\n");
+}
+
+static struct mem_section_table *
+get_mem_section_table(void)
+{
+	struct mem_section_table *mst;
+
+	mst = &mem_section_table;
+	if (ACTIVE() && (mst->cmdgen != pc->cmdgencur))
+		mem_section_table_build();
+
+	return mst->valid ? mst : NULL;
+}
+
+/*
+ *  Return the decoded entry for a section number, or NULL if the table
+ *  is unusable, in which case the caller falls back to reading the
+ *  mem_section.  Numbers beyond the end of the table are not in use,
+ *  and return an empty entry.
+ */
+static struct mem_section_entry *
+mem_section_entry(ulong nr)
+{
+	static struct mem_section_entry empty = { 0 };
+	struct mem_section_table *mst;
+
+	if (!(mst = get_mem_section_table()))
+		return NULL;
+
+	if (nr >= mst->count)
+		return &empty;
+
+	mst->last = nr;
+	return &mst->table[nr];
+}
+
+/*
+ *  The mem_section address-based functions are nearly always called
+ *  with the address just returned by valid_section_nr(), so check
+ *  the entry last looked up before falling back to a readmem().
+ */
+static struct mem_section_entry *
+mem_section_entry_addr(ulong addr)
+{
+	struct mem_section_table *mst;
+
+	if ((mst = get_mem_section_table()) && addr && 
+	    (mst->last < mst->count) && (mst->table[mst->last].addr == addr)) {
+		mst->hits++;
+		return &mst->table[mst->last];
+	}
+
+	mem_section_table.misses++;
+	return NULL;
+}
+
+/*
+ *  Section numbers from here up to NR_MEM_SECTIONS() are not in use,
+ *  so loops over all sections may stop here.
+ */
+static ulong
+mem_section_limit(void)
+{
+	struct mem_section_table *mst;
+
+	if ((mst = get_mem_section_table()))
+		return mst->count;
+
+	return NR_MEM_SECTIONS();
+}
+
+static void
+dump_mem_section_table(void)
+{
+	struct mem_section_table *mst;
+
+	mst = &mem_section_table;
+	fprintf(fp, "  mem_section_table: %s entries: %ld builds: %ld\n",
+		!IS_SPARSEMEM() ? "(not used)" : 
+		mst->valid ? "valid" : "invalid", mst->count, mst->builds);
+	fprintf(fp, "                     hits: %ld misses: %ld\n",
+		mst->hits, mst->misses);
 }
 
 char *
@@ -16832,22 +17410,16 @@ nr_to_section(ulong nr)
 	return addr;
 }
 
-/*
- * We use the lower bits of the mem_map pointer to store
- * a little bit of information.  There should be at least
- * 3 bits here due to 32-bit alignment.
- */
-#define SECTION_MARKED_PRESENT	(1UL<<0)
-#define SECTION_HAS_MEM_MAP	(1UL<<1)
-#define SECTION_MAP_LAST_BIT	(1UL<<2)
-#define SECTION_MAP_MASK	(~(SECTION_MAP_LAST_BIT-1))
-
 
 int 
 valid_section(ulong addr)
 {
+	struct mem_section_entry *mse;
 	char *mem_section;
 
+	if ((mse = mem_section_entry_addr(addr)))
+		return (mse->coded && SECTION_MARKED_PRESENT);
+
 	if ((mem_section = read_mem_section(addr)))
         	return (ULONG(mem_section + 
 			OFFSET(mem_section_section_mem_map)) && 
@@ -16858,8 +17430,12 @@ valid_section(ulong addr)
 int 
 section_has_mem_map(ulong addr)
 {
+	struct mem_section_entry *mse;
 	char *mem_section;
 
+	if ((mse = mem_section_entry_addr(addr)))
+		return (mse->coded && SECTION_HAS_MEM_MAP);
+
 	if ((mem_section = read_mem_section(addr)))
 		return (ULONG(mem_section + 
 			OFFSET(mem_section_section_mem_map))
@@ -16870,9 +17446,13 @@ section_has_mem_map(ulong addr)
 ulong 
 section_mem_map_addr(ulong addr)
 {   
+	struct mem_section_entry *mse;
 	char *mem_section;
 	ulong map;
 
+	if ((mse = mem_section_entry_addr(addr)))
+		return (mse->coded & SECTION_MAP_MASK);
+
 	if ((mem_section = read_mem_section(addr))) {
 		map = ULONG(mem_section + 
 			OFFSET(mem_section_section_mem_map));
@@ -16886,7 +17466,13 @@ section_mem_map_addr(ulong addr)
 ulong 
 valid_section_nr(ulong nr)
 {
-	ulong addr = nr_to_section(nr);
+	struct mem_section_entry *mse;
+	ulong addr;
+
+	if ((mse = mem_section_entry(nr)))
+		return (mse->coded ? mse->addr : 0);
+
+	addr = nr_to_section(nr);
 
 	if (valid_section(addr))
 		return addr;
@@ -16897,16 +17483,22 @@ valid_section_nr(ulong nr)
 ulong 
 pfn_to_map(ulong pfn)
 {
+	struct mem_section_entry *mse;
 	ulong section, page_offset;
 	ulong section_nr;
 	ulong coded_mem_map, mem_map;
 
 	section_nr = pfn_to_section_nr(pfn);
+	page_offset = pfn - section_nr_to_pfn(section_nr);
+
+	if ((mse = mem_section_entry(section_nr)))
+		return (mse->coded ? 
+			mse->mem_map + (page_offset * SIZE(page)) : 0);
+
 	if (!(section = valid_section_nr(section_nr))) 
 		return 0;
 
 	if (section_has_mem_map(section)) {
-		page_offset = pfn - section_nr_to_pfn(section_nr);
 		coded_mem_map = section_mem_map_addr(section);
 		mem_map = sparse_decode_mem_map(coded_mem_map, section_nr) +
 			(page_offset * SIZE(page));
@@ -16927,7 +17519,7 @@ dump_mem_sections(void)
 	char buf3[BUFSIZE];
 	char buf4[BUFSIZE];
 
-	nr_mem_sections = NR_MEM_SECTIONS();
+	nr_mem_sections = mem_section_limit();
 
 	fprintf(fp, "\n");
 	pad_line(fp, BITS32() ? 59 : 67, '-');
@@ -16965,7 +17557,7 @@ void
 list_mem_sections(void)
 {
 	ulong nr,addr;
-	ulong nr_mem_sections = NR_MEM_SECTIONS();
+	ulong nr_mem_sections = mem_section_limit();
 	ulong coded_mem_map;
 
 	for (nr = 0; nr <= nr_mem_sections ; nr++) {
@@ -17875,12 +18467,14 @@ get_kmem_cache_slub_data(long cmd, struct meminfo *si)
 	short inuse;
         ulong *nodes, *per_cpu;
 	struct node_table *nt;
+	struct arena_scope scope;
 
 	/*
 	 *  nodes[n] is not being used (for now)
 	 *  per_cpu[n] is a count of cpu_slab pages per node.
 	 */
-        nodes = (ulong *)GETBUF(2 * sizeof(ulong) * vt->numnodes);
+	arena_scope_begin(&scope);
+        nodes = (ulong *)ARENA_ZALLOC(2 * sizeof(ulong) * vt->numnodes);
         per_cpu = nodes + vt->numnodes;
 
 	total_slabs = total_objects = 0; 
@@ -17900,7 +18494,7 @@ get_kmem_cache_slub_data(long cmd, struct meminfo *si)
 			if (!readmem(cpu_slab_ptr + OFFSET(page_inuse), 
 			    KVADDR, &inuse, sizeof(short), 
 			    "page inuse", RETURN_ON_ERROR))
-				return FALSE;
+				goto bailout;
 			total_objects += inuse;
 			break;
 
@@ -17937,7 +18531,7 @@ get_kmem_cache_slub_data(long cmd, struct meminfo *si)
 		{
 		case GET_SLUB_OBJECTS:
 			if ((p = count_partial(node_ptr, si)) < 0)
-				return FALSE;
+				goto bailout;
 			total_objects += p;
 			break;
 
@@ -17975,11 +18569,11 @@ get_kmem_cache_slub_data(long cmd, struct meminfo *si)
 		break;
 	}
 
-	FREEBUF(nodes);
+	arena_scope_end(&scope);
 	return TRUE;
 
 bailout:
-	FREEBUF(nodes);
+	arena_scope_end(&scope);
 	return FALSE;
 }
 
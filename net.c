@@ -1340,14 +1340,9 @@ dump_sockets(ulong flag, struct reference *ref)
 void
 dump_sockets_workhorse(ulong task, ulong flag, struct reference *ref)
 {
-	ulong files_struct_addr = 0, fdtable_addr = 0;
-	int max_fdset = 0;
-	int max_fds = 0;
-	ulong open_fds_addr = 0;
-	fd_set open_fds;
-	ulong fd;
-	ulong file;
-	int i, j;
+	ulong files_struct_addr = 0;
+	struct task_fds tf;
+	int i;
 	int sockets_found = 0;
 	ulong value;
 
@@ -1371,56 +1366,13 @@ dump_sockets_workhorse(ulong task, ulong flag, struct reference *ref)
 	readmem(task + OFFSET(task_struct_files), KVADDR, &files_struct_addr,
             sizeof(void *), "task files contents", FAULT_ON_ERROR);
 
-        if (files_struct_addr) {
-                if (VALID_MEMBER(files_struct_max_fdset)) {
-		 	readmem(files_struct_addr + OFFSET(files_struct_max_fdset),
-		          	KVADDR, &max_fdset, sizeof(int),
-				"files_struct max_fdset", FAULT_ON_ERROR);
-		      	readmem(files_struct_addr + OFFSET(files_struct_max_fds),
-        	        	KVADDR, &max_fds, sizeof(int), "files_struct max_fds",
-                	   	FAULT_ON_ERROR);
-                }
-		else if (VALID_MEMBER(files_struct_fdt)) {
-			readmem(files_struct_addr + OFFSET(files_struct_fdt), KVADDR,
-				&fdtable_addr, sizeof(void *), "fdtable buffer",
-				FAULT_ON_ERROR);
-			if (VALID_MEMBER(fdtable_max_fdset))
-		      		readmem(fdtable_addr + OFFSET(fdtable_max_fdset),
-        	         		KVADDR, &max_fdset, sizeof(int),
-					"fdtable_struct max_fdset", FAULT_ON_ERROR);
-			else
-				max_fdset = -1;
-		      	readmem(fdtable_addr + OFFSET(fdtable_max_fds),
-	      	            	KVADDR, &max_fds, sizeof(int), "fdtable_struct max_fds",
-	               	    	FAULT_ON_ERROR);
-    		}
-	}
-
-	if ((VALID_MEMBER(files_struct_fdt) && !fdtable_addr) ||
-	    !files_struct_addr || (max_fdset == 0) || (max_fds == 0)) {
+	if (get_task_fds(files_struct_addr, &tf) == TASK_FDS_NONE) {
 		if (!NET_REFERENCE_CHECK(ref))
 			fprintf(fp, "No open sockets.\n");
 		return;
 	}
 
-	if (VALID_MEMBER(fdtable_open_fds)){
-		readmem(fdtable_addr + OFFSET(fdtable_open_fds), KVADDR,
-     	  		&open_fds_addr, sizeof(void *), "files_struct open_fds addr",
-	            	FAULT_ON_ERROR);
-		readmem(fdtable_addr + OFFSET(fdtable_fd), KVADDR, &fd,
-           		sizeof(void *), "files_struct fd addr", FAULT_ON_ERROR);
-	} else {
-		readmem(files_struct_addr + OFFSET(files_struct_open_fds), KVADDR,
-            		&open_fds_addr, sizeof(void *), "files_struct open_fds addr",
-	          	FAULT_ON_ERROR);
-		readmem(files_struct_addr + OFFSET(files_struct_fd), KVADDR, &fd,
-            		sizeof(void *), "files_struct fd addr", FAULT_ON_ERROR);
-	}
-
-	if (open_fds_addr) 
-		readmem(open_fds_addr, KVADDR, &open_fds, sizeof(fd_set),
-	               	"files_struct open_fds", FAULT_ON_ERROR);
-    	if (!open_fds_addr || !fd) { 
+    	if (tf.status == TASK_FDS_EMPTY) { 
 		if (!NET_REFERENCE_CHECK(ref))
 			fprintf(fp, "No open sockets.\n");
         	return;
@@ -1434,7 +1386,7 @@ dump_sockets_workhorse(ulong task, ulong flag, struct reference *ref)
 	                        ref->cmdflags |= NET_REF_HEXNUM;
 	                } else {
 	                        value = dtol(ref->str, FAULT_ON_ERROR, NULL);
-	                        if (value <= MAX(max_fdset, max_fds)) {
+	                        if (value <= tf.max_fds) {
 	                                ref->decval = value;
 	                                ref->cmdflags |= NET_REF_DECNUM;
 	                        } else {
@@ -1447,29 +1399,11 @@ dump_sockets_workhorse(ulong task, ulong flag, struct reference *ref)
 		ref->ref1 = task;
 	}
 
-    	j = 0;
-    	for (;;) {
-	        unsigned long set;
-	        i = j * __NFDBITS;
-	        if (((max_fdset >= 0) && (i >= max_fdset)) || (i >= max_fds))
-	            	break;
-	        set = open_fds.__fds_bits[j++];
-	        while (set) {
-	            	if (set & 1) {
-		                readmem(fd + i*sizeof(struct file *), KVADDR, 
-		                        &file, sizeof(struct file *), 
-		                        "fd file", FAULT_ON_ERROR);
-		                if (file) {
-		                    	if (sym_socket_dump(file, i, 
-					    sockets_found, flag, ref)) {
-		                        	sockets_found++;
-					}
-		                }
-	            	}
-	            	i++;
-	            	set >>= 1;
-	        }
-        }
+	for (i = 0; i < tf.count; i++) {
+		if (sym_socket_dump(tf.file[i], tf.fd[i], sockets_found, 
+		    flag, ref))
+			sockets_found++;
+	}
 
     	if (!sockets_found && !NET_REFERENCE_CHECK(ref))
         	fprintf(fp, "No open sockets.\n");
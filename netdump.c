@@ -104,6 +104,18 @@ map_cpus_to_prstatus(void)
 	FREEBUF(nt_ptr);
 }
 
+/*
+ *  Forget the current dumpfile so that is_netdump() may be applied to
+ *  another one.  Only used by "test -b" in a child process, so nothing
+ *  is freed.
+ */
+void
+clear_netdump_data(void)
+{
+	nd = &vmcore_data;
+	BZERO(nd, sizeof(struct vmcore_data));
+}
+
 /*
  *  Determine whether a file is a netdump/diskdump/kdump creation, 
  *  and if TRUE, initialize the vmcore_data structure.
@@ -3900,6 +3912,36 @@ get_kdump_vmcore_data(void)
 	return &vmcore_data;
 }
 
+/*
+ *  Return the contents of the PT_NOTE segment, which is contained
+ *  within the ELF header data, for copying into another dumpfile.
+ */
+int
+netdump_get_notes(void **notes, ulong *size)
+{
+	ulonglong offset, len;
+
+	if (!VMCORE_VALID())
+		return FALSE;
+
+	if (nd->notes64) {
+		offset = nd->notes64->p_offset;
+		len = nd->notes64->p_filesz;
+	} else if (nd->notes32) {
+		offset = nd->notes32->p_offset;
+		len = nd->notes32->p_filesz;
+	} else
+		return FALSE;
+
+	if (!len || ((offset + len) > nd->header_size))
+		return FALSE;
+
+	*notes = nd->elf_header + offset;
+	*size = (ulong)len;
+
+	return TRUE;
+}
+
 /*
  *  Override the dom0 p2m mfn in the XEN_ELFNOTE_CRASH_INFO note
  *  in order to initiate a crash session of a guest kernel.
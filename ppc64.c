@@ -54,6 +54,9 @@ static void ppc64_init_cpu_info(void);
 static int ppc64_get_cpu_map(void);
 static void ppc64_clear_machdep_cache(void);
 static void ppc64_vmemmap_init(void);
+static int ppc64_vmemmap_compare(const void *, const void *);
+static void ppc64_vmemmap_index_init(void);
+static struct ppc64_vmemmap *ppc64_vmemmap_lookup(ulong);
 static int ppc64_get_kvaddr_ranges(struct vaddr_range *);
 static uint get_ptetype(ulong pte);
 static int is_hugepage(ulong pte);
@@ -583,6 +586,11 @@ ppc64_dump_machdep_table(ulong arg)
 			machdep->machspec->vmemmap_cnt);
 		fprintf(fp, "        vmemmap_psize: %d\n", 
 			machdep->machspec->vmemmap_psize);
+		fprintf(fp, "    vmemmap_index_cnt: ");
+		if (machdep->machspec->vmemmap_index)
+			fprintf(fp, "%ld\n", machdep->machspec->vmemmap_index_cnt);
+		else
+			fprintf(fp, "(unused)\n");
 		for (i = 0; i < machdep->machspec->vmemmap_cnt; i++) {
 			fprintf(fp, 
 			    "      vmemmap_list[%d]: virt: %lx  phys: %lx\n", i, 
@@ -968,6 +976,7 @@ void ppc64_vmemmap_init(void)
 	}
 
 	ms->vmemmap_cnt = cnt;
+	ppc64_vmemmap_index_init();
 	machdep->flags |= VMEMMAP_AWARE;
 	if (CRASHDEBUG(1))
 		fprintf(fp, "ppc64_vmemmap_init: vmemmap base: %lx\n",
@@ -984,9 +993,7 @@ out:
 static int
 ppc64_vmemmap_to_phys(ulong kvaddr, physaddr_t *paddr, int verbose)
 {
-	int i;
-	ulong offset;
-	struct machine_specific *ms;
+	struct ppc64_vmemmap *vm;
 
 	if (!(machdep->flags & VMEMMAP_AWARE)) {
 		/*
@@ -1006,18 +1013,119 @@ ppc64_vmemmap_to_phys(ulong kvaddr, physaddr_t *paddr, int verbose)
 		return FALSE;
 	}
 
+	if (!(vm = ppc64_vmemmap_lookup(kvaddr)))
+		return FALSE;
+
+	*paddr = vm->phys + (kvaddr - vm->virt);
+	return TRUE;
+}
+
+static int
+ppc64_vmemmap_compare(const void *v1, const void *v2)
+{
+	const struct ppc64_vmemmap *vm1, *vm2;
+
+	vm1 = v1;
+	vm2 = v2;
+
+	if (vm1->virt < vm2->virt)
+		return -1;
+	return (vm1->virt > vm2->virt) ? 1 : 0;
+}
+
+/*
+ *  Sort the vmemmap list by virtual address, and if the blocks are
+ *  psize-aligned and reasonably dense, index them directly by block
+ *  number from the lowest one.  Otherwise lookups binary-search the
+ *  sorted list.
+ */
+static void
+ppc64_vmemmap_index_init(void)
+{
+	int i;
+	ulong blocks, block;
+	struct machine_specific *ms;
+
 	ms = machdep->machspec;
+	ms->vmemmap_index = NULL;
+	ms->vmemmap_index_cnt = 0;
+	ms->vmemmap_last = NULL;
+
+	if (!ms->vmemmap_cnt)
+		return;
+
+	qsort(ms->vmemmap_list, ms->vmemmap_cnt, sizeof(struct ppc64_vmemmap),
+		ppc64_vmemmap_compare);
+
+	blocks = ((ms->vmemmap_list[ms->vmemmap_cnt-1].virt - 
+		ms->vmemmap_list[0].virt) / ms->vmemmap_psize) + 1;
+	if (blocks > ((ulong)ms->vmemmap_cnt * 8))
+		return;
 
 	for (i = 0; i < ms->vmemmap_cnt; i++) {
-		if ((kvaddr >= ms->vmemmap_list[i].virt) &&
-		    (kvaddr < (ms->vmemmap_list[i].virt + ms->vmemmap_psize))) {
-			offset = kvaddr - ms->vmemmap_list[i].virt;
-			*paddr = ms->vmemmap_list[i].phys + offset;
-			return TRUE;
+		if ((ms->vmemmap_list[i].virt - ms->vmemmap_list[0].virt) %
+		    ms->vmemmap_psize)
+			return;
+	}
+
+	if ((ms->vmemmap_index = (int *)malloc(blocks * sizeof(int))) == NULL) {
+		error(INFO, "cannot malloc vmemmap index space\n");
+		return;
+	}
+
+	for (block = 0; block < blocks; block++)
+		ms->vmemmap_index[block] = -1;
+	for (i = ms->vmemmap_cnt - 1; i >= 0; i--) {
+		block = (ms->vmemmap_list[i].virt - ms->vmemmap_list[0].virt) /
+			ms->vmemmap_psize;
+		ms->vmemmap_index[block] = i;
+	}
+	ms->vmemmap_index_cnt = blocks;
+}
+
+/*
+ *  Return the vmemmap block containing a virtual address.  Page struct
+ *  arrays are read sequentially one page at a time, so the block last
+ *  found is checked first, making it a single translation per block.
+ */
+static struct ppc64_vmemmap *
+ppc64_vmemmap_lookup(ulong kvaddr)
+{
+	int lo, hi, mid;
+	ulong block;
+	struct ppc64_vmemmap *vm;
+	struct machine_specific *ms;
+
+	ms = machdep->machspec;
+
+	if ((vm = ms->vmemmap_last) && (kvaddr >= vm->virt) &&
+	    (kvaddr < (vm->virt + ms->vmemmap_psize)))
+		return vm;
+
+	if (!ms->vmemmap_cnt || (kvaddr < ms->vmemmap_list[0].virt))
+		return NULL;
+
+	if (ms->vmemmap_index) {
+		block = (kvaddr - ms->vmemmap_list[0].virt) / ms->vmemmap_psize;
+		if ((block >= ms->vmemmap_index_cnt) || 
+		    (ms->vmemmap_index[block] < 0))
+			return NULL;
+		vm = &ms->vmemmap_list[ms->vmemmap_index[block]];
+	} else {
+		for (lo = 0, hi = ms->vmemmap_cnt - 1; lo < hi; ) {
+			mid = (lo + hi + 1) / 2;
+			if (ms->vmemmap_list[mid].virt <= kvaddr)
+				lo = mid;
+			else
+				hi = mid - 1;
 		}
+		vm = &ms->vmemmap_list[lo];
+		if (kvaddr >= (vm->virt + ms->vmemmap_psize))
+			return NULL;
 	}
 
-	return FALSE;
+	ms->vmemmap_last = vm;
+	return vm;
 }
 
 /*
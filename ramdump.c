@@ -27,13 +27,18 @@ struct ramdump_def {
 	int rfd;
 	ulonglong start_paddr;
 	ulonglong end_paddr;
+	char *map;
+	ulonglong size;
 };
 
 static struct ramdump_def *ramdump;
+static struct ramdump_def **ramdump_sorted;
 static int nodes;
 static char *user_elf = NULL;
 static char elf_default[] = "/var/tmp/ramdump_elf_XXXXXX";
 
+static void map_ramdump_nodes(void);
+
 static void alloc_elf_header(Elf64_Ehdr *ehdr, ushort e_machine)
 {
 	memcpy(ehdr->e_ident, ELFMAG, SELFMAG);
@@ -167,6 +172,91 @@ end1:
 	return err ? NULL : out_elf;
 }
 
+static int ramdump_node_cmp(const void *a, const void *b)
+{
+	const struct ramdump_def *r1 = *(const struct ramdump_def **)a;
+	const struct ramdump_def *r2 = *(const struct ramdump_def **)b;
+
+	if (r1->start_paddr < r2->start_paddr)
+		return -1;
+	if (r1->start_paddr > r2->start_paddr)
+		return 1;
+	return (r1 < r2) ? -1 : (r1 > r2);
+}
+
+/*
+ *  The ramdump files are raw images of physical memory, so map each
+ *  of them and keep the nodes sorted by physical address; a read then 
+ *  becomes a binary search and a memcpy.  Any file that cannot be 
+ *  mapped is read with lseek/read as before.
+ */
+static void map_ramdump_nodes(void)
+{
+	int i;
+	void *map;
+	struct ramdump_def *r;
+
+	if (!(ramdump_sorted = (struct ramdump_def **)
+	    malloc(sizeof(struct ramdump_def *) * nodes)))
+		error(FATAL, "ramdump: cannot malloc node index\n");
+
+	for (i = 0; i < nodes; i++) {
+		r = ramdump_sorted[i] = &ramdump[i];
+		r->size = r->end_paddr - r->start_paddr + 1;
+		r->map = NULL;
+
+		if (!r->size || (r->size != (size_t)r->size))
+			continue;
+
+		if ((map = mmap(NULL, (size_t)r->size, PROT_READ, MAP_PRIVATE,
+		    r->rfd, 0)) == MAP_FAILED) {
+			if (CRASHDEBUG(1))
+				error(INFO, "ramdump %s: cannot mmap: %s\n",
+					r->path, strerror(errno));
+			continue;
+		}
+		r->map = map;
+	}
+
+	qsort(ramdump_sorted, nodes, sizeof(struct ramdump_def *), 
+		ramdump_node_cmp);
+}
+
+static struct ramdump_def *ramdump_node(physaddr_t paddr)
+{
+	int i, lo, hi, mid;
+	struct ramdump_def *r;
+
+	if (!ramdump_sorted) {
+		for (i = 0; i < nodes; i++) {
+			r = &ramdump[i];
+			if ((paddr >= r->start_paddr) &&
+			    (paddr <= r->end_paddr))
+				return r;
+		}
+		return NULL;
+	}
+
+	lo = 0;
+	hi = nodes - 1;
+	r = NULL;
+
+	while (lo <= hi) {
+		mid = (lo + hi) / 2;
+		if (paddr < ramdump_sorted[mid]->start_paddr)
+			hi = mid - 1;
+		else {
+			r = ramdump_sorted[mid];
+			lo = mid + 1;
+		}
+	}
+
+	if (r && (paddr <= r->end_paddr))
+		return r;
+
+	return NULL;
+}
+
 static void alloc_notes(Elf64_Phdr *notes)
 {
 	/* Nothing filled in as of now */
@@ -238,6 +328,9 @@ char *ramdump_to_elf(void)
 	}
 
 	e_file = write_elf(load, e_head, data_offset);
+
+	if (e_file && is_ramdump_image())
+		map_ramdump_nodes();
 end:
 	free(e_head);
 	return e_file;
@@ -300,23 +393,9 @@ int
 read_ramdump(int fd, void *bufptr, int cnt, ulong addr, physaddr_t paddr)
 {
 	off_t offset;
-	int i, found;
-	struct ramdump_def *r = &ramdump[0];
+	struct ramdump_def *r;
 
-	offset = 0;
-
-	for (i = found = 0; i < nodes; i++) {
-		r = &ramdump[i];
-
-		if ((paddr >= r->start_paddr) &&
-		    (paddr <= r->end_paddr)) {
-			offset = (off_t)paddr - (off_t)r->start_paddr;
-			found++;
-			break;
-		}
-	}
-
-	if (!found) {
+	if (!(r = ramdump_node(paddr))) {
 		if (CRASHDEBUG(8))
 			fprintf(fp, "read_ramdump: READ_ERROR: "
 		    	    "offset not found for paddr: %llx\n",
@@ -324,11 +403,18 @@ read_ramdump(int fd, void *bufptr, int cnt, ulong addr, physaddr_t paddr)
 		return READ_ERROR;
 	}
 
+	offset = (off_t)paddr - (off_t)r->start_paddr;
+
 	if (CRASHDEBUG(8))
 		fprintf(fp,
 		"read_ramdump: addr: %lx paddr: %llx cnt: %d offset: %llx\n",
 			addr, (ulonglong)paddr, cnt, (ulonglong)offset);
 
+	if (r->map && ((ulonglong)offset + cnt <= r->size)) {
+		memcpy(bufptr, r->map + offset, cnt);
+		return cnt;
+	}
+
 	if (lseek(r->rfd, offset, SEEK_SET) == -1) {
 		if (CRASHDEBUG(8))
 			fprintf(fp, "read_ramdump: SEEK_ERROR: "
@@ -384,6 +470,8 @@ dump_ramdump_data()
 			(ulonglong)ramdump[i].start_paddr);
 		fprintf(fp, "                end_paddr: %llx\n", 
 			(ulonglong)ramdump[i].end_paddr);
+		fprintf(fp, "                      map: %lx\n", 
+			(ulong)ramdump[i].map);
 	}
 
 	fprintf(fp, "\n");
@@ -23,6 +23,7 @@
 #include <arpa/inet.h>
 #include <netinet/tcp.h>
 #include <elf.h>
+#include <zlib.h>
 
 #define FAILMSG "FAIL "
 #define DONEMSG "DONE "
@@ -33,6 +34,33 @@
 #define MAXRECVBUFSIZE (131072) 
 #define READBUFSIZE    (MAXRECVBUFSIZE+DATA_HDRSIZE)
 
+/*
+ *  Protocol version 2 adds the "READ_PAGES" request, which reads a batch
+ *  of pages in a single round-trip:
+ *
+ *    READ_PAGES <LIVE|NETDUMP|MCLXCD|LKCD|S390D> <fd> <flags> <addr> ...
+ *
+ *  The reply is the usual DATA_HDRSIZE header containing the total length
+ *  of the data that follows, which consists of one frame per requested 
+ *  page: a remote_page_hdr in network byte order, followed by the page 
+ *  data, which is zlib-compressed if REMOTE_PAGE_ZLIB is set in its flags.  
+ *  A page that could not be read has a non-zero errno in its header and 
+ *  no data.  Daemons that do not understand the "PROTOCOL" request fail
+ *  it, in which case the client sticks with the version 1 requests.
+ */
+#define REMOTE_PROTOCOL_VERSION (2)
+#define REMOTE_PAGE_SIZE        (4096)
+#define REMOTE_MAX_BATCH        (16)
+#define REMOTE_PAGE_ZLIB        (0x1)
+
+struct remote_page_hdr {
+	uint32_t error;
+	uint32_t flags;
+	uint32_t length;
+};
+
+#define REMOTE_FRAME_SIZE   (sizeof(struct remote_page_hdr)+REMOTE_PAGE_SIZE)
+
 #ifdef DAEMON
 /*
  *  The remote daemon.  
@@ -59,6 +87,8 @@ static int daemon_checksum(char *, long *);
 static void daemon_send(void *, int);
 static int daemon_proc_version(char *);
 static void handle_connection(int);
+static int daemon_read_page(char *, int, char *, ulong);
+static int daemon_read_pages(char *, char *);
 
 struct remote_context {
         int sock;
@@ -186,6 +216,104 @@ daemon_socket_options(int sockfd)
                 console("TCP_NODELAY setsockopt error\n");
 }
 
+/*
+ *  Read one REMOTE_PAGE_SIZE page from the specified memory source type,
+ *  using the same methods as the corresponding READ_xxx requests.
+ */
+static int
+daemon_read_page(char *type, int mfd, char *buf, ulong addr)
+{
+	errno = 0;
+
+	if (STREQ(type, "LIVE"))
+		return ((lseek(mfd, (off_t)addr, SEEK_SET) != -1) &&
+			(read(mfd, buf, REMOTE_PAGE_SIZE) == REMOTE_PAGE_SIZE));
+	if (STREQ(type, "NETDUMP"))
+		return (read_netdump(UNUSED, buf, REMOTE_PAGE_SIZE, 
+			UNUSED, addr) == REMOTE_PAGE_SIZE);
+	if (STREQ(type, "MCLXCD"))
+		return ((vas_lseek(addr, SEEK_SET) == 0) &&
+			(vas_read((void *)buf, REMOTE_PAGE_SIZE) == 
+			REMOTE_PAGE_SIZE));
+	if (STREQ(type, "LKCD"))
+		return (lkcd_lseek(addr) &&
+			(lkcd_read((void *)buf, REMOTE_PAGE_SIZE) == 
+			REMOTE_PAGE_SIZE));
+	if (STREQ(type, "S390D"))
+		return (read_s390_dumpfile(UNUSED, buf, REMOTE_PAGE_SIZE, 
+			UNUSED, addr) == REMOTE_PAGE_SIZE);
+
+	errno = EINVAL;
+	return FALSE;
+}
+
+/*
+ *  Handle a READ_PAGES request, building the reply in readbuf and
+ *  returning the number of bytes to send.
+ */
+static int
+daemon_read_pages(char *recvbuf, char *readbuf)
+{
+	int i, argc, mfd, zlib;
+	ulong addr, total;
+	uLongf zlen;
+	char *argv[MAXARGS];
+	char page[REMOTE_PAGE_SIZE];
+	struct remote_page_hdr hdr;
+	char *bufptr;
+
+	BZERO(readbuf, READBUFSIZE);
+
+	argc = daemon_parse_line(recvbuf, argv);
+	if ((argc < 5) || ((argc - 4) > REMOTE_MAX_BATCH) ||
+	    (STREQ(argv[1], "LIVE") && (argc > 5))) {
+		sprintf(readbuf, "%s%07ld", FAILMSG, (ulong)EINVAL);
+		console("[%s]\n", readbuf);
+		return DATA_HDRSIZE;
+	}
+
+	mfd = atoi(argv[2]);
+	zlib = atoi(argv[3]) & REMOTE_PAGE_ZLIB;
+	bufptr = &readbuf[DATA_HDRSIZE];
+
+	for (i = 4; i < argc; i++) {
+		addr = daemon_htol(argv[i]);
+		BZERO(&hdr, sizeof(struct remote_page_hdr));
+
+		if (!daemon_read_page(argv[1], mfd, page, addr))
+			hdr.error = errno ? errno : EIO;
+		else {
+			zlen = REMOTE_PAGE_SIZE;
+			if (zlib && (compress2((Bytef *)bufptr + sizeof(hdr), 
+			    &zlen, (Bytef *)page, REMOTE_PAGE_SIZE, 
+			    Z_BEST_SPEED) == Z_OK) && 
+			    (zlen < REMOTE_PAGE_SIZE)) {
+				hdr.flags = REMOTE_PAGE_ZLIB;
+				hdr.length = zlen;
+			} else {
+				hdr.length = REMOTE_PAGE_SIZE;
+				BCOPY(page, bufptr + sizeof(hdr), 
+					REMOTE_PAGE_SIZE);
+			}
+		}
+
+		console("(%lx: %d/%d) ", addr, hdr.error, hdr.length);
+
+		total = hdr.length;
+		hdr.error = htonl(hdr.error);
+		hdr.flags = htonl(hdr.flags);
+		hdr.length = htonl(hdr.length);
+		BCOPY(&hdr, bufptr, sizeof(hdr));
+		bufptr += sizeof(hdr) + total;
+	}
+
+	total = bufptr - &readbuf[DATA_HDRSIZE];
+	sprintf(readbuf, "%s%07ld", DONEMSG, total);
+	console("(%ld)\n", total);
+
+	return (int)(total + DATA_HDRSIZE);
+}
+
 /*
  *  This is the child daemon that handles the incoming requests.
  */
@@ -789,6 +917,20 @@ handle_connection(int sock)
                         daemon_send(sendbuf, strlen(sendbuf));
                         continue;
 
+                } else if (STRNEQ(recvbuf, "PROTOCOL ")) {
+
+			sprintf(sendbuf, "PROTOCOL %d ZLIB", 
+				REMOTE_PROTOCOL_VERSION);
+                        console("[%s]\n", sendbuf);
+                        daemon_send(sendbuf, strlen(sendbuf));
+                        continue;
+
+                } else if (STRNEQ(recvbuf, "READ_PAGES ")) {
+
+			len = daemon_read_pages(recvbuf, readbuf);
+                        daemon_send(readbuf, len);
+                        continue;
+
                 } else if (STRNEQ(recvbuf, "READ_LKCD ")) {
 
                         strcpy(savebuf, recvbuf);
@@ -1813,15 +1955,38 @@ static int remote_tcp_read(int, const char *, size_t);
 static int remote_tcp_read_string(int, const char *, size_t, int);
 static int remote_tcp_write(int, const void *, size_t);
 static int remote_tcp_write_string(int, const char *);
+static void remote_protocol_init(void);
+static int remote_cached_read(int, char *, int, ulong);
+static struct remote_page *remote_read_pages(int, ulong);
+
+/*
+ *  Direct-mapped cache of pages read with the version 2 protocol.
+ */
+#define REMOTE_CACHE_PAGES  (1024)    /* must be a power of 2 */
+#define REMOTE_CACHE_INDEX(page) \
+	(((page)/REMOTE_PAGE_SIZE) & (REMOTE_CACHE_PAGES-1))
+
+struct remote_page {
+	int rfd;
+	ulong page;
+	char data[REMOTE_PAGE_SIZE];
+};
 
 struct _remote_context {
         uint flags;
         int n_cpus;
         int vfd;
         char remote_type[10];
+	int protocol;
+	struct remote_page *cache;
+	char *framebuf;
+	ulong cache_hits;
+	ulong cache_fills;
+	ulong batches;
 } remote_context;
 
 #define NIL_FLAG       (0x01U)
+#define ZLIB_FLAG      (0x02U)
 
 #define NIL_MODE() (rc->flags & NIL_FLAG)
 
@@ -2594,6 +2759,8 @@ remote_fd_init(void)
 			if (REMOTE_DUMPFILE())
 				pc->writemem = write_daemon;
 
+			remote_protocol_init();
+
 	       	} else
 	               	error(FATAL, "cannot open remote memory source: %s\n",
 	                       	pc->server_memsrc);
@@ -3693,6 +3860,10 @@ remote_memory_read(int rfd, char *buffer, int cnt, physaddr_t address, int vcpu)
 
 	addr = (ulong)address;  /* may be virtual */
 
+	if ((rc->protocol >= REMOTE_PROTOCOL_VERSION) && (vcpu < 0) &&
+	    (remote_cached_read(rfd, buffer, cnt, addr) == cnt))
+		return cnt;
+
         BZERO(sendbuf, BUFSIZE);
         if (pc->flags & REM_NETDUMP) {
                 sprintf(sendbuf, "READ_NETDUMP %lx %d", addr, cnt);
@@ -3753,14 +3924,222 @@ remote_memory_read(int rfd, char *buffer, int cnt, physaddr_t address, int vcpu)
 	return tot;
 }
 
+/*
+ *  Ask the daemon which protocol version it speaks.  Older daemons fail
+ *  the request, and the NIL-mode servers have their own read requests, 
+ *  so in those cases everything stays with version 1.
+ */
+static void
+remote_protocol_init(void)
+{
+	char sendbuf[BUFSIZE];
+	char recvbuf[BUFSIZE];
+	char *p1;
+	int i;
+
+	if (NIL_MODE())
+		return;
+
+        BZERO(sendbuf, BUFSIZE);
+        BZERO(recvbuf, BUFSIZE);
+	sprintf(sendbuf, "PROTOCOL %d ZLIB", REMOTE_PROTOCOL_VERSION);
+	remote_tcp_write_string(pc->sockfd, sendbuf);
+	remote_tcp_read_string(pc->sockfd, recvbuf, BUFSIZE-1, NIL_MODE());
+	if (CRASHDEBUG(1))
+		fprintf(fp, "remote_protocol_init: [%s]\n", recvbuf);
+	if (strstr(recvbuf, "<FAIL>") || !STRNEQ(recvbuf, "PROTOCOL "))
+		return;
+
+	p1 = strtok(recvbuf, " ");  /* PROTOCOL */
+	p1 = strtok(NULL, " ");     /* version */
+	if (!p1 || (atoi(p1) < REMOTE_PROTOCOL_VERSION))
+		return;
+	if ((p1 = strtok(NULL, " ")) && STREQ(p1, "ZLIB"))
+		rc->flags |= ZLIB_FLAG;
+
+	if (!(rc->cache = (struct remote_page *)
+	    malloc(sizeof(struct remote_page) * REMOTE_CACHE_PAGES)) ||
+	    !(rc->framebuf = (char *)
+	    malloc(REMOTE_FRAME_SIZE * REMOTE_MAX_BATCH))) {
+		error(INFO, "cannot malloc remote page cache\n");
+		if (rc->cache)
+			free(rc->cache);
+		rc->cache = NULL;
+		return;
+	}
+	for (i = 0; i < REMOTE_CACHE_PAGES; i++)
+		rc->cache[i].rfd = -1;
+
+	rc->protocol = REMOTE_PROTOCOL_VERSION;
+}
+
+/*
+ *  Satisfy a read request from the page cache, filling it as necessary.
+ *  Returns cnt on success, or -1 if any part of the request could not
+ *  be read, in which case the caller falls back to a version 1 request.
+ */
+static int
+remote_cached_read(int rfd, char *buffer, int cnt, ulong addr)
+{
+	struct remote_page *rp;
+	ulong page, offset;
+	int size, done;
+
+	for (done = 0; done < cnt; done += size) {
+		page = (addr + done) & ~((ulong)REMOTE_PAGE_SIZE-1);
+		offset = (addr + done) - page;
+		size = MIN(cnt - done, REMOTE_PAGE_SIZE - offset);
+
+		rp = &rc->cache[REMOTE_CACHE_INDEX(page)];
+		if ((rp->rfd == rfd) && (rp->page == page))
+			rc->cache_hits++;
+		else if (!(rp = remote_read_pages(rfd, page)))
+			return -1;
+
+		BCOPY(rp->data + offset, buffer + done, size);
+	}
+
+	return cnt;
+}
+
+/*
+ *  Read a page, along with up to REMOTE_MAX_BATCH-1 uncached pages that
+ *  follow it, with a single READ_PAGES request.  Returns the cache entry
+ *  of the requested page, or NULL if it could not be read.  A LIVE
+ *  /dev/mem source is read one page at a time, since the pages that
+ *  follow may be non-RAM or MMIO ranges, or be refused by STRICT_DEVMEM.
+ */
+static struct remote_page *
+remote_read_pages(int rfd, ulong page)
+{
+	char sendbuf[BUFSIZE];
+	char datahdr[DATA_HDRSIZE];
+	struct remote_page_hdr hdr;
+	struct remote_page *rp, *found;
+	ulong pages[REMOTE_MAX_BATCH];
+	ulong next;
+	uLongf zlen;
+	char *type, *p1, *bufptr;
+	int i, count, tot, batch;
+
+        if (pc->flags & REM_NETDUMP)
+		type = "NETDUMP";
+        else if (pc->flags & REM_MCLXCD)
+		type = "MCLXCD";
+        else if (pc->flags & REM_LKCD)
+		type = "LKCD";
+        else if (pc->flags & REM_S390D)
+		type = "S390D";
+	else
+		type = "LIVE";
+
+	batch = STREQ(type, "LIVE") ? 1 : REMOTE_MAX_BATCH;
+
+        BZERO(sendbuf, BUFSIZE);
+	sprintf(sendbuf, "READ_PAGES %s %d %d", type, rfd, 
+		rc->flags & ZLIB_FLAG ? REMOTE_PAGE_ZLIB : 0);
+
+	pages[0] = page;
+	sprintf(&sendbuf[strlen(sendbuf)], " %lx", page);
+	for (i = 1, count = 1; i < batch; i++) {
+		next = page + (i * REMOTE_PAGE_SIZE);
+		if (next < page)
+			break;
+		rp = &rc->cache[REMOTE_CACHE_INDEX(next)];
+		if ((rp->rfd == rfd) && (rp->page == next))
+			continue;
+		pages[count++] = next;
+		sprintf(&sendbuf[strlen(sendbuf)], " %lx", next);
+	}
+
+	if (remote_tcp_write_string(pc->sockfd, sendbuf))
+		return NULL;
+
+        BZERO(datahdr, DATA_HDRSIZE);
+	if (remote_tcp_read(pc->sockfd, datahdr, DATA_HDRSIZE) != DATA_HDRSIZE)
+		return NULL;
+	if (CRASHDEBUG(3))
+		fprintf(fp, "remote_read_pages: %lx (%d): [%s]\n", 
+			page, count, datahdr);
+	if (STRNEQ(datahdr, FAILMSG)) {
+		p1 = strtok(datahdr, " ");  /* FAIL  */
+		p1 = strtok(NULL, " ");     /* errno */
+		errno = atoi(p1);
+		return NULL;
+	}
+	if (!STRNEQ(datahdr, DONEMSG)) {
+		error(INFO, "out of sync with remote memory source\n");
+		return NULL;
+	}
+
+	p1 = strtok(datahdr, " ");  /* DONE */
+	p1 = strtok(NULL, " ");     /* count */
+	tot = atol(p1);
+
+	if ((tot > (REMOTE_FRAME_SIZE * count)) ||
+	    (remote_tcp_read(pc->sockfd, rc->framebuf, tot) != tot)) {
+		error(INFO, "out of sync with remote memory source\n");
+		return NULL;
+	}
+
+	rc->batches++;
+
+	for (i = 0, found = NULL, bufptr = rc->framebuf; i < count; i++) {
+		if ((bufptr + sizeof(hdr)) > (rc->framebuf + tot))
+			break;
+		BCOPY(bufptr, &hdr, sizeof(hdr));
+		hdr.error = ntohl(hdr.error);
+		hdr.flags = ntohl(hdr.flags);
+		hdr.length = ntohl(hdr.length);
+		bufptr += sizeof(hdr);
+
+		if ((hdr.length > REMOTE_PAGE_SIZE) || 
+		    ((bufptr + hdr.length) > (rc->framebuf + tot)))
+			break;
+
+		if (hdr.error) {
+			if (i == 0)
+				errno = hdr.error;
+			continue;
+		}
+
+		rp = &rc->cache[REMOTE_CACHE_INDEX(pages[i])];
+		rp->rfd = -1;
+		if (hdr.flags & REMOTE_PAGE_ZLIB) {
+			zlen = REMOTE_PAGE_SIZE;
+			if ((uncompress((Bytef *)rp->data, &zlen, 
+			    (Bytef *)bufptr, hdr.length) != Z_OK) ||
+			    (zlen != REMOTE_PAGE_SIZE)) {
+				bufptr += hdr.length;
+				continue;
+			}
+		} else if (hdr.length == REMOTE_PAGE_SIZE)
+			BCOPY(bufptr, rp->data, REMOTE_PAGE_SIZE);
+		else {
+			bufptr += hdr.length;
+			continue;
+		}
+
+		rp->rfd = rfd;
+		rp->page = pages[i];
+		rc->cache_fills++;
+		if (i == 0)
+			found = rp;
+		bufptr += hdr.length;
+	}
+
+	return found;
+}
+
 /*
  *  If a command was interrupted locally, there may be leftover data waiting
- *  to be read.
+ *  to be read.  A live system's memory changes between commands, so the
+ *  remote page cache is invalidated as well.
  */
 void
 remote_clear_pipeline(void)
 {
-	int ret;
+	int i, ret;
 	fd_set rfds;
 	char recvbuf[READBUFSIZE];
 	struct timeval tv;
@@ -3772,6 +4151,15 @@ remote_clear_pipeline(void)
         FD_SET(pc->sockfd, &rfds);
         ret = select(pc->sockfd+1, &rfds, NULL, NULL, &tv);
 
+	if (rc->cache && REMOTE_ACTIVE()) {
+		if (CRASHDEBUG(1))
+			error(INFO, "remote page cache: hits: %ld "
+			    "fills: %ld batches: %ld\n", rc->cache_hits,
+				rc->cache_fills, rc->batches);
+		for (i = 0; i < REMOTE_CACHE_PAGES; i++)
+			rc->cache[i].rfd = -1;
+	}
+
 	if (FD_ISSET(pc->sockfd, &rfds)) {
         	ret = recv(pc->sockfd, recvbuf, pc->rcvbufsize, 0); 
 		if (CRASHDEBUG(1))
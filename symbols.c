@@ -2904,6 +2904,11 @@ dump_symbol_table(void)
 	else
 		fprintf(fp, "\n");
 
+	fprintf(fp, "         index_cache: %s\n", 
+		st->index_cache ? st->index_cache : "(unused)");
+	fprintf(fp, "    index_cache_hits: %ld\n", st->index_cache_hits);
+	fprintf(fp, "   index_cache_saves: %ld\n", st->index_cache_saves);
+
         fprintf(fp, "    symval_hash[%d]: %lx\n", SYMVAL_HASH,
                 (ulong)&st->symval_hash[0]);
 
@@ -2992,6 +2997,7 @@ dump_symbol_table(void)
 		fprintf(fp, "              mod_name: %s\n", lm->mod_name);
 		fprintf(fp, "              mod_size: %ld\n", lm->mod_size);
 		fprintf(fp, "          mod_namelist: %s\n", lm->mod_namelist);
+		fprintf(fp, "         mod_debuginfo: %s\n", lm->mod_debuginfo);
 		fprintf(fp, "             mod_flags: %lx  (", lm->mod_flags);
 		if (lm->mod_flags & MOD_EXT_SYMS)
 			fprintf(fp, "%sMOD_EXT_SYMS", others++ ? "|" : "");
@@ -10726,6 +10732,7 @@ load_module_symbols(char *modref, char *namelist, ulong base_addr)
 	struct load_module *lm;
 	asymbol *sort_x;
 	asymbol *sort_y;
+	char *cached, *symfile;
 
 	if (!is_module_name(modref, NULL, &lm))
 		error(FATAL, "%s: not a loaded module name\n", modref);
@@ -10741,6 +10748,24 @@ load_module_symbols(char *modref, char *namelist, ulong base_addr)
 		fprintf(fp, "load_module_symbols: %s %s %lx %lx\n",
 			modref, namelist, base_addr, kt->flags);
 
+	/*
+	 *  Use an indexed copy of the object file if one has been cached.
+	 *  The module's object file name is kept in mod_namelist for 
+	 *  display, and the copy that gdb loads in mod_debuginfo.
+	 */
+	symfile = namelist;
+	if (!(lm->mod_flags & MOD_REMOTE) && 
+	    !(pc->curcmd_flags & MOD_READNOW) &&
+	    ((cached = index_cache_file(namelist)) != namelist)) {
+		symfile = GETBUF(strlen(cached)+1);
+		strcpy(symfile, cached);
+		free(cached);
+	}
+
+	BZERO(lm->mod_debuginfo, MAX_MOD_NAMELIST);
+	if (symfile != namelist)
+		strncpy(lm->mod_debuginfo, symfile, MAX_MOD_NAMELIST-1);
+
 	switch (kt->flags & (KMOD_V1|KMOD_V2))
 	{
 	case KMOD_V1:
@@ -10756,29 +10781,29 @@ load_module_symbols(char *modref, char *namelist, ulong base_addr)
                         goto add_symbols;
 	}
 
-  	if ((mbfd = bfd_openr(namelist, NULL)) == NULL) 
-		error(FATAL, "cannot open object file: %s\n", namelist);
+  	if ((mbfd = bfd_openr(symfile, NULL)) == NULL) 
+		error(FATAL, "cannot open object file: %s\n", symfile);
 
   	if (!bfd_check_format_matches(mbfd, bfd_object, &matching))
 		error(FATAL, "cannot determine object file format: %s\n",
-			namelist);
+			symfile);
 
-	if (LKCD_KERNTYPES() && (file_elf_version(namelist) == EV_DWARFEXTRACT))
+	if (LKCD_KERNTYPES() && (file_elf_version(symfile) == EV_DWARFEXTRACT))
 		goto add_symbols;   /* no symbols, add the debuginfo */
 
 	if (!(bfd_get_file_flags(mbfd) & HAS_SYMS))
-		error(FATAL, "no symbols in object file: %s\n", namelist);
+		error(FATAL, "no symbols in object file: %s\n", symfile);
 
 	symcount = bfd_read_minisymbols(mbfd, FALSE, &minisyms, &size);
 	if (symcount < 0)
 		error(FATAL, "cannot access symbol table data: %s\n",
-			namelist);
+			symfile);
 	else if (symcount == 0)
-		error(FATAL, "no symbols in object file: %s\n", namelist);
+		error(FATAL, "no symbols in object file: %s\n", symfile);
 
         if (CRASHDEBUG(2)) {
                 fprintf(fp, "%ld symbols found in obj file %s\n", symcount,
-                    namelist);
+                    symfile);
         }
         sort_x = bfd_make_empty_symbol(mbfd);
         sort_y = bfd_make_empty_symbol(mbfd);
@@ -11082,7 +11107,7 @@ add_symbol_file_kallsyms(struct load_module *lm, struct gnu_request *req)
 
 		if (STREQ(section_name, ".text")) {
 			sprintf(buf, "add-symbol-file %s 0x%lx %s", 
-				lm->mod_namelist, section_vaddr,
+				MOD_SYMFILE(lm), section_vaddr,
 				pc->curcmd_flags & MOD_READNOW ? "-readnow" : "");
 			while ((len + strlen(buf)) >= buflen) {
 				RESIZEBUF(req->buf, buflen, buflen * 2);
@@ -11555,7 +11580,7 @@ delete_load_module(ulong base_addr)
 		for (i = 0; i < st->mods_installed; i++) {
         		lm = &st->load_modules[i];
 			if (lm->mod_flags & MOD_LOAD_SYMS) {
-        			req->name = lm->mod_namelist;
+        			req->name = MOD_SYMFILE(lm);
         			gdb_interface(req); 
 			}
 			if (lm->mod_load_symtable) {
@@ -11572,6 +11597,7 @@ delete_load_module(ulong base_addr)
 			lm->mod_load_symtable = NULL;
 			lm->mod_load_symend = NULL;
 			lm->mod_namelist[0] = NULLCHAR;
+			lm->mod_debuginfo[0] = NULLCHAR;
 			lm->mod_load_symcnt = lm->mod_symalloc = 0;
 			lm->mod_text_start = lm->mod_data_start = 0; 
 			lm->mod_bss_start = lm->mod_rodata_start = 0;
@@ -11591,7 +11617,7 @@ delete_load_module(ulong base_addr)
 		lm = &st->load_modules[i];
                 if (lm->mod_base == base_addr) {
 			if (lm->mod_flags & MOD_LOAD_SYMS) {
-                        	req->name = lm->mod_namelist;
+                        	req->name = MOD_SYMFILE(lm);
                         	gdb_interface(req);
 			}
 			if (lm->mod_load_symtable) {
@@ -11608,6 +11634,7 @@ delete_load_module(ulong base_addr)
                         lm->mod_load_symtable = NULL;
                         lm->mod_load_symend = NULL;
                         lm->mod_namelist[0] = NULLCHAR;
+                        lm->mod_debuginfo[0] = NULLCHAR;
                         lm->mod_load_symcnt = lm->mod_symalloc = 0;
                         lm->mod_text_start = lm->mod_data_start = 0;
 			lm->mod_bss_start = lm->mod_rodata_start = 0;
@@ -12058,6 +12085,278 @@ clear_text_value_cache(void)
 	}
 }
 
+/*
+ *  Kernel text and read-only data do not change after boot, apart from 
+ *  alternatives, jump labels, ftrace, paravirt patching and the like, so
+ *  reads of .text and .rodata can be served from an mmap of the vmlinux
+ *  file rather than through page table translation and dumpfile
+ *  decompression.  Each page is compared against memory the first time
+ *  it is read, and pages that were patched at runtime continue to be read
+ *  from memory; verify mode compares every page up front.  On a live
+ *  system the text may be re-patched at any time, so the comparisons are
+ *  only trusted for the duration of the command that made them.
+ */
+#define TEXT_PAGE_UNVERIFIED  (0)
+#define TEXT_PAGE_CLEAN       (1)
+#define TEXT_PAGE_PATCHED     (2)
+
+static struct vmlinux_text {
+	int fd;
+	int sections;
+	int busy;
+	ulong cmdgen;
+	ulong hits;
+	ulong verified;
+	ulong patched;
+	struct vmlinux_text_section {
+		char *name;
+		ulong start;
+		ulong end;
+		char *map;
+		size_t maplen;
+		char *contents;
+		ulong pages;
+		unsigned char *state;
+	} section[2];
+} vmlinux_text = { -1 };
+
+static int vmlinux_text_verify_page(struct vmlinux_text_section *, ulong);
+static void vmlinux_text_expire(void);
+
+/*
+ *  Map the vmlinux .text and .rodata sections.
+ */
+int
+vmlinux_text_init(void)
+{
+	static char *names[] = { ".text", ".rodata" };
+	struct vmlinux_text *vx;
+	struct vmlinux_text_section *vs;
+	asection *section;
+	off_t offset, pgoff;
+	int i;
+
+	vx = &vmlinux_text;
+
+	if (vx->sections)
+		return TRUE;
+
+	if ((pc->flags & SYSMAP) || XEN_HYPER_MODE() || !st->bfd) {
+		error(INFO, "vmlinux text is not available\n");
+		return FALSE;
+	}
+
+	if ((vx->fd = open(pc->namelist, O_RDONLY)) < 0) {
+		error(INFO, "%s: %s\n", pc->namelist, strerror(errno));
+		return FALSE;
+	}
+
+	for (i = 0; i < 2; i++) {
+		if (!(section = get_kernel_section(names[i])) ||
+		    !(section->flags & SEC_HAS_CONTENTS) ||
+		    !bfd_section_size(st->bfd, section))
+			continue;
+
+		vs = &vx->section[vx->sections];
+		vs->name = names[i];
+		vs->start = (ulong)bfd_get_section_vma(st->bfd, section) - 
+			kt->relocate;
+		vs->end = vs->start + (ulong)bfd_section_size(st->bfd, section);
+
+		offset = (off_t)section->filepos;
+		pgoff = offset & ~((off_t)getpagesize()-1);
+		vs->maplen = (size_t)(offset - pgoff) + 
+			(size_t)bfd_section_size(st->bfd, section);
+		if ((vs->map = mmap(NULL, vs->maplen, PROT_READ, MAP_PRIVATE,
+		    vx->fd, pgoff)) == MAP_FAILED) {
+			error(INFO, "%s: cannot mmap %s: %s\n", pc->namelist,
+				names[i], strerror(errno));
+			continue;
+		}
+		vs->contents = vs->map + (offset - pgoff);
+
+		vs->pages = (vs->end - vs->start + PAGESIZE() - 1)/PAGESIZE();
+		if (!(vs->state = (unsigned char *)calloc(vs->pages, 1))) {
+			munmap(vs->map, vs->maplen);
+			continue;
+		}
+
+		if (CRASHDEBUG(1))
+			error(INFO, "vmlinux_text: %s: %lx-%lx (%ld pages)\n",
+				vs->name, vs->start, vs->end, vs->pages);
+
+		vx->sections++;
+	}
+
+	if (!vx->sections) {
+		error(INFO, "%s: no text contents\n", pc->namelist);
+		close(vx->fd);
+		vx->fd = -1;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*
+ *  Compare one page of a section against memory.
+ */
+static int
+vmlinux_text_verify_page(struct vmlinux_text_section *vs, ulong page)
+{
+	struct vmlinux_text *vx;
+	ulong addr;
+	long size;
+	char *buf;
+	int ret;
+
+	vx = &vmlinux_text;
+
+	addr = vs->start + (page * PAGESIZE());
+	size = MIN(PAGESIZE(), vs->end - addr);
+	buf = GETBUF(size);
+
+	vx->busy = TRUE;
+	ret = readmem(addr, KVADDR, buf, size, "vmlinux text verify", 
+		RETURN_ON_ERROR|QUIET);
+	vx->busy = FALSE;
+
+	if (!ret || memcmp(buf, vs->contents + (addr - vs->start), size)) {
+		vs->state[page] = TEXT_PAGE_PATCHED;
+		vx->patched++;
+	} else
+		vs->state[page] = TEXT_PAGE_CLEAN;
+	vx->verified++;
+
+	FREEBUF(buf);
+
+	return (vs->state[page] == TEXT_PAGE_CLEAN);
+}
+
+/*
+ *  On a live system, forget the page comparisons made by earlier commands.
+ */
+static void
+vmlinux_text_expire(void)
+{
+	struct vmlinux_text *vx;
+	int i;
+
+	vx = &vmlinux_text;
+
+	if (!ACTIVE() || (vx->cmdgen == pc->cmdgencur))
+		return;
+
+	for (i = 0; i < vx->sections; i++)
+		BZERO(vx->section[i].state, vx->section[i].pages);
+	vx->cmdgen = pc->cmdgencur;
+}
+
+/*
+ *  Called by readmem() for kernel virtual addresses: if the request lies
+ *  entirely within a mapped section, and all of its pages match memory,
+ *  copy it from the vmlinux file.
+ */
+int
+vmlinux_text_read(ulong addr, void *buffer, long size)
+{
+	struct vmlinux_text *vx;
+	struct vmlinux_text_section *vs;
+	ulong page, last;
+	int i;
+
+	vx = &vmlinux_text;
+
+	if (vx->busy || !vx->sections || (size <= 0))
+		return FALSE;
+
+	for (i = 0, vs = NULL; i < vx->sections; i++) {
+		if ((addr >= vx->section[i].start) && 
+		    ((addr + size) <= vx->section[i].end)) {
+			vs = &vx->section[i];
+			break;
+		}
+	}
+
+	if (!vs)
+		return FALSE;
+
+	vmlinux_text_expire();
+
+	page = (addr - vs->start)/PAGESIZE();
+	last = (addr + size - 1 - vs->start)/PAGESIZE();
+
+	for ( ; page <= last; page++) {
+		switch (vs->state[page])
+		{
+		case TEXT_PAGE_PATCHED:
+			return FALSE;
+		case TEXT_PAGE_UNVERIFIED:
+			if (!vmlinux_text_verify_page(vs, page))
+				return FALSE;
+			break;
+		}
+	}
+
+	BCOPY(vs->contents + (addr - vs->start), buffer, size);
+	vx->hits++;
+
+	return TRUE;
+}
+
+/*
+ *  Verify every page of the mapped sections up front.
+ */
+void
+vmlinux_text_verify(void)
+{
+	struct vmlinux_text *vx;
+	struct vmlinux_text_section *vs;
+	ulong page, total;
+	int i;
+
+	vx = &vmlinux_text;
+
+	vmlinux_text_expire();
+
+	for (i = total = 0; i < vx->sections; i++) {
+		vs = &vx->section[i];
+		for (page = 0; page < vs->pages; page++) {
+			if (vs->state[page] == TEXT_PAGE_UNVERIFIED)
+				vmlinux_text_verify_page(vs, page);
+		}
+		total += vs->pages;
+	}
+
+	fprintf(fp, "vmlinux text: %ld of %ld pages patched at runtime\n", 
+		vx->patched, total);
+}
+
+void
+dump_vmlinux_text(void)
+{
+	struct vmlinux_text *vx;
+	struct vmlinux_text_section *vs;
+	int i;
+
+	vx = &vmlinux_text;
+
+	fprintf(fp, "vmlinux_text: %s", 
+		!(pc->flags2 & VMLINUX_TEXT) ? "off" :
+		pc->flags2 & VMLINUX_TEXT_VERIFY ? "verify" : "on");
+	if (!vx->sections) {
+		fprintf(fp, "\n");
+		return;
+	}
+	fprintf(fp, " hits: %ld verified: %ld patched: %ld\n", 
+		vx->hits, vx->verified, vx->patched);
+	for (i = 0; i < vx->sections; i++) {
+		vs = &vx->section[i];
+		fprintf(fp, "  %s: %lx-%lx (%ld pages)\n",
+			vs->name, vs->start, vs->end, vs->pages);
+	}
+}
+
 /*
  *  If a System.map file or a debug kernel was specified, the name hash
  *  has been filled -- so sync up gdb's notion of symbol values with
@@ -12470,3 +12769,296 @@ fill_struct_member_data(struct struct_member_data *smd)
 
 	return TRUE;
 }
+
+/*
+ *  Unless an object file carries a .gdb_index section, gdb builds
+ *  partial symbol tables for every DWARF compilation unit it contains
+ *  when the file is loaded, which for a large debug vmlinux takes the
+ *  bulk of the session's startup time.  If an index cache directory
+ *  has been specified with --index_cache or CRASH_INDEX_CACHE, then
+ *  a copy of each vmlinux or module debuginfo file that lacks an index
+ *  is stored there with a .gdb_index section added, keyed by the file's
+ *  build-id.  The indexed copy is handed to gdb in place of the original
+ *  in subsequent sessions, so that CUs are only expanded on demand.
+ */
+struct index_cache_pending {
+	char *file;
+	char *cached;
+	struct index_cache_pending *next;
+};
+
+static struct index_cache_pending *index_cache_pending = NULL;
+
+/*
+ *  Gather the hex build-id of an object file, and whether it already
+ *  contains a .gdb_index section.
+ */
+static int
+index_cache_probe(char *file, char *build_id, int *indexed)
+{
+	bfd *ibfd;
+	asection *sect;
+	bfd_size_type size;
+	unsigned char *contents, *note;
+	ulong namesz, descsz, type, i;
+	char **matching;
+	int found;
+
+	if ((ibfd = bfd_openr(file, NULL)) == NULL)
+		return FALSE;
+
+	if (!bfd_check_format_matches(ibfd, bfd_object, &matching)) {
+		bfd_close(ibfd);
+		return FALSE;
+	}
+
+	*indexed = bfd_get_section_by_name(ibfd, ".gdb_index") ? TRUE : FALSE;
+
+	found = FALSE;
+	if ((sect = bfd_get_section_by_name(ibfd, ".note.gnu.build-id")) &&
+	    ((size = bfd_section_size(ibfd, sect)) > 12) &&
+	    (contents = (unsigned char *)malloc(size))) {
+		if (bfd_get_section_contents(ibfd, sect, contents,
+		    (file_ptr)0, size)) {
+			for (note = contents; (note + 12) <= (contents + size); ) {
+				namesz = bfd_get_32(ibfd, note);
+				descsz = bfd_get_32(ibfd, note + 4);
+				type = bfd_get_32(ibfd, note + 8);
+				note += 12 + roundup(namesz, 4);
+				if ((note + descsz) > (contents + size))
+					break;
+				if ((type == NT_GNU_BUILD_ID) && (namesz == 4) &&
+				    STREQ((char *)note - 4, "GNU") &&
+				    descsz && (descsz < (BUFSIZE/2))) {
+					for (i = 0; i < descsz; i++)
+						sprintf(&build_id[i*2], "%02x", 
+							note[i]);
+					found = TRUE;
+					break;
+				}
+				note += roundup(descsz, 4);
+			}
+		}
+		free(contents);
+	}
+
+	bfd_close(ibfd);
+
+	return found;
+}
+
+/*
+ *  Return the file that gdb should be handed in place of an object
+ *  file: an indexed copy from the index cache if one exists, or else
+ *  the file itself.  In the latter case, if the file lacks an index,
+ *  queue it to be indexed by index_cache_update().
+ */
+char *
+index_cache_file(char *file)
+{
+	char build_id[BUFSIZE], cached_id[BUFSIZE];
+	struct index_cache_pending *icp;
+	char *cached;
+	int indexed;
+
+	if (!st->index_cache || (pc->flags & READNOW) || !file)
+		return file;
+
+	if (!is_directory(st->index_cache)) {
+		error(INFO, "%s: index cache is not a directory\n", 
+			st->index_cache);
+		st->index_cache = NULL;
+		return file;
+	}
+
+	BZERO(build_id, BUFSIZE);
+	if (!index_cache_probe(file, build_id, &indexed)) {
+		if (CRASHDEBUG(1))
+			error(INFO, "%s: no build-id: index cache not used\n", 
+				file);
+		return file;
+	}
+	if (indexed)
+		return file;
+
+	if (!(cached = malloc(strlen(st->index_cache) + strlen(build_id) + 
+	    strlen("/.debug") + 1)))
+		return file;
+	sprintf(cached, "%s/%s.debug", st->index_cache, build_id);
+
+	BZERO(cached_id, BUFSIZE);
+	if (file_exists(cached, NULL) &&
+	    index_cache_probe(cached, cached_id, &indexed) && indexed &&
+	    STREQ(build_id, cached_id)) {
+		if (CRASHDEBUG(1))
+			error(INFO, "%s: using indexed copy %s\n", 
+				file, cached);
+		st->index_cache_hits++;
+		return cached;
+	}
+
+	for (icp = index_cache_pending; icp; icp = icp->next) {
+		if (STREQ(icp->cached, cached)) {
+			free(cached);
+			return file;
+		}
+	}
+
+	if ((icp = (struct index_cache_pending *)
+	    malloc(sizeof(struct index_cache_pending))) == NULL) {
+		free(cached);
+		return file;
+	}
+	if ((icp->file = strdup(file)) == NULL) {
+		free(icp);
+		free(cached);
+		return file;
+	}
+	icp->cached = cached;
+	icp->next = index_cache_pending;
+	index_cache_pending = icp;
+
+	return file;
+}
+
+/*
+ *  Run objcopy to create a copy of an object file with the gdb index
+ *  file added as its .gdb_index section.  The arguments are passed
+ *  directly to objcopy rather than through a shell.
+ */
+static int
+index_cache_objcopy(char *index, char *file, char *outfile)
+{
+	char *section, *argv[8];
+	int fd, status;
+	pid_t pid;
+
+	section = GETBUF(strlen(".gdb_index=") + strlen(index) + 1);
+	sprintf(section, ".gdb_index=%s", index);
+
+	argv[0] = "objcopy";
+	argv[1] = "--add-section";
+	argv[2] = section;
+	argv[3] = "--set-section-flags";
+	argv[4] = ".gdb_index=readonly";
+	argv[5] = file;
+	argv[6] = outfile;
+	argv[7] = NULL;
+
+	if ((pid = fork()) < 0) {
+		error(INFO, "fork system call failed: %s\n", strerror(errno));
+		FREEBUF(section);
+		return FALSE;
+	}
+
+	if (pid == 0) {
+		if ((fd = open("/dev/null", O_WRONLY)) >= 0) {
+			dup2(fd, 1);
+			dup2(fd, 2);
+			close(fd);
+		}
+		execvp(argv[0], argv);
+		_exit(127);
+	}
+
+	FREEBUF(section);
+
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR)
+			return FALSE;
+	}
+
+	return (WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+}
+
+/*
+ *  Have gdb write an index for each object file queued by
+ *  index_cache_file(), and store an indexed copy of each of them
+ *  in the index cache.  gdb writes an index for every loaded object
+ *  file that doesn't already use one, so this is done once after 
+ *  a batch of object files has been loaded.
+ */
+void
+index_cache_update(void)
+{
+	struct index_cache_pending *icp;
+	char *tmpdir, *index, *tmpfile, *command;
+	DIR *dirp;
+	struct dirent *dp;
+	size_t len;
+
+	if (!index_cache_pending)
+		return;
+
+	len = strlen(st->index_cache) + strlen("/.crash_index_XXXXXX") + 1;
+	tmpdir = GETBUF(len);
+	sprintf(tmpdir, "%s/.crash_index_XXXXXX", st->index_cache);
+	if (!mkdtemp(tmpdir)) {
+		error(INFO, "%s: cannot create index cache directory: %s\n",
+			tmpdir, strerror(errno));
+		goto out;
+	}
+
+	command = GETBUF(len + BUFSIZE);
+	sprintf(command, "save gdb-index %s", tmpdir);
+	please_wait("saving gdb index");
+	if (!gdb_pass_through(command, pc->nullfp, GNU_RETURN_ON_ERROR) &&
+	    CRASHDEBUG(1))
+		error(INFO, "gdb \"%s\" command failed\n", command);
+	FREEBUF(command);
+
+	for (icp = index_cache_pending; icp; icp = icp->next) {
+		index = GETBUF(len + strlen(icp->file) + BUFSIZE);
+		sprintf(index, "%s/%s.gdb-index", tmpdir, basename(icp->file));
+		if (!file_exists(index, NULL)) {
+			if (CRASHDEBUG(1))
+				error(INFO, "%s: no gdb index was written\n", 
+					icp->file);
+			FREEBUF(index);
+			continue;
+		}
+
+		tmpfile = GETBUF(strlen(icp->cached) + BUFSIZE);
+		sprintf(tmpfile, "%s.%d", icp->cached, getpid());
+		if (!index_cache_objcopy(index, icp->file, tmpfile) ||
+		    rename(tmpfile, icp->cached)) {
+			error(INFO, "%s: cannot create indexed copy %s\n",
+				icp->file, icp->cached);
+			unlink(tmpfile);
+		} else {
+			if (CRASHDEBUG(1))
+				error(INFO, "%s: saved indexed copy %s\n",
+					icp->file, icp->cached);
+			st->index_cache_saves++;
+		}
+		FREEBUF(tmpfile);
+		FREEBUF(index);
+	}
+	please_wait_done();
+
+	/*
+	 *  Indexes of object files that weren't queued.
+	 */
+	if ((dirp = opendir(tmpdir))) {
+		index = GETBUF(len + BUFSIZE);
+		while ((dp = readdir(dirp))) {
+			if (STREQ(dp->d_name, ".") || STREQ(dp->d_name, "..") ||
+			    (strlen(dp->d_name) >= BUFSIZE))
+				continue;
+			sprintf(index, "%s/%s", tmpdir, dp->d_name);
+			unlink(index);
+		}
+		closedir(dirp);
+		FREEBUF(index);
+	}
+	rmdir(tmpdir);
+out:
+	FREEBUF(tmpdir);
+
+	while ((icp = index_cache_pending)) {
+		index_cache_pending = icp->next;
+		free(icp->file);
+		free(icp->cached);
+		free(icp);
+	}
+}
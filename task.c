@@ -31,8 +31,24 @@ static void refresh_hlist_task_table_v2(void);
 static void refresh_hlist_task_table_v3(void);
 static void refresh_active_task_table(void);
 static struct task_context *store_context(struct task_context *, ulong, char *);
+static char *refill_task_struct(ulong);
+static void snapshot_task_table(void);
+static int refresh_task_contexts(void);
+static int read_task_generation(ulong *, int *);
+static int compare_task_addr(const void *, const void *);
 static void refresh_context(ulong, ulong);
 static ulong parent_of(ulong);
+struct context_index;
+static void clear_context_index(void);
+static ulong context_hash(ulong, ulong);
+static void *context_index_alloc(void *, ulong, size_t);
+static int context_index_task(struct context_index *, ulong);
+static struct context_index *get_context_index(void);
+static void context_index_add(struct task_context *);
+static struct context_index *get_child_index(void);
+static struct context_index *get_tgid_index(void);
+static struct task_context *next_thread_group_task(ulong, int *);
+static void dump_context_index(void);
 static void parent_list(ulong);
 static void child_list(ulong);
 static void initialize_task_state(void);
@@ -61,7 +77,7 @@ static void dump_prio_array(int, ulong, char *);
 static void dump_task_runq_entry(struct task_context *, int);
 static void print_group_header_fair(int, ulong, void *);
 static void print_parent_task_group_fair(void *, int);
-static int dump_tasks_in_lower_dequeued_cfs_rq(int, ulong, int, struct task_context *);
+static int dump_tasks_in_lower_dequeued_cfs_rq(int, ulong, ulong, int, struct task_context *);
 static int dump_tasks_in_cfs_rq(ulong);
 static int dump_tasks_in_task_group_cfs_rq(int, ulong, int, struct task_context *);
 static void dump_on_rq_tasks(void);
@@ -70,7 +86,7 @@ static void task_group_offset_init(void);
 static void dump_CFS_runqueues(void);
 static void print_group_header_rt(ulong, void *);
 static void print_parent_task_group_rt(void *, int);
-static int dump_tasks_in_lower_dequeued_rt_rq(int, ulong, int);
+static int dump_tasks_in_lower_dequeued_rt_rq(int, ulong, ulong, int);
 static int dump_RT_prio_array(ulong, char *);
 static void dump_tasks_in_task_group_rt_rq(int, ulong, int);
 static char *get_task_group_name(ulong);
@@ -78,7 +94,19 @@ static void sort_task_group_info_array(void);
 static void print_task_group_info_array(void);
 static void reuse_task_group_info_array(void);
 static void free_task_group_info_array(void);
+static ulong *read_task_group_rq_array(char *, long, char *);
 static void fill_task_group_info_array(int, ulong, char *, int);
+static int compare_task_group_info_depth(const void *, const void *);
+static int compare_task_group_info_addr(const void *, const void *);
+struct task_group_info;
+static struct task_group_info *task_group_info_search(ulong);
+static ulong task_group_cfs_rq(struct task_group_info *, int);
+static ulong task_group_rt_rq(struct task_group_info *, int);
+struct cfs_rq_state;
+static void add_cfs_rq_entity(struct cfs_rq_state *, ulong, ulong);
+static void walk_cfs_rq_tree(ulong, ulong, struct cfs_rq_state *);
+static void read_cfs_rq_state(ulong, struct cfs_rq_state *);
+static void free_cfs_rq_state(struct cfs_rq_state *);
 static void dump_tasks_by_task_group(void);
 static void task_struct_member(struct task_context *,unsigned int, struct reference *);
 static void signal_reference(struct task_context *, ulong, struct reference *);
@@ -474,7 +502,7 @@ task_init(void)
 	if (tt->flags & ACTIVE_ONLY)
 		tt->refresh_task_table = refresh_active_task_table;
 
-	tt->refresh_task_table(); 
+	task_table_refresh(); 
 
 	if (tt->flags & TASK_REFRESH_OFF) 
 		tt->flags &= ~(TASK_REFRESH|TASK_REFRESH_OFF);
@@ -731,7 +759,7 @@ retry:
 	     tt->running_tasks = 0, tc = tt->context_array;
              i < tt->max_tasks; i++, tlp++) {
                 if (TASK_IN_USE(*tlp)) {
-                	if (!(tp = fill_task_struct(*tlp))) {
+                	if (!(tp = refill_task_struct(*tlp))) {
                         	if (DUMPFILE())
                                 	continue;
                         	retries++;
@@ -960,7 +988,7 @@ retry:
 			goto retry;
 		}
 
-                if (!(tp = fill_task_struct(*tlp))) {
+                if (!(tp = refill_task_struct(*tlp))) {
                      	if (DUMPFILE())
                         	continue;
                         retries++;
@@ -1169,7 +1197,7 @@ retry_pidhash:
 			goto retry_pidhash;
 		}
 
-		if (!(tp = fill_task_struct(*tlp))) {
+		if (!(tp = refill_task_struct(*tlp))) {
                         if (DUMPFILE())
                                 continue;
                         retries++;
@@ -1381,7 +1409,7 @@ retry_pid_hash:
 			goto retry_pid_hash;
 		}
 
-		if (!(tp = fill_task_struct(*tlp))) {
+		if (!(tp = refill_task_struct(*tlp))) {
                         if (DUMPFILE())
                                 continue;
                         retries++;
@@ -1653,7 +1681,7 @@ retry_pid_hash:
 			goto retry_pid_hash;
 		}
 
-		if (!(tp = fill_task_struct(*tlp))) {
+		if (!(tp = refill_task_struct(*tlp))) {
                         if (DUMPFILE())
                                 continue;
                         retries++;
@@ -1888,7 +1916,7 @@ retry_pid_hash:
 			goto retry_pid_hash;
 		}
 
-		if (!(tp = fill_task_struct(*tlp))) {
+		if (!(tp = refill_task_struct(*tlp))) {
                         if (DUMPFILE())
                                 continue;
                         retries++;
@@ -2151,7 +2179,7 @@ chain_next:
 			goto retry_pid_hash;
 		}
 
-		if (!(tp = fill_task_struct(*tlp))) {
+		if (!(tp = refill_task_struct(*tlp))) {
                         if (DUMPFILE())
                                 continue;
                         retries++;
@@ -2268,7 +2296,7 @@ retry_active:
 			goto retry_active;
 		}
 
-		if (!(tp = fill_task_struct(*tlp))) {
+		if (!(tp = refill_task_struct(*tlp))) {
                         if (DUMPFILE())
                                 continue;
                         retries++;
@@ -2334,6 +2362,9 @@ store_context(struct task_context *tc, ulong task, char *tp)
 	if (!tc)
 		tc = tt->context_array + tt->running_tasks;
 
+	if (tc < (tt->context_array + tt->running_tasks))
+		clear_context_index();
+
         pid_addr = (pid_t *)(tp + OFFSET(task_struct_pid));
 	tgid_addr = (pid_t *)(tp + OFFSET(task_struct_tgid));
         comm_addr = (char *)(tp + OFFSET(task_struct_comm));
@@ -2378,6 +2409,8 @@ store_context(struct task_context *tc, ulong task, char *tp)
         if (has_cpu && (tt->flags & POPULATE_PANIC))
                 tt->panic_threads[tc->processor] = tc->task;
 
+	context_index_add(tc);
+
 	return tc;
 }
 
@@ -2435,6 +2468,7 @@ sort_context_array(void)
 	curtask = CURRENT_TASK();
 	qsort((void *)tt->context_array, (size_t)tt->running_tasks,
         	sizeof(struct task_context), sort_by_pid);
+	clear_context_index();
 	set_context(curtask, NO_PID);
 }
 
@@ -2480,6 +2514,7 @@ sort_context_array_by_last_run(void)
 	curtask = CURRENT_TASK();
 	qsort((void *)tt->context_array, (size_t)tt->running_tasks,
         	sizeof(struct task_context), sort_by_last_run);
+	clear_context_index();
 	set_context(curtask, NO_PID);
 }
 
@@ -2510,6 +2545,198 @@ sort_by_tgid(const void *arg1, const void *arg2)
 		t1->tgid == t2->tgid ? 0 : 1);
 }
 
+/*
+ *  Refresh the task table before running a command.  On a live system,
+ *  if no task has been forked and none has exited since the last refresh,
+ *  i.e., total_forks and nr_threads are both unchanged, the set of tasks
+ *  is the same, and only the task_context fields of each are re-read.
+ *  Otherwise the machine-specific refresh function rebuilds the table.
+ */
+void
+task_table_refresh(void)
+{
+	ulong total_forks;
+	int nr_threads, generation;
+
+	generation = ACTIVE() && (tt->flags & TASK_REFRESH) && 
+		!(tt->flags & ACTIVE_ONLY) &&
+		read_task_generation(&total_forks, &nr_threads);
+
+	if (generation && (tt->flags & TASK_INIT_DONE) && tt->total_forks &&
+	    (total_forks == tt->total_forks) && 
+	    (nr_threads == tt->nr_threads) && refresh_task_contexts()) {
+		tt->refresh_skipped++;
+		return;
+	}
+
+	tt->refresh_task_table();
+	snapshot_task_table();
+
+	if (generation) {
+		tt->total_forks = total_forks;
+		tt->nr_threads = nr_threads;
+	} else
+		tt->total_forks = 0;
+}
+
+static int
+read_task_generation(ulong *total_forks, int *nr_threads)
+{
+	if (!symbol_exists("total_forks") || !symbol_exists("nr_threads"))
+		return FALSE;
+
+	if (!readmem(symbol_value("total_forks"), KVADDR, total_forks,
+	    sizeof(ulong), "total_forks", RETURN_ON_ERROR|QUIET) ||
+	    !readmem(symbol_value("nr_threads"), KVADDR, nr_threads,
+	    sizeof(int), "nr_threads", RETURN_ON_ERROR|QUIET))
+		return FALSE;
+
+	return TRUE;
+}
+
+static int
+compare_task_addr(const void *v1, const void *v2)
+{
+	ulong t1, t2;
+
+	t1 = *((ulong *)v1);
+	t2 = *((ulong *)v2);
+
+	return (t1 < t2 ? -1 : t1 == t2 ? 0 : 1);
+}
+
+static void
+refresh_span_member(long offset, long size)
+{
+	long end;
+
+	if (offset < 0)
+		return;
+
+	end = tt->refresh_span_start + tt->refresh_span_size;
+	if (!tt->refresh_span_size) {
+		tt->refresh_span_start = offset;
+		end = offset + size;
+	} else {
+		end = MAX(end, offset + size);
+		tt->refresh_span_start = MIN(tt->refresh_span_start, offset);
+	}
+	tt->refresh_span_size = end - tt->refresh_span_start;
+}
+
+/*
+ *  Save a sorted copy of the task addresses in the task table, and 
+ *  determine the span of each task_struct that store_context() uses.
+ *  On a live system, tasks found in the snapshot only need that span 
+ *  re-read during the next refresh.
+ */
+static void
+snapshot_task_table(void)
+{
+	struct task_context *tc;
+	ulong i;
+
+	if (!ACTIVE() || !(tt->flags & TASK_REFRESH))
+		return;
+
+	if (!tt->refresh_span_size) {
+		refresh_span_member(OFFSET(task_struct_pid), sizeof(pid_t));
+		refresh_span_member(OFFSET(task_struct_tgid), sizeof(pid_t));
+		refresh_span_member(OFFSET(task_struct_comm), TASK_COMM_LEN);
+		refresh_span_member(OFFSET(task_struct_mm), sizeof(void *));
+		if (tt->flags & THREAD_INFO)
+			refresh_span_member(OFFSET(task_struct_thread_info),
+				sizeof(void *));
+		else if (VALID_MEMBER(task_struct_processor))
+			refresh_span_member(OFFSET(task_struct_processor), 
+				sizeof(int));
+		else if (VALID_MEMBER(task_struct_cpu))
+			refresh_span_member(OFFSET(task_struct_cpu), 
+				sizeof(int));
+		if (VALID_MEMBER(task_struct_p_pptr))
+			refresh_span_member(OFFSET(task_struct_p_pptr), 
+				sizeof(void *));
+		else
+			refresh_span_member(OFFSET(task_struct_parent), 
+				sizeof(void *));
+		if (VALID_MEMBER(task_struct_has_cpu))
+			refresh_span_member(OFFSET(task_struct_has_cpu), 
+				sizeof(int));
+		else if (VALID_MEMBER(task_struct_cpus_runnable))
+			refresh_span_member(OFFSET(task_struct_cpus_runnable), 
+				sizeof(ulong));
+	}
+
+	if (!(tt->prev_tasks = (ulong *)realloc(tt->prev_tasks, 
+	    sizeof(ulong) * (tt->running_tasks + 1)))) {
+		tt->prev_task_count = 0;
+		return;
+	}
+
+	for (i = 0, tc = FIRST_CONTEXT(); i < tt->running_tasks; i++, tc++)
+		tt->prev_tasks[i] = tc->task;
+	tt->prev_task_count = tt->running_tasks;
+
+	qsort(tt->prev_tasks, tt->prev_task_count, sizeof(ulong), 
+		compare_task_addr);
+}
+
+/*
+ *  Used by the refresh functions in place of fill_task_struct(): a task 
+ *  that was in the previous task table only has the span used by 
+ *  store_context() re-read into the task_struct buffer.  Since the buffer
+ *  is then incomplete, it is not left as the last task read.
+ */
+static char *
+refill_task_struct(ulong task)
+{
+	if (!ACTIVE() || !tt->prev_task_count || !tt->refresh_span_size ||
+	    !bsearch(&task, tt->prev_tasks, tt->prev_task_count, 
+	    sizeof(ulong), compare_task_addr))
+		return fill_task_struct(task);
+
+	tt->last_task_read = 0;
+
+	if (!readmem(task + tt->refresh_span_start, KVADDR, 
+	    tt->task_struct + tt->refresh_span_start, tt->refresh_span_size, 
+	    "refill_task_struct", RETURN_ON_ERROR|QUIET))
+		return NULL;
+
+	tt->refresh_partial++;
+
+	return tt->task_struct;
+}
+
+/*
+ *  The set of tasks is unchanged: re-read the task_context fields of
+ *  each task in place.  Returns FALSE if anything looks amiss, in which
+ *  case the task table is rebuilt.
+ */
+static int
+refresh_task_contexts(void)
+{
+	struct task_context *tc;
+	ulong i, count;
+	char *tp;
+
+	clear_task_cache();
+
+	count = tt->running_tasks;
+
+	for (i = 0, tc = FIRST_CONTEXT(); i < count; i++, tc++) {
+		tt->running_tasks = i;
+		if (!(tp = refill_task_struct(tc->task)) ||
+		    !store_context(tc, tc->task, tp)) {
+			tt->running_tasks = count;
+			return FALSE;
+		}
+	}
+
+	tt->running_tasks = count;
+
+	return TRUE;
+}
+
 /*
  *  Keep a stash of the last task_struct accessed.  Chances are it will
  *  be hit several times before the next task is accessed.
@@ -3549,6 +3776,7 @@ show_task_args(struct task_context *tc)
 	physaddr_t paddr;
 	ulong uvaddr, size, cnt;
 	int c, d;
+	struct arena_scope scope;
 
 	print_task_header(fp, tc, 0);
 
@@ -3579,7 +3807,8 @@ show_task_args(struct task_context *tc)
 			env_start, env_end, env_end - env_start);
 	}
 
-	buf = GETBUF(env_end - arg_start + 1);
+	arena_scope_begin(&scope);
+	buf = ARENA_ALLOC(env_end - arg_start + 1);
 
 	uvaddr = arg_start;
 	size = env_end - arg_start;
@@ -3640,7 +3869,7 @@ show_task_args(struct task_context *tc)
 	fprintf(fp, "\n%s", d ? "" : "\n");
 
 bailout:
-	FREEBUF(buf);
+	arena_scope_end(&scope);
 }
 
 char *rlim_names[] = {
@@ -3677,6 +3906,7 @@ show_task_rlimit(struct task_context *tc)
 	int in_task_struct, in_signal_struct;
 	char *rlimit_buffer;
 	ulong *p1, rlim_addr;
+	struct arena_scope scope;
 	char buf1[BUFSIZE];
 	char buf2[BUFSIZE];
 	char buf3[BUFSIZE];
@@ -3716,7 +3946,8 @@ show_task_rlimit(struct task_context *tc)
 	}
 	len2 = strlen("(unlimited)");
 
-	rlimit_buffer = GETBUF(rlimit_index * SIZE(rlimit));
+	arena_scope_begin(&scope);
+	rlimit_buffer = ARENA_ALLOC(rlimit_index * SIZE(rlimit));
 
 	print_task_header(fp, tc, 0);
 
@@ -3730,7 +3961,7 @@ show_task_rlimit(struct task_context *tc)
         	if (!readmem(rlim_addr + OFFSET(signal_struct_rlim), 
 		    KVADDR, rlimit_buffer, rlimit_index * SIZE(rlimit),
                     "signal_struct rlimit array", RETURN_ON_ERROR)) {
-			FREEBUF(rlimit_buffer);
+			arena_scope_end(&scope);
 			return;
 		}
 	}
@@ -3759,7 +3990,7 @@ show_task_rlimit(struct task_context *tc)
 
 	fprintf(fp, "\n");
 
-	FREEBUF(rlimit_buffer);
+	arena_scope_end(&scope);
 }
 
 /*
@@ -4097,11 +4328,300 @@ compare_start_time(const void *v1, const void *v2)
 		t1->start_time == t2->start_time ? 0 : 1);
 }
 
+/*
+ *  Hashed indexes over the task_context array, keyed by task address,
+ *  pid and tgid, plus a per-task list of children.  Each chain links
+ *  context_array slots in array order, so the first entry found is the
+ *  same one that a linear search would return.  Contexts appended to
+ *  the array while it is refilled are added to the task and pid chains
+ *  as they are stored; otherwise the index is discarded whenever the
+ *  array is changed or re-sorted, and is rebuilt upon the next lookup.
+ *  The child lists and the tgid index are only built when first used.
+ */
+static struct context_index {
+	int valid;
+	int child_valid;
+	int tgid_valid;
+	struct task_context *array;
+	ulong count;
+	ulong size;
+	ulong buckets;
+	int *task_head;
+	int *task_next;
+	int *pid_head;
+	int *pid_next;
+	int *tgid_head;
+	int *tgid_next;
+	int *child_head;
+	int *child_next;
+	ulong *tgid;
+	ulong builds;
+	ulong appends;
+	ulong tgid_builds;
+} context_index = { 0 };
+
+static void
+clear_context_index(void)
+{
+	context_index.valid = FALSE;
+	context_index.child_valid = FALSE;
+	context_index.tgid_valid = FALSE;
+}
+
+static ulong
+context_hash(ulong key, ulong buckets)
+{
+	key ^= key >> 16;
+	key *= 0x45d9f3b;
+	key ^= key >> 16;
+
+	return key & (buckets - 1);
+}
+
+static void *
+context_index_alloc(void *ptr, ulong nelem, size_t size)
+{
+	if (!(ptr = realloc(ptr, nelem * size)))
+		error(FATAL, "cannot realloc task context index\n");
+
+	return ptr;
+}
+
+static int
+context_index_task(struct context_index *ci, ulong task)
+{
+	int i;
+
+	for (i = ci->task_head[context_hash(task, ci->buckets)]; i >= 0;
+	     i = ci->task_next[i])
+		if (ci->array[i].task == task)
+			return i;
+
+	return -1;
+}
+
+static struct context_index *
+get_context_index(void)
+{
+	struct context_index *ci;
+	struct task_context *tc;
+	ulong buckets, h;
+	int i;
+
+	ci = &context_index;
+	if (ci->valid && (ci->count == RUNNING_TASKS()) &&
+	    (ci->array == FIRST_CONTEXT()))
+		return ci;
+
+	ci->valid = ci->child_valid = ci->tgid_valid = FALSE;
+	ci->count = RUNNING_TASKS();
+	ci->array = FIRST_CONTEXT();
+
+	for (buckets = 64; buckets <= ci->count; buckets <<= 1)
+		;
+	if (buckets > ci->buckets) {
+		ci->buckets = 0;
+		ci->task_head = context_index_alloc(ci->task_head, buckets, sizeof(int));
+		ci->pid_head = context_index_alloc(ci->pid_head, buckets, sizeof(int));
+		ci->tgid_head = context_index_alloc(ci->tgid_head, buckets, sizeof(int));
+		ci->buckets = buckets;
+	}
+	if (buckets > ci->size) {
+		ci->size = 0;
+		ci->task_next = context_index_alloc(ci->task_next, buckets, sizeof(int));
+		ci->pid_next = context_index_alloc(ci->pid_next, buckets, sizeof(int));
+		ci->tgid_next = context_index_alloc(ci->tgid_next, buckets, sizeof(int));
+		ci->child_head = context_index_alloc(ci->child_head, buckets, sizeof(int));
+		ci->child_next = context_index_alloc(ci->child_next, buckets, sizeof(int));
+		ci->tgid = context_index_alloc(ci->tgid, buckets, sizeof(ulong));
+		ci->size = buckets;
+	}
+
+	memset(ci->task_head, 0xff, ci->buckets * sizeof(int));
+	memset(ci->pid_head, 0xff, ci->buckets * sizeof(int));
+
+	for (i = ci->count - 1; i >= 0; i--) {
+		tc = &ci->array[i];
+		h = context_hash(tc->task, ci->buckets);
+		ci->task_next[i] = ci->task_head[h];
+		ci->task_head[h] = i;
+		h = context_hash(tc->pid, ci->buckets);
+		ci->pid_next[i] = ci->pid_head[h];
+		ci->pid_head[h] = i;
+	}
+
+	ci->valid = TRUE;
+	ci->builds++;
+
+	return ci;
+}
+
+/*
+ *  Called by store_context() once a context has been filled in.  If it
+ *  was appended to a valid index, link it onto the tail of its task and
+ *  pid chains, so that a task table refresh, which checks each new task
+ *  with task_exists(), does not rebuild the index for every task.
+ */
+static void
+context_index_add(struct task_context *tc)
+{
+	struct context_index *ci;
+	ulong i;
+	int *link;
+
+	ci = &context_index;
+	if (!ci->valid || (ci->array != FIRST_CONTEXT()) ||
+	    (ci->count != RUNNING_TASKS()) || (tc != &ci->array[ci->count]) ||
+	    (ci->count >= ci->size)) {
+		clear_context_index();
+		return;
+	}
+
+	i = ci->count++;
+
+	for (link = &ci->task_head[context_hash(tc->task, ci->buckets)];
+	     *link >= 0; link = &ci->task_next[*link])
+		;
+	*link = i;
+	ci->task_next[i] = -1;
+
+	for (link = &ci->pid_head[context_hash(tc->pid, ci->buckets)];
+	     *link >= 0; link = &ci->pid_next[*link])
+		;
+	*link = i;
+	ci->pid_next[i] = -1;
+
+	ci->child_valid = ci->tgid_valid = FALSE;
+	ci->appends++;
+}
+
+static struct context_index *
+get_child_index(void)
+{
+	struct context_index *ci;
+	int i, p;
+
+	ci = get_context_index();
+	if (ci->child_valid)
+		return ci;
+
+	for (i = ci->count - 1; i >= 0; i--)
+		ci->child_head[i] = -1;
+
+	for (i = ci->count - 1; i >= 0; i--) {
+		ci->child_next[i] = -1;
+		if ((p = context_index_task(ci, ci->array[i].ptask)) < 0)
+			continue;
+		ci->child_next[i] = ci->child_head[p];
+		ci->child_head[p] = i;
+	}
+
+	ci->child_valid = TRUE;
+
+	return ci;
+}
+
+/*
+ *  The tgid of each task is taken from the tgid_array gathered
+ *  along with the task_context array.  Returns NULL if tgids are
+ *  not available, in which case the callers search linearly.
+ */
+static struct context_index *
+get_tgid_index(void)
+{
+	struct context_index *ci;
+	struct tgid_context *tg;
+	ulong h;
+	int i, c;
+
+	if (INVALID_MEMBER(task_struct_tgid))
+		return NULL;
+
+	ci = get_context_index();
+	if (ci->tgid_valid)
+		return ci;
+
+	for (i = 0; i < ci->count; i++)
+		ci->tgid[i] = NO_PID;
+	for (i = 0, tg = tt->tgid_array; i < ci->count; i++, tg++) {
+		if ((c = context_index_task(ci, tg->task)) >= 0)
+			ci->tgid[c] = tg->tgid;
+	}
+
+	memset(ci->tgid_head, 0xff, ci->buckets * sizeof(int));
+	for (i = ci->count - 1; i >= 0; i--) {
+		if (ci->tgid[i] == NO_PID) {
+			ci->tgid_next[i] = -1;
+			continue;
+		}
+		h = context_hash(ci->tgid[i], ci->buckets);
+		ci->tgid_next[i] = ci->tgid_head[h];
+		ci->tgid_head[h] = i;
+	}
+
+	ci->tgid_valid = TRUE;
+	ci->tgid_builds++;
+
+	return ci;
+}
+
+/*
+ *  Step through the tasks of a thread group in context_array order;
+ *  *index must be initialized to -1.
+ */
+static struct task_context *
+next_thread_group_task(ulong tgid, int *index)
+{
+	struct context_index *ci;
+	struct task_context *tc;
+	int i;
+
+	if ((ci = get_tgid_index())) {
+		i = (*index < 0) ? ci->tgid_head[context_hash(tgid, ci->buckets)] :
+			ci->tgid_next[*index];
+		for ( ; i >= 0; i = ci->tgid_next[i]) {
+			if (ci->tgid[i] == tgid) {
+				*index = i;
+				return &ci->array[i];
+			}
+		}
+		return NULL;
+	}
+
+	for (i = *index + 1; i < RUNNING_TASKS(); i++) {
+		tc = FIRST_CONTEXT() + i;
+		if (task_tgid(tc->task) == tgid) {
+			*index = i;
+			return tc;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+dump_context_index(void)
+{
+	struct context_index *ci;
+
+	ci = &context_index;
+	fprintf(fp, "     context_index: valid: %s child_valid: %s tgid_valid: %s count: %ld buckets: %ld\n",
+		ci->valid ? "TRUE" : "FALSE", ci->child_valid ? "TRUE" : "FALSE",
+		ci->tgid_valid ? "TRUE" : "FALSE",
+		ci->count, ci->buckets);
+	fprintf(fp, "                    builds: %ld appends: %ld tgid_builds: %ld\n",
+		ci->builds, ci->appends, ci->tgid_builds);
+}
+
 static ulong
 parent_of(ulong task)
 {
 	long offset;
 	ulong parent;
+	struct task_context *tc;
+
+	if ((tc = task_to_context(task)))
+		return tc->ptask;
 
         if (VALID_MEMBER(task_struct_parent))
                 offset = OFFSET(task_struct_parent);
@@ -4162,17 +4682,17 @@ child_list(ulong task)
         int i;
 	int cnt;
         struct task_context *tc;
+	struct context_index *ci;
 
 	tc = task_to_context(task);
 	print_task_header(fp, tc, 0);
 
-        tc = FIRST_CONTEXT();
-        for (i = cnt = 0; i < RUNNING_TASKS(); i++, tc++) {
-                if (tc->ptask == task) {
-			INDENT(2);
-			print_task_header(fp, tc, 0);
-			cnt++;
-		}
+	ci = get_child_index();
+	cnt = 0;
+	for (i = ci->child_head[tc - ci->array]; i >= 0; i = ci->child_next[i]) {
+		INDENT(2);
+		print_task_header(fp, &ci->array[i], 0);
+		cnt++;
 	}
 
 	if (!cnt)
@@ -4207,18 +4727,15 @@ show_tgid_list(ulong task)
 
        	print_task_header(fp, tc, 0);
 
-        tc = FIRST_CONTEXT();
-        for (i = cnt = 0; i < RUNNING_TASKS(); i++, tc++) {
+	for (i = -1, cnt = 0; (tc = next_thread_group_task(tgid, &i)); ) {
 		if (tc->task == task)
 			continue;
 
-		if (task_tgid(tc->task)	== tgid) {
-                        INDENT(2);
-                        print_task_header(fp, tc, 0);
-                        cnt++;
-			if (tc->pid == 0)
-				pc->curcmd_flags |= IDLE_TASK_SHOWN;
-                }
+                INDENT(2);
+                print_task_header(fp, tc, 0);
+                cnt++;
+		if (tc->pid == 0)
+			pc->curcmd_flags |= IDLE_TASK_SHOWN;
         }
 
         if (!cnt)
@@ -4234,12 +4751,13 @@ ulong
 pid_to_task(ulong pid)
 {
 	int i;
-	struct task_context *tc;
+	struct context_index *ci;
 
-	tc = FIRST_CONTEXT();
-        for (i = 0; i < RUNNING_TASKS(); i++, tc++) 
-        	if (tc->pid == pid)
-			return(tc->task);
+	ci = get_context_index();
+	for (i = ci->pid_head[context_hash(pid, ci->buckets)]; i >= 0;
+	     i = ci->pid_next[i])
+		if (ci->array[i].pid == pid)
+			return(ci->array[i].task);
 
 	return((ulong)NULL);
 }
@@ -4251,14 +4769,10 @@ pid_to_task(ulong pid)
 ulong
 task_to_pid(ulong task)
 {
-        int i;
         struct task_context *tc;
 
-        
-        tc = FIRST_CONTEXT();
-        for (i = 0; i < RUNNING_TASKS(); i++, tc++) 
-                if (tc->task == task)
-                        return(tc->pid);
+        if ((tc = task_to_context(task)))
+                return(tc->pid);
         
         return(NO_PID);
 }
@@ -4269,15 +4783,7 @@ task_to_pid(ulong task)
 int
 task_exists(ulong task)
 {
-        int i;
-        struct task_context *tc;
-
-        tc = FIRST_CONTEXT();
-        for (i = 0; i < RUNNING_TASKS(); i++, tc++) 
-                if (tc->task == task)
-                        return TRUE;
-        
-        return FALSE;
+        return task_to_context(task) ? TRUE : FALSE;
 }
 
 /*
@@ -4287,12 +4793,11 @@ struct task_context *
 task_to_context(ulong task)
 {
         int i;
-        struct task_context *tc;
+        struct context_index *ci;
 
-        tc = FIRST_CONTEXT();
-        for (i = 0; i < RUNNING_TASKS(); i++, tc++) 
-                if (tc->task == task)
-                        return tc; 
+        ci = get_context_index();
+        if ((i = context_index_task(ci, task)) >= 0)
+                return &ci->array[i];
         
         return NULL;
 }
@@ -4305,8 +4810,19 @@ tgid_to_context(ulong parent_tgid)
 {
         int i;
         struct task_context *tc;
+	struct context_index *ci;
 	ulong tgid;
 
+	if ((ci = get_tgid_index())) {
+		for (i = ci->tgid_head[context_hash(parent_tgid, ci->buckets)];
+		     i >= 0; i = ci->tgid_next[i]) {
+			tc = &ci->array[i];
+			if ((ci->tgid[i] == parent_tgid) && (tc->pid == parent_tgid))
+				return tc;
+		}
+		return NULL;
+	}
+
         tc = FIRST_CONTEXT();
         for (i = 0; i < RUNNING_TASKS(); i++, tc++) {
 		tgid = task_tgid(tc->task);
@@ -4327,11 +4843,14 @@ pid_to_context(ulong pid)
 {
         int i;
         struct task_context *tc, *firsttc, *lasttc;
+	struct context_index *ci;
 
-        tc = FIRST_CONTEXT();
+	ci = get_context_index();
         firsttc = lasttc = NULL;
 
-        for (i = 0; i < RUNNING_TASKS(); i++, tc++) {
+	for (i = ci->pid_head[context_hash(pid, ci->buckets)]; i >= 0;
+	     i = ci->pid_next[i]) {
+		tc = &ci->array[i];
                 if (tc->pid == pid) {
 			if (!firsttc)
                         	firsttc = tc;
@@ -4354,13 +4873,16 @@ pid_exists(ulong pid)
 {
         int i;
         struct task_context *tc, *lasttc;
+	struct context_index *ci;
 	int count;
 
-        tc = FIRST_CONTEXT();
+	ci = get_context_index();
 	count = 0;
 	lasttc = NULL;
 
-        for (i = 0; i < RUNNING_TASKS(); i++, tc++) {
+	for (i = ci->pid_head[context_hash(pid, ci->buckets)]; i >= 0;
+	     i = ci->pid_next[i]) {
+		tc = &ci->array[i];
                 if (tc->pid == pid) {
                         count++;
 			if (lasttc)
@@ -4658,6 +5180,7 @@ panic_context_adjusted(struct task_context *tc)
 
         if (pgrp && tgid && (pgrp == tgid) && !pid_exists((ulong)pgrp)) {
                 tc->pid = (ulong)pgrp;
+		clear_context_index();
                 return CONTEXT_ADJUSTED;
         }
 
@@ -6050,6 +6573,7 @@ foreach(struct foreach_data *fd)
 	struct bt_info bt_info, *bt;
 	char buf[TASK_COMM_LEN];
 	struct psinfo psinfo;
+	struct arena_scope scope;
 
 	/* 
 	 *  Filter out any command/option issues.
@@ -6251,6 +6775,12 @@ foreach(struct foreach_data *fd)
 		(fd->flags & FOREACH_SPECIFIED));
 	ref = &reference;
 
+	/*
+	 *  Anything allocated from the arena on behalf of a task
+	 *  is released before moving on to the next one.
+	 */
+	arena_scope_begin(&scope);
+
         tc = FIRST_CONTEXT();
 
         for (i = 0; i < RUNNING_TASKS(); i++, tc++) {
@@ -6316,9 +6846,11 @@ foreach(struct foreach_data *fd)
 
                 if (setjmp(pc->foreach_loop_env)) {
 			free_all_bufs();
+			arena_scope_end(&scope);
                         continue;
 		}
 		pc->flags |= IN_FOREACH;
+		clear_live_cache();
 
 		if (fd->reference) {
 			BZERO(ref, sizeof(struct reference));
@@ -6328,6 +6860,7 @@ foreach(struct foreach_data *fd)
 
 		for (k = 0; k < fd->keys; k++) {
 			free_all_bufs();
+			arena_scope_end(&scope);
 
 			switch(fd->keyword_array[k])
 			{
@@ -6527,6 +7060,7 @@ foreach(struct foreach_data *fd)
 	}
 
 foreach_bailout:
+	arena_scope_end(&scope);
 
 	pc->flags &= ~IN_FOREACH;
 }
@@ -6952,6 +7486,13 @@ dump_task_table(int verbose)
 	fprintf(fp, "       init_pid_ns: %lx\n", tt->init_pid_ns);
 	fprintf(fp, "         filepages: %ld\n", tt->filepages);
 	fprintf(fp, "         anonpages: %ld\n", tt->anonpages);
+	fprintf(fp, "       total_forks: %ld\n", tt->total_forks);
+	fprintf(fp, "   prev_task_count: %ld\n", tt->prev_task_count);
+	fprintf(fp, "refresh_span_start: %ld\n", tt->refresh_span_start);
+	fprintf(fp, " refresh_span_size: %ld\n", tt->refresh_span_size);
+	fprintf(fp, "   refresh_skipped: %ld\n", tt->refresh_skipped);
+	fprintf(fp, "   refresh_partial: %ld\n", tt->refresh_partial);
+	dump_context_index();
 
 
 	wrap = sizeof(void *) == SIZEOF_32BIT ? 8 : 4;
@@ -8192,27 +8733,122 @@ struct task_group_info {
 	char *name;
 	ulong task_group;
 	struct task_group_info *parent;
+	int index;
+	ulong *cfs_rq;
+	ulong *rt_rq;
+	int nr_children;
+	struct task_group_info **children;
 };
 
+/*
+ *  The task_group hierarchy, along with each group's per-cpu cfs_rq and
+ *  rt_rq pointer arrays, is gathered once and kept for the remainder of
+ *  the session on dumpfiles.  It is rebuilt for each command on a live
+ *  system.  tgi_sorted is ordered by task_group address for lookups.
+ */
 static struct task_group_info **tgi_array;
+static struct task_group_info **tgi_sorted;
 static int tgi_p = 0;
 static int tgi_p_max = 0;
+static int tgi_valid = FALSE;
+
+static int
+compare_task_group_info_depth(const void *v1, const void *v2)
+{
+	struct task_group_info *t1, *t2;
+
+	t1 = *(struct task_group_info **)v1;
+	t2 = *(struct task_group_info **)v2;
 
+	if (t1->depth != t2->depth)
+		return t1->depth < t2->depth ? -1 : 1;
+
+	return t1->index < t2->index ? -1 : (t1->index > t2->index ? 1 : 0);
+}
+
+static int
+compare_task_group_info_addr(const void *v1, const void *v2)
+{
+	struct task_group_info *t1, *t2;
+
+	t1 = *(struct task_group_info **)v1;
+	t2 = *(struct task_group_info **)v2;
+
+	return t1->task_group < t2->task_group ? -1 :
+		(t1->task_group > t2->task_group ? 1 : 0);
+}
+
+/*
+ *  Order the groups by depth, retaining the hierarchy walk order within
+ *  each depth, and then link each group to its children in that order.
+ */
 static void
 sort_task_group_info_array(void)
 {
-	int i, j;
-	struct task_group_info *tmp;
+	int i;
+	struct task_group_info *tgi, *parent;
 
-	for (i = 0; i < tgi_p - 1; i++) {
-		for (j = 0; j < tgi_p - i - 1; j++) {
-			if (tgi_array[j]->depth > tgi_array[j+1]->depth) {
-				tmp = tgi_array[j+1];
-				tgi_array[j+1] = tgi_array[j];
-				tgi_array[j] = tmp;
-			}
-		}
+	qsort(tgi_array, tgi_p, sizeof(struct task_group_info *),
+		compare_task_group_info_depth);
+
+	for (i = 0; i < tgi_p; i++)
+		if ((parent = tgi_array[i]->parent))
+			parent->nr_children++;
+
+	for (i = 0; i < tgi_p; i++) {
+		tgi = tgi_array[i];
+		if (!tgi->nr_children)
+			continue;
+		if (!(tgi->children = (struct task_group_info **)
+		    malloc(sizeof(void *) * tgi->nr_children)))
+			error(FATAL, "cannot malloc task_group children\n");
+		tgi->nr_children = 0;
 	}
+
+	for (i = 0; i < tgi_p; i++)
+		if ((parent = tgi_array[i]->parent))
+			parent->children[parent->nr_children++] = tgi_array[i];
+
+	if (!(tgi_sorted = (struct task_group_info **)
+	    malloc(sizeof(void *) * tgi_p)))
+		error(FATAL, "cannot malloc task_group index\n");
+	BCOPY(tgi_array, tgi_sorted, sizeof(void *) * tgi_p);
+	qsort(tgi_sorted, tgi_p, sizeof(struct task_group_info *),
+		compare_task_group_info_addr);
+}
+
+static struct task_group_info *
+task_group_info_search(ulong group)
+{
+	struct task_group_info key, *kp, **found;
+
+	if (!tgi_sorted)
+		return NULL;
+
+	key.task_group = group;
+	kp = &key;
+	found = (struct task_group_info **)bsearch(&kp, tgi_sorted, tgi_p,
+		sizeof(struct task_group_info *), compare_task_group_info_addr);
+
+	return found ? *found : NULL;
+}
+
+static ulong
+task_group_cfs_rq(struct task_group_info *tgi, int cpu)
+{
+	if (!tgi->cfs_rq)
+		error(FATAL, "task_group %lx: no cfs_rq array\n",
+			tgi->task_group);
+	return tgi->cfs_rq[cpu];
+}
+
+static ulong
+task_group_rt_rq(struct task_group_info *tgi, int cpu)
+{
+	if (!tgi->rt_rq)
+		error(FATAL, "task_group %lx: no rt_rq array\n",
+			tgi->task_group);
+	return tgi->rt_rq[cpu];
 }
 
 static void
@@ -8227,9 +8863,9 @@ print_task_group_info_array(void)
 		fprintf(fp, "name=%s, ",
 			tgi_array[i]->name ? tgi_array[i]->name : "NULL");
 		if (tgi_array[i]->parent)
-			fprintf(fp, "parent=%lx",
+			fprintf(fp, "parent=%lx, ",
 				tgi_array[i]->parent->task_group);
-		fprintf(fp, "\n");
+		fprintf(fp, "children=%d\n", tgi_array[i]->nr_children);
 	}
 }
 
@@ -8238,13 +8874,25 @@ free_task_group_info_array(void)
 {
 	int i;
 
+	tgi_valid = FALSE;
+
 	for (i = 0; i < tgi_p; i++) {
 		if (tgi_array[i]->name)
-			FREEBUF(tgi_array[i]->name);
-		FREEBUF(tgi_array[i]);
-	}
-	tgi_p = 0;
-	FREEBUF(tgi_array);
+			free(tgi_array[i]->name);
+		if (tgi_array[i]->cfs_rq)
+			free(tgi_array[i]->cfs_rq);
+		if (tgi_array[i]->rt_rq)
+			free(tgi_array[i]->rt_rq);
+		if (tgi_array[i]->children)
+			free(tgi_array[i]->children);
+		free(tgi_array[i]);
+	}
+	tgi_p = tgi_p_max = 0;
+	if (tgi_array)
+		free(tgi_array);
+	if (tgi_sorted)
+		free(tgi_sorted);
+	tgi_array = tgi_sorted = NULL;
 }
 
 static void
@@ -8265,7 +8913,7 @@ dump_task_runq_entry(struct task_context *tc, int current)
 {
 	int prio;
 
-	readmem(tc->task + OFFSET(task_struct_prio), KVADDR, 
+	readmem(tc->task + OFFSET(task_struct_prio), KVADDR,
 		&prio, sizeof(int), "task prio", FAULT_ON_ERROR);
 	fprintf(fp, "[%3d] ", prio);
 	fprintf(fp, "PID: %-5ld  TASK: %lx  COMMAND: \"%s\"",
@@ -8276,6 +8924,154 @@ dump_task_runq_entry(struct task_context *tc, int current)
 		fprintf(fp, "\n");
 }
 
+/*
+ *  The state of a cfs_rq gathered with a single read of the cfs_rq, and
+ *  one read per rb_tree node that returns both the node's links and the
+ *  sched_entity's my_q pointer.
+ */
+struct cfs_rq_entity {
+	ulong se;
+	ulong my_q;
+};
+
+struct cfs_rq_state {
+	ulong tg;
+	ulong curr;
+	ulong curr_my_q;
+	int count;
+	int max;
+	int incomplete;
+	struct cfs_rq_entity *entity;
+};
+
+#define CFS_RQ_MAX_DEPTH  (128)
+
+static void
+add_cfs_rq_entity(struct cfs_rq_state *crs, ulong se, ulong my_q)
+{
+	if (crs->count == crs->max) {
+		crs->entity = (struct cfs_rq_entity *)resizebuf((char *)crs->entity,
+			sizeof(struct cfs_rq_entity) * crs->max,
+			sizeof(struct cfs_rq_entity) * crs->max * 2);
+		crs->max *= 2;
+	}
+
+	crs->entity[crs->count].se = se;
+	crs->entity[crs->count].my_q = my_q;
+	crs->count++;
+}
+
+static void
+walk_cfs_rq_tree(ulong cfs_rq, ulong root, struct cfs_rq_state *crs)
+{
+	struct {
+		ulong se;
+		ulong my_q;
+		ulong right;
+	} stack[CFS_RQ_MAX_DEPTH];
+	long start, end, run_node;
+	char *sebuf;
+	struct rb_node *rbn;
+	ulong node, se;
+	int sp, limit;
+
+	run_node = OFFSET(sched_entity_run_node);
+	start = run_node;
+	end = run_node + sizeof(struct rb_node);
+	if (VALID_MEMBER(sched_entity_my_q)) {
+		start = MIN(start, OFFSET(sched_entity_my_q));
+		end = MAX(end, OFFSET(sched_entity_my_q) + sizeof(ulong));
+	}
+	sebuf = GETBUF(end - start);
+
+	/*
+	 *  Queued group entities are bounded by the number of task groups;
+	 *  anything beyond that plus the task count is a corrupt tree.
+	 */
+	limit = (RUNNING_TASKS() * 2) + tgi_p + kt->cpus;
+	node = root;
+	sp = 0;
+
+	while (node || sp) {
+		while (node) {
+			if (sp == CFS_RQ_MAX_DEPTH) {
+				error(WARNING,
+				    "cfs_rq %lx: rb_tree depth exceeds %d\n",
+					cfs_rq, CFS_RQ_MAX_DEPTH);
+				crs->incomplete = TRUE;
+				goto done;
+			}
+			se = node - run_node;
+			if (!readmem(se + start, KVADDR, sebuf, end - start,
+			    "sched_entity", RETURN_ON_ERROR|QUIET)) {
+				error(INFO, "cfs_rq %lx: invalid sched_entity %lx\n",
+					cfs_rq, se);
+				crs->incomplete = TRUE;
+				goto done;
+			}
+			rbn = (struct rb_node *)(sebuf + (run_node - start));
+			stack[sp].se = se;
+			stack[sp].right = (ulong)rbn->rb_right;
+			stack[sp].my_q = VALID_MEMBER(sched_entity_my_q) ?
+				ULONG(sebuf + OFFSET(sched_entity_my_q) - start) : 0;
+			sp++;
+			node = (ulong)rbn->rb_left;
+		}
+
+		sp--;
+		add_cfs_rq_entity(crs, stack[sp].se, stack[sp].my_q);
+		node = stack[sp].right;
+
+		if (crs->count > limit) {
+			error(WARNING, "cfs_rq %lx: rb_tree exceeds %d entries\n",
+				cfs_rq, limit);
+			crs->incomplete = TRUE;
+			break;
+		}
+	}
+done:
+	FREEBUF(sebuf);
+}
+
+static void
+read_cfs_rq_state(ulong cfs_rq, struct cfs_rq_state *crs)
+{
+	char *cfs_rq_buf;
+	ulong leftmost, root;
+
+	BZERO(crs, sizeof(struct cfs_rq_state));
+	crs->max = 64;
+	crs->entity = (struct cfs_rq_entity *)
+		GETBUF(sizeof(struct cfs_rq_entity) * crs->max);
+
+	cfs_rq_buf = GETBUF(SIZE(cfs_rq));
+	readmem(cfs_rq, KVADDR, cfs_rq_buf, SIZE(cfs_rq), "cfs_rq",
+		FAULT_ON_ERROR);
+	if (VALID_MEMBER(cfs_rq_tg))
+		crs->tg = ULONG(cfs_rq_buf + OFFSET(cfs_rq_tg));
+	if (VALID_MEMBER(sched_entity_my_q))
+		crs->curr = ULONG(cfs_rq_buf + OFFSET(cfs_rq_curr));
+	leftmost = ULONG(cfs_rq_buf + OFFSET(cfs_rq_rb_leftmost));
+	root = ULONG(cfs_rq_buf + OFFSET(cfs_rq_tasks_timeline));
+	FREEBUF(cfs_rq_buf);
+
+	if (crs->curr)
+		readmem(crs->curr + OFFSET(sched_entity_my_q), KVADDR,
+			&crs->curr_my_q, sizeof(ulong), "curr->my_q",
+			FAULT_ON_ERROR);
+
+	if (leftmost && root)
+		walk_cfs_rq_tree(cfs_rq, root, crs);
+}
+
+static void
+free_cfs_rq_state(struct cfs_rq_state *crs)
+{
+	FREEBUF(crs->entity);
+	crs->entity = NULL;
+	crs->count = crs->max = 0;
+}
+
 static void
 print_group_header_fair(int depth, ulong cfs_rq, void *t)
 {
@@ -8302,7 +9098,6 @@ static void
 print_parent_task_group_fair(void *t, int cpu)
 {
 	struct task_group_info *tgi;
-	ulong cfs_rq_c, cfs_rq_p;
 
 	tgi = ((struct task_group_info *)t)->parent;
 	if (tgi && tgi->use)
@@ -8310,38 +9105,29 @@ print_parent_task_group_fair(void *t, int cpu)
 	else
 		return;
 
-	readmem(tgi->task_group + OFFSET(task_group_cfs_rq),
-		KVADDR, &cfs_rq_c, sizeof(ulong),
-		"task_group cfs_rq", FAULT_ON_ERROR);
-	readmem(cfs_rq_c + cpu * sizeof(ulong), KVADDR, &cfs_rq_p,
-		sizeof(ulong), "task_group cfs_rq", FAULT_ON_ERROR);
-
-	print_group_header_fair(tgi->depth, cfs_rq_p, tgi);
+	print_group_header_fair(tgi->depth, task_group_cfs_rq(tgi, cpu), tgi);
 	tgi->use = 0;
 }
 
 static int
-dump_tasks_in_lower_dequeued_cfs_rq(int depth, ulong cfs_rq, int cpu,
-	struct task_context *ctc)
+dump_tasks_in_lower_dequeued_cfs_rq(int depth, ulong cfs_rq, ulong group,
+	int cpu, struct task_context *ctc)
 {
 	int i, total, nr_running;
-	ulong group, cfs_rq_c, cfs_rq_p;
+	ulong cfs_rq_p;
+	struct task_group_info *parent, *tgi;
 
 	total = 0;
-	for (i = 0; i < tgi_p; i++) {
-		if (tgi_array[i]->use == 0 || tgi_array[i]->depth - depth != 1)
-			continue;
+	if (!(parent = task_group_info_search(group)) ||
+	    (parent->depth != depth))
+		return total;
 
-		readmem(cfs_rq + OFFSET(cfs_rq_tg), KVADDR, &group,
-			sizeof(ulong), "cfs_rq tg", FAULT_ON_ERROR);
-		if (group != tgi_array[i]->parent->task_group)
+	for (i = 0; i < parent->nr_children; i++) {
+		tgi = parent->children[i];
+		if (tgi->use == 0)
 			continue;
 
-		readmem(tgi_array[i]->task_group + OFFSET(task_group_cfs_rq),
-			KVADDR, &cfs_rq_c, sizeof(ulong), "task_group cfs_rq",
-			FAULT_ON_ERROR);
-		readmem(cfs_rq_c + cpu * sizeof(ulong), KVADDR, &cfs_rq_p,
-			sizeof(ulong), "task_group cfs_rq", FAULT_ON_ERROR);
+		cfs_rq_p = task_group_cfs_rq(tgi, cpu);
 		if (cfs_rq == cfs_rq_p)
 			continue;
 
@@ -8350,11 +9136,11 @@ dump_tasks_in_lower_dequeued_cfs_rq(int depth, ulong cfs_rq, int cpu,
 			FAULT_ON_ERROR);
 		if (nr_running == 0) {
 			total += dump_tasks_in_lower_dequeued_cfs_rq(depth + 1,
-				cfs_rq_p, cpu, ctc);
+				cfs_rq_p, tgi->task_group, cpu, ctc);
 			continue;
 		}
 
-		print_parent_task_group_fair(tgi_array[i], cpu);
+		print_parent_task_group_fair(tgi, cpu);
 
 		total++;
 		total += dump_tasks_in_task_group_cfs_rq(depth + 1, cfs_rq_p, cpu, ctc);
@@ -8367,42 +9153,23 @@ static int
 dump_tasks_in_cfs_rq(ulong cfs_rq)
 {
 	struct task_context *tc;
-	struct rb_root *root;
-	struct rb_node *node;
-	ulong my_q, leftmost, curr, curr_my_q;
-	int total;
+	struct cfs_rq_state cfs_rq_state, *crs;
+	int i, total;
 
 	total = 0;
+	crs = &cfs_rq_state;
+	read_cfs_rq_state(cfs_rq, crs);
 
-	if (VALID_MEMBER(sched_entity_my_q)) {
-		readmem(cfs_rq + OFFSET(cfs_rq_curr), KVADDR, &curr, 
-			sizeof(ulong), "curr", FAULT_ON_ERROR);
-		if (curr) {
-			readmem(curr + OFFSET(sched_entity_my_q), KVADDR, 
-				&curr_my_q, sizeof(ulong), "curr->my_q", 
-				FAULT_ON_ERROR);
-			if (curr_my_q)
-				total += dump_tasks_in_cfs_rq(curr_my_q);
-		}
-	}
+	if (crs->curr_my_q)
+		total += dump_tasks_in_cfs_rq(crs->curr_my_q);
 
-	readmem(cfs_rq + OFFSET(cfs_rq_rb_leftmost), KVADDR, &leftmost,
-		sizeof(ulong), "rb_leftmost", FAULT_ON_ERROR);
-	root = (struct rb_root *)(cfs_rq + OFFSET(cfs_rq_tasks_timeline));
-
-	for (node = rb_first(root); leftmost && node; node = rb_next(node)) {
-		if (VALID_MEMBER(sched_entity_my_q)) {
-			readmem((ulong)node - OFFSET(sched_entity_run_node)
-				+ OFFSET(sched_entity_my_q), KVADDR, &my_q,
-				sizeof(ulong), "my_q", FAULT_ON_ERROR);
-			if (my_q) {
-				total += dump_tasks_in_cfs_rq(my_q);
-				continue;
-			}
+	for (i = 0; i < crs->count; i++) {
+		if (crs->entity[i].my_q) {
+			total += dump_tasks_in_cfs_rq(crs->entity[i].my_q);
+			continue;
 		}
 
-		tc = task_to_context((ulong)node - OFFSET(task_struct_se) -
-				     OFFSET(sched_entity_run_node));
+		tc = task_to_context(crs->entity[i].se - OFFSET(task_struct_se));
 		if (!tc)
 			continue;
 		if (hq_enter((ulong)tc)) {
@@ -8411,11 +9178,17 @@ dump_tasks_in_cfs_rq(ulong cfs_rq)
 		} else {
 			error(WARNING, "duplicate CFS runqueue node: task %lx\n",
 				tc->task);
-			return total;
+			break;
 		}
 		total++;
 	}
 
+	if (crs->incomplete) {
+		INDENT(5);
+		fprintf(fp, "[cfs_rq %lx incomplete]\n", cfs_rq);
+	}
+	free_cfs_rq_state(crs);
+
 	return total;
 }
 
@@ -8424,72 +9197,45 @@ dump_tasks_in_task_group_cfs_rq(int depth, ulong cfs_rq, int cpu,
 	struct task_context *ctc)
 {
 	struct task_context *tc;
-	struct rb_root *root;
-	struct rb_node *node;
-	ulong my_q, leftmost, curr, curr_my_q, tg;
+	struct task_group_info *tgi;
+	struct cfs_rq_state cfs_rq_state, *crs;
 	int total, i;
 
 	total = 0;
-	curr_my_q = curr = 0;
+	crs = &cfs_rq_state;
+	read_cfs_rq_state(cfs_rq, crs);
 
-	if (depth) {
-		readmem(cfs_rq + OFFSET(cfs_rq_tg), KVADDR,
-			&tg, sizeof(ulong), "cfs_rq tg",
-			FAULT_ON_ERROR);
-		for (i = 0; i < tgi_p; i++) {
-			if (tgi_array[i]->task_group == tg) {
-				print_group_header_fair(depth,
-					cfs_rq, tgi_array[i]);
-				tgi_array[i]->use = 0;
-				break;
-			}
-		}
+	if (depth && (tgi = task_group_info_search(crs->tg))) {
+		print_group_header_fair(depth, cfs_rq, tgi);
+		tgi->use = 0;
 	}
 
-	if (VALID_MEMBER(sched_entity_my_q)) {
-		readmem(cfs_rq + OFFSET(cfs_rq_curr), KVADDR, &curr,
-			sizeof(ulong), "curr", FAULT_ON_ERROR);
-		if (curr) {
-			readmem(curr + OFFSET(sched_entity_my_q), KVADDR,
-				&curr_my_q, sizeof(ulong), "curr->my_q",
-				FAULT_ON_ERROR);
-			if (curr_my_q) {
-				total++;
-				total += dump_tasks_in_task_group_cfs_rq(depth + 1,
-					curr_my_q, cpu, ctc);
-			}
-		}
+	if (crs->curr_my_q) {
+		total++;
+		total += dump_tasks_in_task_group_cfs_rq(depth + 1,
+			crs->curr_my_q, cpu, ctc);
 	}
 
 	/*
 	 *  check if "curr" is the task that is current running task
 	 */
-	if (!curr_my_q && ctc && (curr - OFFSET(task_struct_se)) == ctc->task) {
+	if (!crs->curr_my_q && ctc &&
+	    (crs->curr - OFFSET(task_struct_se)) == ctc->task) {
 		/* curr is not in the rb tree, so let's print it here */
 		total++;
 		INDENT(5 + 3 * depth);
 		dump_task_runq_entry(ctc, 1);
 	}
 
-	readmem(cfs_rq + OFFSET(cfs_rq_rb_leftmost), KVADDR, &leftmost,
-		sizeof(ulong), "rb_leftmost", FAULT_ON_ERROR);
-	root = (struct rb_root *)(cfs_rq + OFFSET(cfs_rq_tasks_timeline));
-
-	for (node = rb_first(root); leftmost && node; node = rb_next(node)) {
-		if (VALID_MEMBER(sched_entity_my_q)) {
-			readmem((ulong)node - OFFSET(sched_entity_run_node)
-				+ OFFSET(sched_entity_my_q), KVADDR, &my_q,
-				sizeof(ulong), "my_q", FAULT_ON_ERROR);
-			if (my_q) {
-				total++;
-				total += dump_tasks_in_task_group_cfs_rq(depth + 1,
-					my_q, cpu, ctc);
-				continue;
-			}
+	for (i = 0; i < crs->count; i++) {
+		if (crs->entity[i].my_q) {
+			total++;
+			total += dump_tasks_in_task_group_cfs_rq(depth + 1,
+				crs->entity[i].my_q, cpu, ctc);
+			continue;
 		}
 
-		tc = task_to_context((ulong)node - OFFSET(task_struct_se) -
-				     OFFSET(sched_entity_run_node));
+		tc = task_to_context(crs->entity[i].se - OFFSET(task_struct_se));
 		if (!tc)
 			continue;
 		if (hq_enter((ulong)tc)) {
@@ -8498,14 +9244,22 @@ dump_tasks_in_task_group_cfs_rq(int depth, ulong cfs_rq, int cpu,
 		} else {
 			error(WARNING, "duplicate CFS runqueue node: task %lx\n",
 				tc->task);
+			free_cfs_rq_state(crs);
 			return total;
 		}
 		total++;
 	}
 
-	total += dump_tasks_in_lower_dequeued_cfs_rq(depth, cfs_rq, cpu, ctc);
+	if (crs->incomplete) {
+		INDENT(5 + 3 * depth);
+		fprintf(fp, "[cfs_rq %lx incomplete]\n", cfs_rq);
+	}
+
+	total += dump_tasks_in_lower_dequeued_cfs_rq(depth, cfs_rq, crs->tg,
+		cpu, ctc);
+	free_cfs_rq_state(crs);
 
-	if (!total) {
+	if (!total && !crs->incomplete) {
 		INDENT(5 + 3 * depth);
 		fprintf(fp, "[no tasks queued]\n");
 	}
@@ -8519,6 +9273,7 @@ dump_on_rq_tasks(void)
 	struct task_context *tc;
 	int i, cpu, on_rq, tot;
 	ulong *cpus;
+	char *queued;
 
 	if (!VALID_MEMBER(task_struct_on_rq)) {
 		MEMBER_OFFSET_INIT(task_struct_se, "task_struct", "se");
@@ -8536,6 +9291,29 @@ dump_on_rq_tasks(void)
 	cpus = pc->curcmd_flags & CPUMASK ? 
 		(ulong *)(ulong)pc->curcmd_private : NULL;
 
+	/*
+	 *  Gather the on_rq state of every task in one pass rather than
+	 *  re-reading each task once per cpu.
+	 */
+	queued = (char *)GETBUF(RUNNING_TASKS());
+	tc = FIRST_CONTEXT();
+	for (i = 0; i < RUNNING_TASKS(); i++, tc++) {
+		if (cpus && !NUM_IN_BITMAP(cpus, tc->processor))
+			continue;
+
+		if (VALID_MEMBER(task_struct_on_rq)) {
+			readmem(tc->task + OFFSET(task_struct_on_rq),
+				KVADDR, &on_rq, sizeof(int),
+				"task on_rq", FAULT_ON_ERROR);
+		} else {
+			readmem(tc->task + OFFSET(task_struct_se), KVADDR,
+				buf, SIZE(sched_entity), "task se",
+				FAULT_ON_ERROR);
+			on_rq = INT(buf + OFFSET(sched_entity_on_rq));
+		}
+		queued[i] = on_rq ? TRUE : FALSE;
+	}
+
 	for (cpu = 0; cpu < kt->cpus; cpu++) {
 		if (cpus && !NUM_IN_BITMAP(cpus, cpu))
 			continue;
@@ -8552,19 +9330,7 @@ dump_on_rq_tasks(void)
 		tot = 0;
 
 		for (i = 0; i < RUNNING_TASKS(); i++, tc++) {
-
-			if (VALID_MEMBER(task_struct_on_rq)) {
-				readmem(tc->task + OFFSET(task_struct_on_rq),
-					KVADDR, &on_rq, sizeof(int),
-					"task on_rq", FAULT_ON_ERROR);
-			} else {
-				readmem(tc->task + OFFSET(task_struct_se), KVADDR,
-					buf, SIZE(sched_entity), "task se",
-					FAULT_ON_ERROR);
-				on_rq = INT(buf + OFFSET(sched_entity_on_rq));
-			}
-
-			if (!on_rq || tc->processor != cpu)
+			if (!queued[i] || tc->processor != cpu)
 				continue;
 
 			INDENT(5);
@@ -8577,6 +9343,8 @@ dump_on_rq_tasks(void)
 			fprintf(fp, "[no tasks queued]\n");
 		}
 	}
+
+	FREEBUF(queued);
 }
 
 static void
@@ -8654,7 +9422,7 @@ dump_CFS_runqueues(void)
 {
 	int cpu, tot, displayed;
 	ulong runq, cfs_rq, prio_array;
-	char *runqbuf, *cfs_rq_buf;
+	char *runqbuf;
 	ulong tasks_timeline ATTRIBUTE_UNUSED;
 	struct task_context *tc;
 	struct rb_root *root;
@@ -8667,10 +9435,7 @@ dump_CFS_runqueues(void)
 		error(FATAL, "per-cpu runqueues do not exist\n");
 
         runqbuf = GETBUF(SIZE(runqueue));
-	if ((init_sp = per_cpu_symbol_search("per_cpu__init_cfs_rq")))
-		cfs_rq_buf = GETBUF(SIZE(cfs_rq));
-	else
-		cfs_rq_buf = NULL;
+	init_sp = per_cpu_symbol_search("per_cpu__init_cfs_rq");
 
 	get_active_set();
 	cpus = pc->curcmd_flags & CPUMASK ? 
@@ -8703,7 +9468,7 @@ dump_CFS_runqueues(void)
                 readmem(runq, KVADDR, runqbuf, SIZE(runqueue),
                         "per-cpu rq", FAULT_ON_ERROR);
 
-		if (cfs_rq_buf) {
+		if (init_sp) {
 			/*
 		 	 *  Use default task group's cfs_rq on each cpu.
 		 	 */
@@ -8712,8 +9477,6 @@ dump_CFS_runqueues(void)
 			else
 				cfs_rq = init_sp->value;
 
-			readmem(cfs_rq, KVADDR, cfs_rq_buf, SIZE(cfs_rq),
-				"per-cpu cfs_rq", FAULT_ON_ERROR);
 			root = (struct rb_root *)(cfs_rq + 
 				OFFSET(cfs_rq_tasks_timeline));
 		} else {
@@ -8745,8 +9508,6 @@ dump_CFS_runqueues(void)
 	}
 
 	FREEBUF(runqbuf);
-	if (cfs_rq_buf)
-		FREEBUF(cfs_rq_buf);
 }
 
 static void
@@ -8774,7 +9535,7 @@ print_parent_task_group_rt(void *t, int cpu)
 {
 	int prio;
 	struct task_group_info *tgi;
-	ulong rt_rq_c, rt_rq_p;
+	ulong rt_rq_p;
 
 
 	tgi = ((struct task_group_info *)t)->parent;
@@ -8783,11 +9544,7 @@ print_parent_task_group_rt(void *t, int cpu)
 	else
 		return;
 
-	readmem(tgi->task_group + OFFSET(task_group_rt_rq),
-		KVADDR, &rt_rq_c, sizeof(ulong),
-		"task_group rt_rq", FAULT_ON_ERROR);
-	readmem(rt_rq_c + cpu * sizeof(ulong), KVADDR, &rt_rq_p,
-		sizeof(ulong), "task_group rt_rq", FAULT_ON_ERROR);
+	rt_rq_p = task_group_rt_rq(tgi, cpu);
 
 	readmem(rt_rq_p + OFFSET(rt_rq_highest_prio), KVADDR, &prio,
 		sizeof(int), "rt_rq highest prio", FAULT_ON_ERROR);
@@ -8799,30 +9556,23 @@ print_parent_task_group_rt(void *t, int cpu)
 }
 
 static int
-dump_tasks_in_lower_dequeued_rt_rq(int depth, ulong rt_rq, int cpu)
+dump_tasks_in_lower_dequeued_rt_rq(int depth, ulong rt_rq, ulong group, int cpu)
 {
-	int i, prio, tot, delta, nr_running;
-	ulong rt_rq_c, rt_rq_p, group;
+	int i, prio, tot, nr_running;
+	ulong rt_rq_p;
+	struct task_group_info *parent, *tgi;
 
 	tot = 0;
-	for (i = 0; i < tgi_p; i++) {
-		delta = tgi_array[i]->depth - depth;
-		if (delta > 1)
-			break;
+	if (!(parent = task_group_info_search(group)) ||
+	    (parent->depth != depth))
+		return tot;
 
-		if (tgi_array[i]->use == 0 || delta < 1)
+	for (i = 0; i < parent->nr_children; i++) {
+		tgi = parent->children[i];
+		if (tgi->use == 0)
 			continue;
 
-		readmem(rt_rq + OFFSET(rt_rq_tg), KVADDR, &group,
-			sizeof(ulong), "rt_rq tg", FAULT_ON_ERROR);
-		if (group != tgi_array[i]->parent->task_group)
-			continue;
-
-		readmem(tgi_array[i]->task_group + OFFSET(task_group_rt_rq),
-			KVADDR, &rt_rq_c, sizeof(ulong), "task_group rt_rq",
-			FAULT_ON_ERROR);
-		readmem(rt_rq_c + cpu * sizeof(ulong), KVADDR, &rt_rq_p,
-			sizeof(ulong), "task_group rt_rq", FAULT_ON_ERROR);
+		rt_rq_p = task_group_rt_rq(tgi, cpu);
 		if (rt_rq == rt_rq_p)
 			continue;
 
@@ -8831,11 +9581,11 @@ dump_tasks_in_lower_dequeued_rt_rq(int depth, ulong rt_rq, int cpu)
 			FAULT_ON_ERROR);
 		if (nr_running == 0) {
 			tot += dump_tasks_in_lower_dequeued_rt_rq(depth + 1,
-				rt_rq_p, cpu);
+				rt_rq_p, tgi->task_group, cpu);
 			continue;
 		}
 
-		print_parent_task_group_rt(tgi_array[i], cpu);
+		print_parent_task_group_rt(tgi, cpu);
 
 		readmem(rt_rq_p + OFFSET(rt_rq_highest_prio), KVADDR,
 			&prio, sizeof(int), "rt_rq highest_prio",
@@ -8935,6 +9685,7 @@ dump_tasks_in_task_group_rt_rq(int depth, ulong rt_rq, int cpu)
 	ulong list_head[2];
         struct list_data list_data, *ld;
 	struct task_context *tc;
+	struct task_group_info *tgi;
 	ulong my_q, task_addr, tg, k_prio_array;
 	char *rt_rq_buf, *u_prio_array;
 
@@ -8942,18 +9693,11 @@ dump_tasks_in_task_group_rt_rq(int depth, ulong rt_rq, int cpu)
 	rt_rq_buf = GETBUF(SIZE(rt_rq));
 	readmem(rt_rq, KVADDR, rt_rq_buf, SIZE(rt_rq), "rt_rq", FAULT_ON_ERROR);
 	u_prio_array = &rt_rq_buf[OFFSET(rt_rq_active)];
+	tg = ULONG(rt_rq_buf + OFFSET(rt_rq_tg));
 
-	if (depth) {
-		readmem(rt_rq + OFFSET(rt_rq_tg), KVADDR,
-			&tg, sizeof(ulong), "rt_rq tg",
-			FAULT_ON_ERROR);
-		for (i = 0; i < tgi_p; i++) {
-			if (tgi_array[i]->task_group == tg) {
-				print_group_header_rt(rt_rq, tgi_array[i]);
-				tgi_array[i]->use = 0;
-				break;
-			}
-		}
+	if (depth && (tgi = task_group_info_search(tg))) {
+		print_group_header_rt(rt_rq, tgi);
+		tgi->use = 0;
 	}
 
         qheads = (i = ARRAY_LENGTH(rt_prio_array_queue)) ?
@@ -9016,7 +9760,7 @@ is_task:
 		FREEBUF(ld->list_ptr);
 	}
 
-	tot += dump_tasks_in_lower_dequeued_rt_rq(depth, rt_rq, cpu);
+	tot += dump_tasks_in_lower_dequeued_rt_rq(depth, rt_rq, tg, cpu);
 
 	if (!tot) {
 		INDENT(5 + 6 * depth);
@@ -9089,39 +9833,71 @@ get_task_group_name(ulong group)
 	return tmp;
 }
 
+static ulong *
+read_task_group_rq_array(char *group_buf, long offset, char *type)
+{
+	ulong kvaddr, *rq_array;
+
+	if ((offset < 0) || !(kvaddr = ULONG(group_buf + offset)))
+		return NULL;
+
+	if (!(rq_array = (ulong *)malloc(sizeof(ulong) * kt->cpus)))
+		error(FATAL, "cannot malloc task_group %s array\n", type);
+	if (!readmem(kvaddr, KVADDR, rq_array, sizeof(ulong) * kt->cpus,
+	    type, RETURN_ON_ERROR)) {
+		free(rq_array);
+		return NULL;
+	}
+
+	return rq_array;
+}
+
 static void
 fill_task_group_info_array(int depth, ulong group, char *group_buf, int i)
 {
 	int d;
 	ulong kvaddr, uvaddr, offset;
 	ulong list_head[2], next;
-	struct task_group_info **tgi_array_new;
+	struct task_group_info *tgi;
+	char *name;
+
+	if (tgi_p == tgi_p_max) {
+		tgi_p_max += MAX_GROUP_NUM;
+		if (!(tgi_array = (struct task_group_info **)
+		    realloc(tgi_array, sizeof(void *) * tgi_p_max)))
+			error(FATAL, "cannot realloc task_group array\n");
+	}
 
 	d = tgi_p;
-	tgi_array[tgi_p] = (struct task_group_info *)
-		GETBUF(sizeof(struct task_group_info));
+	if (!(tgi = (struct task_group_info *)
+	    calloc(1, sizeof(struct task_group_info))))
+		error(FATAL, "cannot calloc task_group_info\n");
+	tgi_array[tgi_p] = tgi;
+	tgi_p++;
+
 	if (depth)
-		tgi_array[tgi_p]->use = 1;
+		tgi->use = 1;
 	else
-		tgi_array[tgi_p]->use = 0;
+		tgi->use = 0;
 
-	tgi_array[tgi_p]->depth = depth;
-	tgi_array[tgi_p]->name = get_task_group_name(group);
-	tgi_array[tgi_p]->task_group = group;
+	tgi->depth = depth;
+	tgi->index = d;
+	if ((name = get_task_group_name(group))) {
+		tgi->name = strdup(name);
+		FREEBUF(name);
+	}
+	tgi->task_group = group;
 	if (i >= 0)
-		tgi_array[tgi_p]->parent = tgi_array[i];
+		tgi->parent = tgi_array[i];
 	else
-		tgi_array[tgi_p]->parent = NULL;
-	tgi_p++;
+		tgi->parent = NULL;
 
-	if (tgi_p == tgi_p_max) {
-		tgi_p_max += MAX_GROUP_NUM;
-		tgi_array_new = (struct task_group_info **)
-			GETBUF(sizeof(void *) * tgi_p_max);
-		BCOPY(tgi_array, tgi_array_new, sizeof(void *) * tgi_p);
-		FREEBUF(tgi_array);
-		tgi_array = tgi_array_new;
-	}
+	tgi->cfs_rq = read_task_group_rq_array(group_buf,
+		VALID_MEMBER(task_group_cfs_rq) ? OFFSET(task_group_cfs_rq) : -1,
+		"task_group cfs_rq");
+	tgi->rt_rq = read_task_group_rq_array(group_buf,
+		VALID_MEMBER(task_group_rt_rq) ? OFFSET(task_group_rt_rq) : -1,
+		"task_group rt_rq");
 
 	offset = OFFSET(task_group_children);
 	kvaddr = group + offset;
@@ -9146,10 +9922,11 @@ static void
 dump_tasks_by_task_group(void)
 {
 	int cpu, displayed;
-	ulong root_task_group, cfs_rq = 0, cfs_rq_p;
-	ulong rt_rq = 0, rt_rq_p;
+	ulong root_task_group, cfs_rq_p;
+	ulong rt_rq_p;
 	char *buf;
 	struct task_context *tc;
+	struct task_group_info *root;
 	char *task_group_name;
 	ulong *cpus;
 
@@ -9167,22 +9944,26 @@ dump_tasks_by_task_group(void)
 	} else
 		error(FATAL, "cannot determine root task_group\n");
 
-	tgi_p_max = MAX_GROUP_NUM;
-	tgi_array = (struct task_group_info **)GETBUF(sizeof(void *)
-		* tgi_p_max);
-	buf = GETBUF(SIZE(task_group));
-	readmem(root_task_group, KVADDR, buf, SIZE(task_group),
-		"task_group", FAULT_ON_ERROR);
-	if (VALID_MEMBER(task_group_rt_rq))
-		rt_rq = ULONG(buf + OFFSET(task_group_rt_rq));
-	if (VALID_MEMBER(task_group_cfs_rq))
-		cfs_rq = ULONG(buf + OFFSET(task_group_cfs_rq));
-
-	fill_task_group_info_array(0, root_task_group, buf, -1);
-	sort_task_group_info_array();
+	/*
+	 *  The hierarchy cannot change in a dumpfile, so it is only
+	 *  gathered by the first "runq -g" of the session.
+	 */
+	if (!tgi_valid || ACTIVE()) {
+		free_task_group_info_array();
+		buf = GETBUF(SIZE(task_group));
+		readmem(root_task_group, KVADDR, buf, SIZE(task_group),
+			"task_group", FAULT_ON_ERROR);
+		fill_task_group_info_array(0, root_task_group, buf, -1);
+		FREEBUF(buf);
+		sort_task_group_info_array();
+		tgi_valid = TRUE;
+	}
 	if (CRASHDEBUG(1))
 		print_task_group_info_array();
 
+	if (!(root = task_group_info_search(root_task_group)))
+		error(FATAL, "cannot find root task_group\n");
+
 	get_active_set();
 
 	cpus = pc->curcmd_flags & CPUMASK ? 
@@ -9192,14 +9973,8 @@ dump_tasks_by_task_group(void)
 		if (cpus && !NUM_IN_BITMAP(cpus, cpu))
 			continue;
 
-		if (rt_rq)
-			readmem(rt_rq + cpu * sizeof(ulong), KVADDR,
-				&rt_rq_p, sizeof(ulong), "task_group rt_rq",
-				FAULT_ON_ERROR);
-		if (cfs_rq)
-			readmem(cfs_rq + cpu * sizeof(ulong), KVADDR,
-				&cfs_rq_p, sizeof(ulong), "task_group cfs_rq",
-				FAULT_ON_ERROR);
+		rt_rq_p = root->rt_rq ? root->rt_rq[cpu] : 0;
+		cfs_rq_p = root->cfs_rq ? root->cfs_rq[cpu] : 0;
 		fprintf(fp, "%sCPU %d", displayed++ ? "\n" : "", cpu);
 
 		if (hide_offline_cpu(cpu)) {
@@ -9215,23 +9990,20 @@ dump_tasks_by_task_group(void)
 		else
 			fprintf(fp, "%lx\n", tt->active_set[cpu]);
 
-		if (rt_rq) {
+		if (root->rt_rq) {
 			fprintf(fp, "  %s_TASK_GROUP: %lx  RT_RQ: %lx\n",
 				task_group_name, root_task_group, rt_rq_p);
 			reuse_task_group_info_array();
 			dump_tasks_in_task_group_rt_rq(0, rt_rq_p, cpu);
 		}
 
-		if (cfs_rq) {
+		if (root->cfs_rq) {
 			fprintf(fp, "  %s_TASK_GROUP: %lx  CFS_RQ: %lx\n",
 				task_group_name, root_task_group, cfs_rq_p);
 			reuse_task_group_info_array();
 			dump_tasks_in_task_group_cfs_rq(0, cfs_rq_p, cpu, tc);
 		}
 	}
-
-	FREEBUF(buf);
-	free_task_group_info_array();
 }
 
 #undef _NSIG
@@ -9529,19 +10301,16 @@ do_sig_thread_group(ulong task)
 	print_task_header(fp, tc, 0);
 	dump_signal_data(tc, TASK_LEVEL|TASK_INDENT);
 
-	tc = FIRST_CONTEXT();
-        for (i = cnt = 0; i < RUNNING_TASKS(); i++, tc++) {
+	for (i = -1, cnt = 0; (tc = next_thread_group_task(tgid, &i)); ) {
 		if (tc->task == task)
 			continue;
 
-		if (task_tgid(tc->task)	== tgid) {
-			fprintf(fp, "\n  ");
-                        print_task_header(fp, tc, 0);
-			dump_signal_data(tc, TASK_LEVEL|TASK_INDENT);
-                        cnt++;
-			if (tc->pid == 0)
-				pc->curcmd_flags |= IDLE_TASK_SHOWN;
-                }
+		fprintf(fp, "\n  ");
+                print_task_header(fp, tc, 0);
+		dump_signal_data(tc, TASK_LEVEL|TASK_INDENT);
+                cnt++;
+		if (tc->pid == 0)
+			pc->curcmd_flags |= IDLE_TASK_SHOWN;
         }
 
 	fprintf(fp, "\n");
@@ -9593,6 +10362,7 @@ dump_signal_data(struct task_context *tc, ulong flags)
 	long size;
 	char *signal_buf, *uaddr;
 	ulong shared_pending, signal;
+	struct arena_scope scope;
 	char buf1[BUFSIZE];
 	char buf2[BUFSIZE];
 	char buf3[BUFSIZE];
@@ -9625,7 +10395,8 @@ dump_signal_data(struct task_context *tc, ulong flags)
 		SIZE(signal_queue) : SIZE(sigqueue));
 	if (VALID_SIZE(sighand_struct))
 		size = MAX(size, SIZE(sighand_struct));
-	signal_buf = GETBUF(size);
+	arena_scope_begin(&scope);
+	signal_buf = ARENA_ZALLOC(size);
 
 	if (signal_struct)
 		readmem(signal_struct, KVADDR, signal_buf,
@@ -9641,6 +10412,7 @@ dump_signal_data(struct task_context *tc, ulong flags)
 		fprintf(fp, "SIGNAL_STRUCT: %lx  ", signal_struct);
 		if (!signal_struct) {
 			fprintf(fp, "\n");
+			arena_scope_end(&scope);
 			return;
 		}
 		if (VALID_MEMBER(signal_struct_count))
@@ -9864,7 +10636,7 @@ dump_signal_data(struct task_context *tc, ulong flags)
 		} else
                		fprintf(fp, "  SIGQUEUE: (empty)\n");
 	}
-	FREEBUF(signal_buf);
+	arena_scope_end(&scope);
 }
 
 /*
@@ -9876,8 +10648,11 @@ static void sigqueue_list(ulong sigqueue) {
 	int sig;
 	char *signal_buf;
 	long size;
+	struct arena_scope scope;
+
         size = VALID_SIZE(signal_queue) ?  SIZE(signal_queue) : SIZE(sigqueue);
-        signal_buf = GETBUF(size);
+	arena_scope_begin(&scope);
+        signal_buf = ARENA_ALLOC(size);
 
         sigqueue_save = sigqueue;
         while (sigqueue) {
@@ -9906,7 +10681,7 @@ static void sigqueue_list(ulong sigqueue) {
 
                 sigqueue = next;
         }
-	FREEBUF(signal_buf);
+	arena_scope_end(&scope);
 
 }
 
@@ -16,33 +16,150 @@
  */
 
 #include "defs.h"
-#include <getopt.h>
+#include "diskdump.h"
+#include <elf.h>
 
-static struct option test_long_options[] = {
-	{"no", no_argument, 0, 0},
-        {"req", required_argument, 0, 0},
-	{0, 0, 0, 0}
+/*
+ *  The "test" command doubles as a benchmark and regression harness for
+ *  the dumpfile backends and the hot paths layered on top of them.  It
+ *  can generate synthetic ELF and compressed kdump images of any size,
+ *  and then time the raw backend reads of those images, independent of
+ *  any kernel; or it can time readmem(), kvtop(), value_search(),
+ *  hq_enter(), do_list() and the search command against the current
+ *  session.  A synthetic image can be generated and benchmarked without
+ *  a kernel or vmcore by entering "crash --test '<test arguments>'".
+ */
+
+#define TEST_ELF      (1)
+#define TEST_KDUMP    (2)
+
+#define TEST_DEFAULT_MB     (64)
+#define TEST_DEFAULT_COUNT  (10000)
+#define TEST_SPARSE_RUN     (512)	/* minimum pages per excluded run */
+#define TEST_MAX_RUNS       (16384)
+#define TEST_SEED           (0x9e3779b97f4a7c15ULL)
+#define TEST_SMALL_READ     (64)
+
+struct test_dumpfile {
+	char *file;
+	int format;
+	int compress;
+	int sparse;
+	ulong pagesize;
+	ulonglong pages;
+	ulonglong run;
+	ulonglong included;
+	ulonglong zlib_bytes;
+	ulonglong raw_pages;
+};
+
+static struct test_machine {
+	char *type;
+	int e_machine;
+	char *utsname;
+} test_machines[] = {
+	{ "X86_64", EM_X86_64,  "x86_64" },
+	{ "X86",    EM_386,     "i686" },
+	{ "ARM64",  EM_AARCH64, "aarch64" },
+	{ "ARM",    EM_ARM,     "arm" },
+	{ "PPC64",  EM_PPC64,   "ppc64" },
+	{ "PPC",    EM_PPC,     "ppc" },
+	{ "IA64",   EM_IA_64,   "ia64" },
+	{ "S390X",  EM_S390,    "s390x" },
+	{ "MIPS",   EM_MIPS,    "mips" },
+	{ NULL,     EM_NONE,    NULL },
 };
 
+static struct test_machine *test_machine(void);
+static ulonglong test_random(ulonglong *);
+static ulonglong test_mix(ulonglong);
+static int test_page_excluded(struct test_dumpfile *, ulonglong);
+static void test_fill_page(struct test_dumpfile *, ulonglong, char *);
+static void test_write(FILE *, void *, size_t, char *);
+static void generate_dumpfile(struct test_dumpfile *);
+static void generate_elf(struct test_dumpfile *, FILE *);
+static void generate_kdump(struct test_dumpfile *, FILE *);
+static double test_time(void);
+static void test_report_header(void);
+static void test_report(char *, char *, ulong, ulonglong, double, double, 
+	ulong, ulong);
+static int test_dumpfile_format(char *, ulong *, ulonglong *);
+static void bench_dumpfile(char *, ulong);
+static void bench_dumpfile_child(char *, ulong);
+static void bench_session(ulong);
+static void bench_command(char *, void (*)(void));
+
 /*
- *  Test your stuff here first if you'd like.  If anything's being done
- *  below in this routine, consider it leftover trash...
+ *  Generate a synthetic dumpfile, and/or benchmark the backends of one
+ *  or more dumpfiles, and/or benchmark the current session.
  */
 void
 cmd_test(void)
 {
-	int c;
-	int option_index;
+	int c, bench, session;
+	ulong count;
+	ulonglong size;
+	struct test_dumpfile test_dumpfile, *td;
+
+	td = &test_dumpfile;
+	BZERO(td, sizeof(struct test_dumpfile));
+	td->format = TEST_KDUMP;
+	td->compress = TRUE;
+	size = MEGABYTES((ulonglong)TEST_DEFAULT_MB);
+	bench = session = FALSE;
+	count = TEST_DEFAULT_COUNT;
 
-        while ((c = getopt_long(argcnt, args, "", 
-		test_long_options, &option_index)) != EOF) {
+        while ((c = getopt(argcnt, args, "g:f:m:c:s:n:bk")) != EOF) {
                 switch(c)
                 {
-                case 0:
-                        if (STREQ(test_long_options[option_index].name, "no"))
-                                fprintf(fp, "no argument\n");
-                        if (STREQ(test_long_options[option_index].name, "req"))
-                                fprintf(fp, "required argument: %s\n", optarg);
+		case 'g':
+			td->file = optarg;
+			break;
+
+		case 'f':
+			if (STREQ(optarg, "elf"))
+				td->format = TEST_ELF;
+			else if (STREQ(optarg, "kdump"))
+				td->format = TEST_KDUMP;
+			else
+				error(FATAL, "invalid dumpfile format: %s\n",
+					optarg);
+			break;
+
+		case 'm':
+			size = MEGABYTES((ulonglong)stol(optarg, FAULT_ON_ERROR, NULL));
+			if (!size)
+				error(FATAL, "invalid size: %s\n", optarg);
+			break;
+
+		case 'c':
+			if (STREQ(optarg, "zlib"))
+				td->compress = TRUE;
+			else if (STREQ(optarg, "none"))
+				td->compress = FALSE;
+			else
+				error(FATAL, "invalid compression type: %s\n",
+					optarg);
+			break;
+
+		case 's':
+			td->sparse = stol(optarg, FAULT_ON_ERROR, NULL);
+			if ((td->sparse < 0) || (td->sparse > 99))
+				error(FATAL, "sparse percentage must be 0 to 99\n");
+			break;
+
+		case 'n':
+			count = stol(optarg, FAULT_ON_ERROR, NULL);
+			if (!count)
+				error(FATAL, "invalid count: %s\n", optarg);
+			break;
+
+		case 'b':
+			bench = TRUE;
+			break;
+
+		case 'k':
+			session = TRUE;
 			break;
 
                 default:
@@ -51,13 +168,696 @@ cmd_test(void)
 		}
 	}
 
-        if (argerrs)
+        if (argerrs || (!td->file && !bench && !session))
                 cmd_usage(pc->curcmd, SYNOPSIS);
 
-        while (args[optind]) {
-                ;
-                optind++;
-        }
+	if (td->file) {
+		td->pagesize = machdep->pagesize ? 
+			machdep->pagesize : (ulong)sysconf(_SC_PAGESIZE);
+		td->pages = size / td->pagesize;
+		generate_dumpfile(td);
+	}
+
+	if (bench) {
+		if (!args[optind] && !td->file)
+			cmd_usage(pc->curcmd, SYNOPSIS);
+
+		test_report_header();
+		if (td->file)
+			bench_dumpfile(td->file, count);
+        	while (args[optind])
+			bench_dumpfile(args[optind++], count);
+	}
+
+	if (session) {
+		if (!(pc->flags & RUNTIME))
+			error(FATAL, "-k requires a kernel session\n");
+		if (!bench)
+			test_report_header();
+		bench_session(count);
+	}
+}
+
+static struct test_machine *
+test_machine(void)
+{
+	struct test_machine *tm;
+
+	for (tm = &test_machines[0]; tm->type; tm++) {
+		if (machine_type(tm->type))
+			return tm;
+	}
+
+	error(FATAL, "synthetic dumpfiles not supported on %s\n", MACHINE_TYPE);
+
+	return NULL;
+}
+
+/*
+ *  xorshift64* -- the sequence only needs to be cheap and repeatable.
+ */
+static ulonglong
+test_random(ulonglong *state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+
+	return *state * 0x2545f4914f6cdd1dULL;
+}
+
+static ulonglong
+test_mix(ulonglong x)
+{
+	x += TEST_SEED;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+
+	return x ^ (x >> 31);
+}
+
+/*
+ *  Pages are excluded in runs of td->run pages, and the first run is 
+ *  always present.
+ */
+static int
+test_page_excluded(struct test_dumpfile *td, ulonglong pfn)
+{
+	ulonglong run;
+
+	if (!td->sparse || ((run = pfn / td->run) == 0))
+		return FALSE;
+
+	return ((test_mix(run) % 100) < td->sparse);
+}
+
+/*
+ *  Each page starts with its own physical address so that the benchmark
+ *  can verify what the backend returns.  The first quarter of the page
+ *  is random, and the remainder is a repeating pattern, which gives zlib
+ *  roughly the same work as a typical kernel page.
+ */
+static void
+test_fill_page(struct test_dumpfile *td, ulonglong pfn, char *page)
+{
+	ulonglong *p, state;
+	int i, words;
+
+	p = (ulonglong *)page;
+	words = td->pagesize / sizeof(ulonglong);
+	state = test_mix(pfn) | 1;
+
+	p[0] = pfn * td->pagesize;
+	for (i = 1; i < words/4; i++)
+		p[i] = test_random(&state);
+	for ( ; i < words; i++)
+		p[i] = pfn & 0xff;
+}
+
+static void
+test_write(FILE *ofp, void *buf, size_t size, char *what)
+{
+	if (fwrite(buf, 1, size, ofp) != size)
+		error(FATAL, "cannot write %s: %s\n", what, strerror(errno));
+}
+
+static void
+generate_dumpfile(struct test_dumpfile *td)
+{
+	FILE *ofp;
+	double start, secs;
+	ulonglong pfn;
+
+	if (!td->pages)
+		error(FATAL, "dumpfile size is less than a page\n");
+
+	td->run = MAX(TEST_SPARSE_RUN, td->pages / TEST_MAX_RUNS);
+	for (pfn = td->included = 0; pfn < td->pages; pfn++) {
+		if (!test_page_excluded(td, pfn))
+			td->included++;
+	}
+
+	if ((ofp = fopen(td->file, "w")) == NULL)
+		error(FATAL, "cannot open %s: %s\n", td->file, strerror(errno));
+
+	start = test_time();
+
+	switch (td->format)
+	{
+	case TEST_ELF:
+		generate_elf(td, ofp);
+		break;
+	case TEST_KDUMP:
+		generate_kdump(td, ofp);
+		break;
+	}
+
+	if (fclose(ofp))
+		error(FATAL, "cannot write %s: %s\n", td->file, strerror(errno));
+
+	secs = test_time() - start;
+
+	fprintf(fp, "%s: %s  pages: %lld of %lld  page size: %ld", 
+		td->file, td->format == TEST_ELF ? "ELF kdump" : 
+		"compressed kdump", td->included, td->pages, td->pagesize);
+	if (td->format == TEST_KDUMP)
+		fprintf(fp, "  compression: %s (%lld%% raw)", 
+			td->compress ? "zlib" : "none", td->included ?
+			(td->raw_pages * 100) / td->included : 0);
+	fprintf(fp, "  (%.2f secs)\n", secs);
+}
+
+/*
+ *  An ELF64 kdump with a PT_NOTE header followed by one PT_LOAD segment 
+ *  for each range of contiguous included pages.  As with /proc/vmcore,
+ *  p_align is zero and the first segment is not page-aligned.
+ */
+static void
+generate_elf(struct test_dumpfile *td, FILE *ofp)
+{
+	Elf64_Ehdr ehdr;
+	Elf64_Phdr *phdr, *load;
+	ulonglong pfn, offset;
+	int i, nsegs;
+	char *page;
+
+	phdr = (Elf64_Phdr *)GETBUF(sizeof(Elf64_Phdr) * 
+		(1 + (td->pages / td->run) + 1));
+
+	nsegs = 0;
+	load = NULL;
+	for (pfn = 0; pfn < td->pages; pfn++) {
+		if (test_page_excluded(td, pfn)) {
+			load = NULL;
+			continue;
+		}
+		if (!load) {
+			load = &phdr[++nsegs];
+			load->p_type = PT_LOAD;
+			load->p_flags = PF_R|PF_W|PF_X;
+			load->p_paddr = pfn * td->pagesize;
+			load->p_vaddr = load->p_paddr;
+		}
+		load->p_filesz += td->pagesize;
+		load->p_memsz += td->pagesize;
+	}
+
+	BZERO(&ehdr, sizeof(Elf64_Ehdr));
+	memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+	ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+	ehdr.e_ident[EI_DATA] = (__BYTE_ORDER == __LITTLE_ENDIAN) ? 
+		ELFDATA2LSB : ELFDATA2MSB;
+	ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+	ehdr.e_type = ET_CORE;
+	ehdr.e_machine = test_machine()->e_machine;
+	ehdr.e_version = EV_CURRENT;
+	ehdr.e_phoff = sizeof(Elf64_Ehdr);
+	ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+	ehdr.e_phentsize = sizeof(Elf64_Phdr);
+	ehdr.e_phnum = 1 + nsegs;
+
+	offset = sizeof(Elf64_Ehdr) + (sizeof(Elf64_Phdr) * ehdr.e_phnum);
+	phdr[0].p_type = PT_NOTE;
+	phdr[0].p_offset = offset;
+	for (i = 1; i <= nsegs; i++) {
+		phdr[i].p_offset = offset;
+		offset += phdr[i].p_filesz;
+	}
+
+	test_write(ofp, &ehdr, sizeof(Elf64_Ehdr), "ELF header");
+	test_write(ofp, phdr, sizeof(Elf64_Phdr) * ehdr.e_phnum, 
+		"ELF program headers");
+
+	page = GETBUF(td->pagesize);
+	for (pfn = 0; pfn < td->pages; pfn++) {
+		if (test_page_excluded(td, pfn))
+			continue;
+		test_fill_page(td, pfn, page);
+		test_write(ofp, page, td->pagesize, "page data");
+	}
+
+	FREEBUF(page);
+	FREEBUF(phdr);
+}
+
+/*
+ *  A version 6 compressed kdump laid out the way makedumpfile does:
+ *  header block, kdump sub-header block, the 1st (RAM) and 2nd (dumpable)
+ *  bitmaps, the page descriptor table, and then the page data.  Excluded
+ *  pages are RAM but not dumpable, so reads of them fail with 
+ *  PAGE_EXCLUDED just as they do with a filtered vmcore.
+ */
+static void
+generate_kdump(struct test_dumpfile *td, FILE *ofp)
+{
+	struct disk_dump_header *dh;
+	struct kdump_sub_header *ksh;
+	page_desc_t *pd, *pdp;
+	ulonglong pfn, bitmap_blocks;
+	off_t offset;
+	char *bitmap, *page, *cbuf;
+	ulong bitmap_len;
+	uLongf clen;
+	int bs;
+
+	bs = td->pagesize;
+	bitmap_blocks = divideup(divideup(td->pages, 8), bs);
+	bitmap_len = bitmap_blocks * bs;
+
+	if ((pd = (page_desc_t *)calloc(td->included, sizeof(page_desc_t))) == NULL)
+		error(FATAL, "cannot calloc %lld page descriptors\n",
+			td->included);
+
+	dh = (struct disk_dump_header *)GETBUF(bs);
+	memcpy(dh->signature, KDUMP_SIGNATURE, SIG_LEN);
+	dh->header_version = 6;
+	strcpy(dh->utsname.sysname, "Linux");
+	strcpy(dh->utsname.nodename, "crash-test");
+	strcpy(dh->utsname.release, "synthetic");
+	strcpy(dh->utsname.machine, test_machine()->utsname);
+	gettimeofday(&dh->timestamp, NULL);
+	dh->status = td->compress ? DUMP_DH_COMPRESSED_ZLIB : 0;
+	dh->block_size = bs;
+	dh->sub_hdr_size = 1;
+	dh->bitmap_blocks = bitmap_blocks * 2;
+	dh->max_mapnr = (uint)td->pages;
+	dh->total_ram_blocks = (uint)td->included;
+	dh->nr_cpus = 1;
+	test_write(ofp, dh, bs, "kdump header");
+
+	ksh = (struct kdump_sub_header *)GETBUF(bs);
+	ksh->dump_level = 31;
+	ksh->end_pfn = (ulong)td->pages;
+	ksh->end_pfn_64 = td->pages;
+	ksh->max_mapnr_64 = td->pages;
+	test_write(ofp, ksh, bs, "kdump sub-header");
+
+	bitmap = GETBUF(bitmap_len);
+	for (pfn = 0; pfn < td->pages; pfn++)
+		bitmap[pfn >> 3] |= (1 << (pfn & 7));
+	test_write(ofp, bitmap, bitmap_len, "1st bitmap");
+	for (pfn = 0; pfn < td->pages; pfn++) {
+		if (test_page_excluded(td, pfn))
+			bitmap[pfn >> 3] &= ~(1 << (pfn & 7));
+	}
+	test_write(ofp, bitmap, bitmap_len, "2nd bitmap");
+
+	/*
+	 *  Write the page data first, and go back for the descriptors.
+	 */
+	offset = (off_t)bs * (1 + dh->sub_hdr_size + dh->bitmap_blocks);
+	offset += sizeof(page_desc_t) * td->included;
+	if (fseeko(ofp, offset, SEEK_SET) < 0)
+		error(FATAL, "cannot seek in %s: %s\n", td->file, strerror(errno));
+
+	page = GETBUF(bs);
+	cbuf = GETBUF(compressBound(bs));
+
+	for (pfn = 0, pdp = pd; pfn < td->pages; pfn++) {
+		if (test_page_excluded(td, pfn))
+			continue;
+		test_fill_page(td, pfn, page);
+		clen = compressBound(bs);
+		pdp->offset = offset;
+		if (td->compress && 
+		    (compress2((Bytef *)cbuf, &clen, (Bytef *)page, bs, 
+		    Z_BEST_SPEED) == Z_OK) && (clen < bs)) {
+			pdp->size = clen;
+			pdp->flags = DUMP_DH_COMPRESSED_ZLIB;
+			test_write(ofp, cbuf, clen, "page data");
+			td->zlib_bytes += clen;
+		} else {
+			pdp->size = bs;
+			test_write(ofp, page, bs, "page data");
+			td->raw_pages++;
+		}
+		offset += pdp->size;
+		pdp++;
+	}
+
+	offset = (off_t)bs * (1 + dh->sub_hdr_size + dh->bitmap_blocks);
+	if (fseeko(ofp, offset, SEEK_SET) < 0)
+		error(FATAL, "cannot seek in %s: %s\n", td->file, strerror(errno));
+	test_write(ofp, pd, sizeof(page_desc_t) * td->included, 
+		"page descriptors");
+
+	free(pd);
+	FREEBUF(cbuf);
+	FREEBUF(page);
+	FREEBUF(bitmap);
+	FREEBUF(ksh);
+	FREEBUF(dh);
+}
+
+static double
+test_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + ((double)ts.tv_nsec / 1000000000.0);
+}
+
+static void
+test_report_header(void)
+{
+	fprintf(fp, "%-16s  %-12s  %8s  %9s  %8s  %9s  %8s  %8s  %6s  %s\n",
+		"BACKEND", "TEST", "OPS", "MBYTES", "SECS", "MB/SEC", 
+		"USEC/OP", "MAX", "MISSED", "BAD");
+}
+
+static void
+test_report(char *backend, char *test, ulong ops, ulonglong bytes, 
+	double secs, double max, ulong missed, ulong bad)
+{
+	char buf[BUFSIZE];
+
+	if (max > 0.0)
+		sprintf(buf, "%8.2f", max * 1000000.0);
+	else
+		sprintf(buf, "%8s", "-");
+
+	fprintf(fp, "%-16s  %-12s  %8ld  %9.1f  %8.3f  %9.1f  %8.2f  %s  %6ld  %ld\n",
+		backend, test, ops, (double)bytes / (double)MEGABYTES(1), secs, 
+		secs > 0.0 ? ((double)bytes / (double)MEGABYTES(1)) / secs : 0.0,
+		ops ? (secs * 1000000.0) / ops : 0.0, buf, missed, bad);
+}
+
+/*
+ *  Determine the format, page size and physical page count of a dumpfile
+ *  directly from its headers, independent of the backend under test.
+ */
+static int
+test_dumpfile_format(char *file, ulong *pagesize, ulonglong *pages)
+{
+	Elf64_Ehdr ehdr;
+	Elf64_Phdr phdr;
+	struct disk_dump_header dh;
+	struct kdump_sub_header ksh;
+	ulonglong end;
+	int i, fd, format;
+
+	if ((fd = open(file, O_RDONLY)) < 0)
+		error(FATAL, "%s: %s\n", file, strerror(errno));
+
+	format = 0;
+	*pagesize = machdep->pagesize ? 
+		machdep->pagesize : (ulong)sysconf(_SC_PAGESIZE);
+
+	if ((pread(fd, &dh, sizeof(dh), 0) == sizeof(dh)) &&
+	    STRNEQ(dh.signature, KDUMP_SIGNATURE) &&
+	    (pread(fd, &ksh, sizeof(ksh), dh.block_size) == sizeof(ksh))) {
+		*pagesize = dh.block_size;
+		*pages = dh.header_version >= 6 ? 
+			ksh.max_mapnr_64 : dh.max_mapnr;
+		format = TEST_KDUMP;
+	} else if ((pread(fd, &ehdr, sizeof(ehdr), 0) == sizeof(ehdr)) &&
+	    STRNEQ(ehdr.e_ident, ELFMAG) && 
+	    (ehdr.e_ident[EI_CLASS] == ELFCLASS64)) {
+		for (i = 0, end = 0; i < ehdr.e_phnum; i++) {
+			if (pread(fd, &phdr, sizeof(phdr), ehdr.e_phoff + 
+			    (i * sizeof(phdr))) != sizeof(phdr))
+				break;
+			if (phdr.p_type == PT_LOAD)
+				end = MAX(end, phdr.p_paddr + phdr.p_memsz);
+		}
+		*pages = end / *pagesize;
+		format = TEST_ELF;
+	}
+
+	close(fd);
+
+	return format;
+}
+
+/*
+ *  The backends keep their state in static data that the current session
+ *  depends upon, so each dumpfile is benchmarked in a child process.
+ */
+static void
+bench_dumpfile(char *file, ulong count)
+{
+	pid_t pid;
+	int status;
+
+	fflush(fp);
+
+	if ((pid = fork()) < 0)
+		error(FATAL, "fork: %s\n", strerror(errno));
+
+	if (pid == 0)
+		bench_dumpfile_child(file, count);
+
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR)
+			error(FATAL, "waitpid: %s\n", strerror(errno));
+	}
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status))
+		error(INFO, "%s: benchmark failed\n", file);
+}
+
+static void
+bench_dumpfile_child(char *file, ulong count)
+{
+	int (*readfn)(int, void *, int, ulong, physaddr_t);
+	char *backend, *buf;
+	ulonglong pfn, pages, bytes, state;
+	physaddr_t paddr;
+	ulong i, pagesize, missed, bad;
+	double start, t, max;
+	int ret, format;
+
+	/*
+	 *  A FATAL error must not return to the parent's command loop.
+	 */
+	if (setjmp(pc->main_loop_env)) {
+		fflush(fp);
+		_exit(1);
+	}
+	pc->flags |= RUNTIME;
+	pc->flags &= ~IN_FOREACH;
+	pc->flags2 &= ~(FLAT|INCOMPLETE_DUMP);
+
+	if (!(format = test_dumpfile_format(file, &pagesize, &pages)))
+		error(FATAL, "%s: not an ELF or compressed kdump dumpfile\n",
+			file);
+	if (!pages)
+		error(FATAL, "%s: no physical memory\n", file);
+
+	machdep->pagesize = pagesize;
+	machdep->pageshift = ffs(pagesize) - 1;
+	machdep->pageoffset = pagesize - 1;
+	machdep->pagemask = ~((ulonglong)machdep->pageoffset);
+
+	clear_diskdump_data();
+	clear_netdump_data();
+
+	if ((format == TEST_KDUMP) && is_diskdump(file)) {
+		readfn = read_diskdump;
+		backend = "compressed kdump";
+	} else if ((format == TEST_ELF) && is_netdump(file, KDUMP_LOCAL)) {
+		readfn = read_netdump;
+		backend = "ELF kdump";
+	} else
+		error(FATAL, "%s: backend does not recognize the dumpfile\n", 
+			file);
+
+	buf = GETBUF(pagesize);
+
+	start = test_time();
+	for (pfn = bytes = missed = bad = 0; pfn < pages; pfn++) {
+		paddr = (physaddr_t)pfn * pagesize;
+		if ((ret = readfn(-1, buf, pagesize, 0, paddr)) != pagesize) {
+			missed++;
+			continue;
+		}
+		if (*((ulonglong *)buf) != paddr)
+			bad++;
+		bytes += pagesize;
+	}
+	test_report(backend, "sequential", pages, bytes, 
+		test_time() - start, 0.0, missed, bad);
+
+	state = TEST_SEED;
+	start = test_time();
+	for (i = bytes = missed = bad = 0, max = 0.0; i < count; i++) {
+		paddr = (physaddr_t)(test_random(&state) % pages) * pagesize;
+		t = test_time();
+		ret = readfn(-1, buf, pagesize, 0, paddr);
+		max = MAX(max, test_time() - t);
+		if (ret != pagesize) {
+			missed++;
+			continue;
+		}
+		if (*((ulonglong *)buf) != paddr)
+			bad++;
+		bytes += pagesize;
+	}
+	test_report(backend, "random", count, bytes, 
+		test_time() - start, max, missed, bad);
+
+	start = test_time();
+	for (i = bytes = missed = 0, max = 0.0; i < count; i++) {
+		paddr = (physaddr_t)(test_random(&state) % pages) * pagesize;
+		paddr += test_random(&state) % (pagesize - TEST_SMALL_READ);
+		t = test_time();
+		ret = readfn(-1, buf, TEST_SMALL_READ, 0, paddr);
+		max = MAX(max, test_time() - t);
+		if (ret != TEST_SMALL_READ) {
+			missed++;
+			continue;
+		}
+		bytes += TEST_SMALL_READ;
+	}
+	test_report(backend, "random-small", count, bytes, 
+		test_time() - start, max, missed, 0);
+
+	fflush(fp);
+	_exit(0);
+}
+
+/*
+ *  Time the translation, lookup and list-walking paths against the
+ *  kernel text of the current session.
+ */
+static void
+bench_session(ulong count)
+{
+	ulong i, text, vaddr, offset, missed, found;
+	ulonglong bytes, state;
+	physaddr_t paddr;
+	struct list_data list_data, *ld;
+	double start, t, max;
+	char *buf;
+	char cmd[BUFSIZE];
+	long tasks;
+	int cnt, reps;
+
+	if (!kt->stext || (kt->etext <= kt->stext))
+		error(FATAL, "kernel text range is not available\n");
+
+	text = kt->etext - kt->stext;
+	buf = GETBUF(PAGESIZE());
+
+	state = TEST_SEED;
+	start = test_time();
+	for (i = bytes = missed = 0, max = 0.0; i < count; i++) {
+		vaddr = (kt->stext + (test_random(&state) % text)) & 
+			~((ulong)PAGESIZE() - 1);
+		t = test_time();
+		if (readmem(vaddr, KVADDR, buf, PAGESIZE(), "test", 
+		    RETURN_ON_ERROR|QUIET))
+			bytes += PAGESIZE();
+		else
+			missed++;
+		max = MAX(max, test_time() - t);
+	}
+	test_report("readmem", "random", count, bytes, 
+		test_time() - start, max, missed, 0);
+
+	start = test_time();
+	for (i = bytes = missed = 0, max = 0.0; i < count; i++) {
+		vaddr = kt->stext + (test_random(&state) % text);
+		t = test_time();
+		if (readmem(vaddr, KVADDR, buf, sizeof(ulong), "test", 
+		    RETURN_ON_ERROR|QUIET))
+			bytes += sizeof(ulong);
+		else
+			missed++;
+		max = MAX(max, test_time() - t);
+	}
+	test_report("readmem", "random-small", count, bytes, 
+		test_time() - start, max, missed, 0);
+
+	start = test_time();
+	for (i = missed = 0, max = 0.0; i < count; i++) {
+		vaddr = kt->stext + (test_random(&state) % text);
+		t = test_time();
+		if (!kvtop(NULL, vaddr, &paddr, 0))
+			missed++;
+		max = MAX(max, test_time() - t);
+	}
+	test_report("kvtop", "random", count, 0, 
+		test_time() - start, max, missed, 0);
+
+	start = test_time();
+	for (i = missed = 0, max = 0.0; i < count; i++) {
+		vaddr = kt->stext + (test_random(&state) % text);
+		t = test_time();
+		if (!value_search(vaddr, &offset))
+			missed++;
+		max = MAX(max, test_time() - t);
+	}
+	test_report("value_search", "random", count, 0, 
+		test_time() - start, max, missed, 0);
+
+	if (hq_open()) {
+		start = test_time();
+		for (i = missed = 0; i < count; i++) {
+			if (!hq_enter(test_random(&state)))
+				missed++;
+		}
+		t = test_time() - start;
+		hq_close();
+		test_report("hq_enter", "random", count, 0, t, 0.0, missed, 0);
+	}
+
+	tasks = MEMBER_OFFSET("task_struct", "tasks");
+	if ((tasks >= 0) && symbol_exists("init_task")) {
+		ld = &list_data;
+		reps = MAX(1, count / 1000);
+		start = test_time();
+		for (i = found = missed = 0; i < reps; i++) {
+			BZERO(ld, sizeof(struct list_data));
+			ld->flags = LIST_HEAD_FORMAT|LIST_HEAD_POINTER|
+				LIST_ALLOCATE|RETURN_ON_LIST_ERROR;
+			ld->end = symbol_value("init_task") + tasks;
+			if (!readmem(ld->end, KVADDR, &ld->start, sizeof(void *),
+			    "init_task.tasks", RETURN_ON_ERROR|QUIET)) {
+				missed++;
+				continue;
+			}
+			ld->list_head_offset = tasks;
+			if ((cnt = do_list(ld)) < 0)
+				missed++;
+			else
+				found += cnt;
+			if (ld->list_ptr)
+				FREEBUF(ld->list_ptr);
+		}
+		test_report("do_list", "tasks", found, 0, 
+			test_time() - start, 0.0, missed, 0);
+	}
+
+	sprintf(cmd, "search -k -s %lx -e %lx %lx", 
+		kt->stext, kt->etext, (ulong)test_random(&state));
+	start = test_time();
+	bench_command(cmd, cmd_search);
+	test_report("search", "text", 1, text, test_time() - start, 
+		0.0, 0, 0);
+
+	FREEBUF(buf);
+}
+
+/*
+ *  Run a command with its output discarded.
+ */
+static void
+bench_command(char *cmdline, void (*func)(void))
+{
+	char buf[BUFSIZE];
+	FILE *saved_fp;
+
+	strcpy(buf, cmdline);
+	argcnt = parse_line(buf, args);
+	optind = 0;
+
+	saved_fp = fp;
+	fp = pc->nullfp;
+	(*func)();
+	fp = saved_fp;
 }
 
 /* 
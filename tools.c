@@ -24,8 +24,12 @@ struct hq_entry;
 static void dealloc_hq_entry(struct hq_entry *);
 static void show_options(void);
 static void dump_struct_members(struct list_data *, int, ulong);
-static void rbtree_iteration(ulong, struct tree_data *, char *);
-static void rdtree_iteration(ulong, struct tree_data *, char *, ulong, uint);
+struct req_list;
+static struct req_list *compile_struct_requests(char **, int);
+static void free_struct_requests(struct req_list *);
+static int dump_struct_requests(struct req_list *, ulong, unsigned int, ulong);
+static void rbtree_iteration(ulong, struct tree_data *, char *, struct req_list *);
+static void rdtree_iteration(ulong, struct tree_data *, char *, ulong, uint, struct req_list *);
 static void dump_struct_members_for_tree(struct tree_data *, int, ulong);
 
 /*
@@ -2385,6 +2389,65 @@ cmd_set(void)
 
 			return;
 
+                } else if (STREQ(args[optind], "live_cache")) {
+
+                        if (args[optind+1]) {
+                                optind++;
+                                if (STREQ(args[optind], "on"))
+                                        pc->flags2 &= 
+						~(LIVE_CACHE_OFF|LIVE_CACHE_FROZEN);
+                                else if (STREQ(args[optind], "off"))
+                                        pc->flags2 = (pc->flags2 & 
+						~LIVE_CACHE_FROZEN) | LIVE_CACHE_OFF;
+                                else if (STREQ(args[optind], "frozen"))
+                                        pc->flags2 = (pc->flags2 & 
+						~LIVE_CACHE_OFF) | LIVE_CACHE_FROZEN;
+                                else
+                                        goto invalid_set_command;
+				if (!(pc->flags2 & LIVE_CACHE_FROZEN))
+					clear_live_cache();
+                        }
+
+			if (runtime)
+				fprintf(fp, "   live_cache: %s\n",
+					pc->flags2 & LIVE_CACHE_OFF ? "off" :
+					pc->flags2 & LIVE_CACHE_FROZEN ? 
+					"frozen" : "on");
+
+			return;
+
+                } else if (STREQ(args[optind], "vmlinux_text")) {
+
+                        if (args[optind+1]) {
+                                optind++;
+				if (!runtime)
+					defer();
+                                else if (STREQ(args[optind], "off"))
+                                        pc->flags2 &= 
+					    ~(VMLINUX_TEXT|VMLINUX_TEXT_VERIFY);
+                                else if (STREQ(args[optind], "on") ||
+				    STREQ(args[optind], "verify")) {
+					if (!vmlinux_text_init())
+						return;
+					pc->flags2 |= VMLINUX_TEXT;
+					if (STREQ(args[optind], "verify")) {
+						pc->flags2 |= VMLINUX_TEXT_VERIFY;
+						if (runtime)
+							vmlinux_text_verify();
+					} else
+						pc->flags2 &= ~VMLINUX_TEXT_VERIFY;
+				} else
+                                        goto invalid_set_command;
+                        }
+
+			if (runtime)
+				fprintf(fp, " vmlinux_text: %s\n",
+					!(pc->flags2 & VMLINUX_TEXT) ? "off" :
+					pc->flags2 & VMLINUX_TEXT_VERIFY ? 
+					"verify" : "on");
+
+			return;
+
 		} else if (XEN_HYPER_MODE()) {
 			error(FATAL, "invalid argument for the Xen hypervisor\n");
 		} else if (pc->flags & MINIMAL_MODE) {
@@ -2488,6 +2551,10 @@ show_options(void)
 	else
 		fprintf(fp, "(not set)\n");
 	fprintf(fp, "       offline: %s\n", pc->flags2 & OFFLINE_HIDE ? "hide" : "show");
+	fprintf(fp, "    live_cache: %s\n", pc->flags2 & LIVE_CACHE_OFF ? "off" :
+		pc->flags2 & LIVE_CACHE_FROZEN ? "frozen" : "on");
+	fprintf(fp, "  vmlinux_text: %s\n", !(pc->flags2 & VMLINUX_TEXT) ? "off" :
+		pc->flags2 & VMLINUX_TEXT_VERIFY ? "verify" : "on");
 }
 
 
@@ -3185,9 +3252,17 @@ cmd_list(void)
 	ld = &list_data;
 	BZERO(ld, sizeof(struct list_data));
 
-        while ((c = getopt(argcnt, args, "Hhrs:e:o:xd")) != EOF) {
+        while ((c = getopt(argcnt, args, "BHhrs:S:e:o:xdc")) != EOF) {
                 switch(c)
 		{
+		case 'B':
+			ld->flags |= LIST_BRENT_ALGO;
+			break;
+
+		case 'c':
+			ld->flags |= LIST_COUNT_ONLY;
+			break;
+
 		case 'H':
 			ld->flags |= LIST_HEAD_FORMAT;
 			ld->flags |= LIST_HEAD_POINTER;
@@ -3201,6 +3276,9 @@ cmd_list(void)
 			ld->flags |= LIST_HEAD_REVERSE;
 			break;
 
+		case 'S':
+			ld->flags |= LIST_READ_MEMBER;
+			/* FALLTHROUGH */
 		case 's':
 			if (ld->structname_args++ == 0) 
 				hq_open();
@@ -3252,6 +3330,9 @@ cmd_list(void)
 	if (argerrs)
 		cmd_usage(pc->curcmd, SYNOPSIS);
 
+	if ((ld->flags & LIST_COUNT_ONLY) && ld->structname_args)
+		error(FATAL, "-c cannot be used with -s or -S\n");
+
 	if (args[optind] && args[optind+1] && args[optind+2]) {
 		error(INFO, "too many arguments\n");
 		cmd_usage(pc->curcmd, SYNOPSIS);
@@ -3408,11 +3489,17 @@ next_arg:
 	}
 
 	ld->flags &= ~(LIST_OFFSET_ENTERED|LIST_START_ENTERED);
-	ld->flags |= VERBOSE;
+	if (!(ld->flags & LIST_COUNT_ONLY))
+		ld->flags |= VERBOSE;
 
-	hq_open();
+	if (!(ld->flags & LIST_BRENT_ALGO))
+		hq_open();
 	c = do_list(ld);
-	hq_close();
+	if (!(ld->flags & LIST_BRENT_ALGO))
+		hq_close();
+
+	if ((ld->flags & LIST_COUNT_ONLY) && (c >= 0))
+		fprintf(fp, "%d\n", c);
 
         if (ld->structname_args)
 		FREEBUF(ld->structname);
@@ -3428,8 +3515,10 @@ do_list(struct list_data *ld)
 {
 	ulong next, last, first;
 	ulong searchfor, readflag;
+	ulong tortoise, power, lam;
 	int i, count, others, close_hq_on_return;
 	unsigned int radix;
+	struct req_list *req;
 
 	if (CRASHDEBUG(1)) {
 		others = 0;
@@ -3460,6 +3549,12 @@ do_list(struct list_data *ld)
 			console("%sLIST_CALLBACK", others++ ? "|" : "");
 		if (ld->flags & CALLBACK_RETURN)
 			console("%sCALLBACK_RETURN", others++ ? "|" : "");
+		if (ld->flags & LIST_READ_MEMBER)
+			console("%sLIST_READ_MEMBER", others++ ? "|" : "");
+		if (ld->flags & LIST_BRENT_ALGO)
+			console("%sLIST_BRENT_ALGO", others++ ? "|" : "");
+		if (ld->flags & LIST_COUNT_ONLY)
+			console("%sLIST_COUNT_ONLY", others++ ? "|" : "");
 		console(")\n");
 		console("           start: %lx\n", ld->start);
 		console("   member_offset: %ld\n", ld->member_offset);
@@ -3488,6 +3583,16 @@ do_list(struct list_data *ld)
 		radix = 0;
 	next = ld->start;
 
+	/*
+	 *  Brent's cycle detection requires no hash queue, but the 
+	 *  LIST_ALLOCATE list is gathered from it.
+	 */
+	if (ld->flags & LIST_ALLOCATE)
+		ld->flags &= ~LIST_BRENT_ALGO;
+	tortoise = 0;
+	power = 1;
+	lam = 0;
+
 	close_hq_on_return = FALSE;
 	if (ld->flags & LIST_ALLOCATE) {
 		if (!hq_is_open()) {
@@ -3514,11 +3619,29 @@ do_list(struct list_data *ld)
 	if (ld->header)
 		fprintf(fp, "%s", ld->header);
 
+	if ((ld->flags & (VERBOSE|LIST_READ_MEMBER)) == 
+	    (VERBOSE|LIST_READ_MEMBER))
+		req = compile_struct_requests(ld->structname, 
+			ld->structname_args);
+	else
+		req = NULL;
+
 	while (1) {
 		if (ld->flags & VERBOSE) {
 			fprintf(fp, "%lx\n", next - ld->list_head_offset);
 
-			if (ld->structname) {
+			if (req) {
+				if (!dump_struct_requests(req, 
+				    next - ld->list_head_offset, radix, 
+				    readflag)) {
+					error(INFO, "\ninvalid list entry: %lx\n",
+						next);
+					free_struct_requests(req);
+					if (close_hq_on_return)
+						hq_close();
+					return -1;
+				}
+			} else if (ld->structname) {
 				for (i = 0; i < ld->structname_args; i++) {
 					switch (count_chars(ld->structname[i], '.'))
 					{
@@ -3534,11 +3657,34 @@ do_list(struct list_data *ld)
 			}
 		}
 
-                if (next && !hq_enter(next - ld->list_head_offset)) {
+		if (ld->flags & LIST_BRENT_ALGO) {
+			/*
+			 *  Brent's algorithm: the tortoise is teleported to 
+			 *  the hare at every power of two, so a loop is 
+			 *  found within a few laps without hashing any entry.
+			 */
+			if (next && (next == tortoise)) {
+				if (ld->flags & 
+			    	    (RETURN_ON_DUPLICATE|RETURN_ON_LIST_ERROR)) {
+					error(INFO, 
+					    "\nduplicate list entry: %lx\n", next);
+					free_struct_requests(req);
+					return -1;
+				}
+				error(FATAL, "\nduplicate list entry: %lx\n", 
+					next);
+			}
+			if (++lam == power) {
+				tortoise = next;
+				power <<= 1;
+				lam = 0;
+			}
+		} else if (next && !hq_enter(next - ld->list_head_offset)) {
 			if (ld->flags & 
 			    (RETURN_ON_DUPLICATE|RETURN_ON_LIST_ERROR)) {
                         	error(INFO, "\nduplicate list entry: %lx\n", 
 					next);
+				free_struct_requests(req);
 				if (close_hq_on_return)
 					hq_close();
 				return -1;
@@ -3561,6 +3707,7 @@ do_list(struct list_data *ld)
                 if (!readmem(next + ld->member_offset, KVADDR, &next, 
 		    sizeof(void *), "list entry", readflag)) {
 			error(INFO, "\ninvalid list entry: %lx\n", next);
+			free_struct_requests(req);
 			if (close_hq_on_return)
 				hq_close();
 			return -1;
@@ -3601,6 +3748,8 @@ do_list(struct list_data *ld)
 		}
 	}
 
+	free_struct_requests(req);
+
 	if (CRASHDEBUG(1))
 		console("do_list count: %d\n", count);
 
@@ -3658,6 +3807,202 @@ dump_struct_members(struct list_data *ld, int idx, ulong next)
 	FREEBUF(members);
 }
 
+/*
+ *  The "-S struct[.member[,member]]" option of the list and tree commands
+ *  is compiled once into a req_list: the structure size, and the offset,
+ *  size and type of each requested member are looked up in advance, so
+ *  that each entry requires a single readmem() of the whole structure,
+ *  and its integer and pointer members are displayed directly from the
+ *  buffer without any further gdb interaction, with signed integers
+ *  sign-extended.  Members that are bitfields, arrays, embedded structures
+ *  or other non-scalar types, or are expressed as "member.member" or
+ *  "member[index]", are still handed off to gdb.
+ */
+struct req_entry {
+	char *name;
+	char *members;
+	long size;
+	int count;
+	char *member[MAXARGS];
+	long offset[MAXARGS];
+	long width[MAXARGS];
+	int is_ptr[MAXARGS];
+	int is_signed[MAXARGS];
+};
+
+struct req_list {
+	int count;
+	long bufsize;
+	char *buf;
+	struct req_entry *entry;
+};
+
+static struct req_list *
+compile_struct_requests(char **structname, int args)
+{
+	int i, j;
+	long offset, width, type;
+	char *p;
+	struct req_list *req;
+	struct req_entry *e;
+	struct struct_member_data smd;
+
+	req = (struct req_list *)GETBUF(sizeof(struct req_list));
+	req->entry = (struct req_entry *)GETBUF(sizeof(struct req_entry) * args);
+	req->count = args;
+
+	for (i = 0; i < args; i++) {
+		e = &req->entry[i];
+		e->name = GETBUF(strlen(structname[i])+1);
+		strcpy(e->name, structname[i]);
+		if ((p = strstr(e->name, ".")))
+			*p++ = NULLCHAR;
+
+		if ((e->size = STRUCT_SIZE(e->name)) <= 0)
+			error(FATAL, "invalid data structure reference: %s\n",
+				e->name);
+		if (e->size > req->bufsize)
+			req->bufsize = e->size;
+
+		if (!p)
+			continue;
+
+		e->members = GETBUF(strlen(p)+1);
+		strcpy(e->members, p);
+		replace_string(e->members, ",", ' ');
+		e->count = parse_line(e->members, e->member);
+
+		for (j = 0; j < e->count; j++) {
+			e->offset[j] = -1;
+			if (strpbrk(e->member[j], ".[")) 
+				continue;
+
+			if ((offset = MEMBER_OFFSET(e->name, e->member[j])) < 0)
+				offset = ANON_MEMBER_OFFSET(e->name, e->member[j]);
+			if (offset < 0)
+				error(FATAL, "invalid data structure reference: "
+					"%s.%s\n", e->name, e->member[j]);
+
+			width = MEMBER_SIZE(e->name, e->member[j]);
+			type = MEMBER_TYPE(e->name, e->member[j]);
+			switch (type)
+			{
+			case TYPE_CODE_INT:
+				BZERO(&smd, sizeof(struct struct_member_data));
+				smd.structure = e->name;
+				smd.member = e->member[j];
+				if (!fill_struct_member_data(&smd) || smd.bitsize)
+					break;
+				e->is_signed[j] = !smd.unsigned_type;
+				/* FALLTHROUGH */
+			case TYPE_CODE_PTR:
+				switch (width)
+				{
+				case SIZEOF_8BIT:
+				case SIZEOF_16BIT:
+				case SIZEOF_32BIT:
+				case SIZEOF_64BIT:
+					e->offset[j] = offset;
+					e->width[j] = width;
+					e->is_ptr[j] = (type == TYPE_CODE_PTR);
+					break;
+				}
+				break;
+			}
+		}
+	}
+
+	req->buf = GETBUF(req->bufsize);
+
+	return req;
+}
+
+static void
+free_struct_requests(struct req_list *req)
+{
+	int i;
+
+	if (!req)
+		return;
+
+	for (i = 0; i < req->count; i++) {
+		FREEBUF(req->entry[i].name);
+		if (req->entry[i].members)
+			FREEBUF(req->entry[i].members);
+	}
+	FREEBUF(req->buf);
+	FREEBUF(req->entry);
+	FREEBUF(req);
+}
+
+/*
+ *  Display the compiled structure requests for the structure at addr.  
+ *  Returns FALSE if the structure could not be read.
+ */
+static int
+dump_struct_requests(struct req_list *req, ulong addr, unsigned int radix, 
+		     ulong readflag)
+{
+	int i, j;
+	ulonglong value;
+	long long svalue;
+	struct req_entry *e;
+	char *p, *structname;
+
+	for (i = 0; i < req->count; i++) {
+		e = &req->entry[i];
+
+		if (!e->count) {
+			dump_struct(e->name, addr, radix);
+			continue;
+		}
+
+		if (!readmem(addr, KVADDR, req->buf, e->size, e->name, readflag))
+			return FALSE;
+
+		for (j = 0; j < e->count; j++) {
+			if (e->offset[j] < 0) {
+				structname = GETBUF(strlen(e->name) + 
+					strlen(e->member[j]) + 2);
+				sprintf(structname, "%s.%s", e->name, e->member[j]);
+				dump_struct_member(structname, addr, radix);
+				FREEBUF(structname);
+				continue;
+			}
+
+			p = req->buf + e->offset[j];
+			switch (e->width[j])
+			{
+			case SIZEOF_8BIT:
+				value = UCHAR(p);
+				svalue = (signed char)UCHAR(p);
+				break;
+			case SIZEOF_16BIT:
+				value = USHORT(p);
+				svalue = (short)USHORT(p);
+				break;
+			case SIZEOF_32BIT:
+				value = UINT(p);
+				svalue = (int)UINT(p);
+				break;
+			default:
+				value = ULONGLONG(p);
+				svalue = (long long)ULONGLONG(p);
+				break;
+			}
+
+			if (e->is_ptr[j] || (radix == 16))
+				fprintf(fp, "  %s = 0x%llx\n", e->member[j], value);
+			else if (e->is_signed[j])
+				fprintf(fp, "  %s = %lld\n", e->member[j], svalue);
+			else
+				fprintf(fp, "  %s = %llu\n", e->member[j], value);
+		}
+	}
+
+	return TRUE;
+}
+
 #define RADIXTREE_REQUEST (0x1)
 #define RBTREE_REQUEST    (0x2)
 
@@ -3677,7 +4022,7 @@ cmd_tree()
 	td = &tree_data;
 	BZERO(td, sizeof(struct tree_data));
 
-	while ((c = getopt(argcnt, args, "xdt:r:o:s:pN")) != EOF) {
+	while ((c = getopt(argcnt, args, "xdt:r:o:s:S:pNc")) != EOF) {
 		switch (c)
 		{
 		case 't':
@@ -3730,12 +4075,19 @@ cmd_tree()
 			td->flags |= TREE_NODE_OFFSET_ENTERED; 
 			break;
 
+		case 'S':
+			td->flags |= TREE_READ_MEMBER;
+			/* FALLTHROUGH */
 		case 's':
 			if (td->structname_args++ == 0) 
 				hq_open();
 			hq_enter((ulong)optarg);
 			break;
 
+		case 'c':
+			td->flags |= TREE_COUNT_ONLY;
+			break;
+
 		case 'p':
 			td->flags |= TREE_POSITION_DISPLAY;
 			break;
@@ -3773,6 +4125,10 @@ cmd_tree()
 	    (td->flags & TREE_NODE_POINTER))
 		error(INFO, "-r and -N options are mutually exclusive\n");
 
+	if ((td->flags & TREE_COUNT_ONLY) && 
+	    (td->structname_args || (td->flags & TREE_POSITION_DISPLAY)))
+		error(FATAL, "-c cannot be used with -s, -S or -p\n");
+
 	if (!args[optind]) {
 		error(INFO, "a starting address is required\n");
 		cmd_usage(pc->curcmd, SYNOPSIS);
@@ -3841,6 +4197,12 @@ next_arg:
 		if (td->flags & TREE_STRUCT_RADIX_16)
 			fprintf(fp, "%sTREE_STRUCT_RADIX_16",
 				others++ ? "|" : "");
+		if (td->flags & TREE_READ_MEMBER)
+			fprintf(fp, "%sTREE_READ_MEMBER",
+				others++ ? "|" : "");
+		if (td->flags & TREE_COUNT_ONLY)
+			fprintf(fp, "%sTREE_COUNT_ONLY",
+				others++ ? "|" : "");
 		fprintf(fp, ")\n");
 		fprintf(fp, "              type: %s\n",
 			type_flag & RADIXTREE_REQUEST ? "radix" : "red-black");
@@ -3853,7 +4215,8 @@ next_arg:
 	}
 
 	td->flags &= ~TREE_NODE_OFFSET_ENTERED;
-	td->flags |= VERBOSE;
+	if (!(td->flags & TREE_COUNT_ONLY))
+		td->flags |= VERBOSE;
 
 	hq_open();
 	if (type_flag & RADIXTREE_REQUEST)
@@ -3862,6 +4225,9 @@ next_arg:
 		do_rbtree(td);
 	hq_close();
 
+	if (td->flags & TREE_COUNT_ONLY)
+		fprintf(fp, "%d\n", td->count);
+
         if (td->structname_args)
 		FREEBUF(td->structname);
 }
@@ -3877,6 +4243,7 @@ do_rdtree(struct tree_data *td)
 	ulong node_p;
 	uint print_radix, height;
 	char pos[BUFSIZE];
+	struct req_list *req;
 
 	if (!VALID_STRUCT(radix_tree_root) || !VALID_STRUCT(radix_tree_node) ||
 	    !VALID_MEMBER(radix_tree_root_height) ||
@@ -3945,15 +4312,22 @@ do_rdtree(struct tree_data *td)
 
 	sprintf(pos, "root");
 
-	rdtree_iteration(node_p, td, pos, -1, height);
+	req = (td->flags & TREE_READ_MEMBER) ? 
+		compile_struct_requests(td->structname, td->structname_args) :
+		NULL;
+
+	rdtree_iteration(node_p, td, pos, -1, height, req);
+
+	free_struct_requests(req);
 
 	return td->count;
 }
 
 void 
-rdtree_iteration(ulong node_p, struct tree_data *td, char *ppos, ulong indexnum, uint height)
+rdtree_iteration(ulong node_p, struct tree_data *td, char *ppos, ulong indexnum, uint height,
+		 struct req_list *req)
 {
-	ulong slot;
+	ulong slot, *slots;
 	int i, index;
 	uint print_radix;
 	char pos[BUFSIZE];
@@ -3963,11 +4337,13 @@ rdtree_iteration(ulong node_p, struct tree_data *td, char *ppos, ulong indexnum,
 	else
 		sprintf(pos, "%s", ppos);
 
+	slots = (ulong *)GETBUF(sizeof(void *) * RADIX_TREE_MAP_SIZE);
+	readmem((ulong)node_p + OFFSET(radix_tree_node_slots), KVADDR, 
+		slots, sizeof(void *) * RADIX_TREE_MAP_SIZE,
+		"radix_tree_node.slots array", FAULT_ON_ERROR);
+
 	for (index = 0; index < RADIX_TREE_MAP_SIZE; index++) {
-		readmem((ulong)node_p + OFFSET(radix_tree_node_slots) +
-			sizeof(void *) * index, KVADDR, &slot, sizeof(void *),
-			"radix_tree_node.slot[index]", FAULT_ON_ERROR);
-		if (!slot)
+		if (!(slot = slots[index]))
 			continue;
 		if (height == 1) {
 			if (hq_enter(slot))
@@ -3989,6 +4365,12 @@ rdtree_iteration(ulong node_p, struct tree_data *td, char *ppos, ulong indexnum,
 				else
 					print_radix = 0;
 
+				if (req) {
+					dump_struct_requests(req, slot, 
+						print_radix, FAULT_ON_ERROR);
+					continue;
+				}
+
 				for (i = 0; i < td->structname_args; i++) {
 					switch(count_chars(td->structname[i], '.'))
 					{
@@ -4004,8 +4386,10 @@ rdtree_iteration(ulong node_p, struct tree_data *td, char *ppos, ulong indexnum,
 				}
 			}
 		} else 
-			rdtree_iteration(slot, td, pos, index, height-1);
+			rdtree_iteration(slot, td, pos, index, height-1, req);
 	}
+
+	FREEBUF(slots);
 }
 
 int
@@ -4013,6 +4397,7 @@ do_rbtree(struct tree_data *td)
 {
 	ulong start;
 	char pos[BUFSIZE];
+	struct req_list *req;
 
 	if (!VALID_MEMBER(rb_root_rb_node) || !VALID_MEMBER(rb_node_rb_left) ||
 	    !VALID_MEMBER(rb_node_rb_right))
@@ -4027,17 +4412,26 @@ do_rbtree(struct tree_data *td)
 		readmem(td->start + OFFSET(rb_root_rb_node), KVADDR,
 			&start, sizeof(void *), "rb_root rb_node", FAULT_ON_ERROR);
 
-	rbtree_iteration(start, td, pos);
+	req = (td->flags & TREE_READ_MEMBER) ? 
+		compile_struct_requests(td->structname, td->structname_args) :
+		NULL;
+
+	rbtree_iteration(start, td, pos, req);
+
+	free_struct_requests(req);
 
 	return td->count;
 }
 
 void
-rbtree_iteration(ulong node_p, struct tree_data *td, char *pos)
+rbtree_iteration(ulong node_p, struct tree_data *td, char *pos, 
+		 struct req_list *req)
 {
 	int i;
 	uint print_radix;
 	ulong struct_p, left_p, right_p;
+	ulong link[2];
+	long link_offset;
 	char left_pos[BUFSIZE], right_pos[BUFSIZE];
 
 	if (!node_p)
@@ -4064,7 +4458,10 @@ rbtree_iteration(ulong node_p, struct tree_data *td, char *pos)
 		else
 			print_radix = 0;
 
-		for (i = 0; i < td->structname_args; i++) {
+		if (req)
+			dump_struct_requests(req, struct_p, print_radix, 
+				FAULT_ON_ERROR);
+		else for (i = 0; i < td->structname_args; i++) {
 			switch(count_chars(td->structname[i], '.'))
 			{
 			case 0:
@@ -4077,16 +4474,29 @@ rbtree_iteration(ulong node_p, struct tree_data *td, char *pos)
 		}
 	}
 
-	readmem(node_p+OFFSET(rb_node_rb_left), KVADDR, &left_p,
-		sizeof(void *), "rb_node rb_left", FAULT_ON_ERROR);
-	readmem(node_p+OFFSET(rb_node_rb_right), KVADDR, &right_p,
-		sizeof(void *), "rb_node rb_right", FAULT_ON_ERROR);
+	/*
+	 *  The rb_right and rb_left pointers are adjacent in every 
+	 *  rb_node layout, so fetch both of them with one read.
+	 */
+	link_offset = MIN(OFFSET(rb_node_rb_left), OFFSET(rb_node_rb_right));
+	if ((MAX(OFFSET(rb_node_rb_left), OFFSET(rb_node_rb_right)) -
+	    link_offset) == sizeof(void *)) {
+		readmem(node_p+link_offset, KVADDR, link, sizeof(link),
+			"rb_node rb_left/rb_right", FAULT_ON_ERROR);
+		left_p = link[(OFFSET(rb_node_rb_left) - link_offset) ? 1 : 0];
+		right_p = link[(OFFSET(rb_node_rb_right) - link_offset) ? 1 : 0];
+	} else {
+		readmem(node_p+OFFSET(rb_node_rb_left), KVADDR, &left_p,
+			sizeof(void *), "rb_node rb_left", FAULT_ON_ERROR);
+		readmem(node_p+OFFSET(rb_node_rb_right), KVADDR, &right_p,
+			sizeof(void *), "rb_node rb_right", FAULT_ON_ERROR);
+	}
 
 	sprintf(left_pos, "%s/l", pos);
 	sprintf(right_pos, "%s/r", pos);
 
-	rbtree_iteration(left_p, td, left_pos);
-	rbtree_iteration(right_p, td, right_pos);		
+	rbtree_iteration(left_p, td, left_pos, req);
+	rbtree_iteration(right_p, td, right_pos, req);		
 }
 
 void
@@ -4212,19 +4622,23 @@ hq_init(void)
 
 /*
  *  Get a free hash queue entry.  If there's no more available, realloc()
- *  a new chunk of memory with another HQ_ENTRY_CHUNK entries stuck on the end.
+ *  a new chunk of memory on the end.  The chunk size doubles with the
+ *  table so that hashing very long lists does not degenerate into 
+ *  copying the table every HQ_ENTRY_CHUNK entries.
  */
 static long
 alloc_hq_entry(void)
 {
 	struct hash_table *ht;
 	struct hq_entry *new, *end_of_old;
+	long chunk;
 
 	ht = &hash_table;
 
 	if (++ht->index == ht->count) {
+		chunk = MAX(ht->count, HQ_ENTRY_CHUNK);
                 if (!(new = (void *)realloc((void *)ht->memptr,
-		    (ht->count+HQ_ENTRY_CHUNK) * sizeof(struct hq_entry)))) {
+		    (ht->count+chunk) * sizeof(struct hq_entry)))) {
 			error(INFO, 
 			    "cannot realloc memory for hash queues: %s\n",
 				strerror(errno));
@@ -4234,8 +4648,8 @@ alloc_hq_entry(void)
 		ht->reallocs++;
 		ht->memptr = new;
 		end_of_old = ht->memptr + ht->count;
-		BZERO(end_of_old, HQ_ENTRY_CHUNK * sizeof(struct hq_entry));
-		ht->count += HQ_ENTRY_CHUNK;
+		BZERO(end_of_old, chunk * sizeof(struct hq_entry));
+		ht->count += chunk;
 	}
 
 	return(ht->index);
@@ -4277,7 +4691,10 @@ hq_open(void)
 
 	ht->flags &= ~(HASH_QUEUE_FULL|HASH_QUEUE_CLOSED);
 	BZERO(ht->queue_heads, sizeof(struct hq_head) * pc->nr_hash_queues);
-	BZERO(ht->memptr, ht->count * sizeof(struct hq_entry));
+	/*
+	 *  Only the entries used by the previous session need clearing.
+	 */
+	BZERO(ht->memptr, MIN(ht->index+1, ht->count) * sizeof(struct hq_entry));
 	ht->index = 0;
 
 	ht->flags |= HASH_QUEUE_OPEN;
@@ -4901,6 +5318,9 @@ dump_shared_bufs(void)
 	fprintf(fp, "         frees: %ld\n", bp->frees);
 	fprintf(fp, "    reqs/total: %ld/%.0f\n", bp->reqs, bp->total);
 	fprintf(fp, "  average size: %.0f\n", bp->total/bp->reqs);
+
+	fprintf(fp, "\n");
+	dump_arena();
 }
 
 /*
@@ -5083,6 +5503,231 @@ strdupbuf(char *oldstring)
 	return newstring;
 }
 
+/*
+ *  Per-command bump allocator.  Unlike GETBUF(), an ARENA_ALLOC() request
+ *  is simply carved from the current chunk, is only zeroed if ARENA_ZERO
+ *  is requested, and cannot be freed individually.  Instead, callers that
+ *  allocate per-object buffers in a loop bracket them with a scope:
+ *
+ *      struct arena_scope scope;
+ *
+ *      arena_scope_begin(&scope);
+ *      buf = ARENA_ALLOC(size);
+ *      ...
+ *      arena_scope_end(&scope);
+ *
+ *  which rewinds the arena back to where it was when the scope began.
+ *  Scopes must be ended in the reverse order that they were begun.
+ *  Anything left over is released in bulk by arena_reset(), which is
+ *  called by restore_sanity() at the end of each command, so a command
+ *  that bails out with error(FATAL) does not leak.  Released chunks are
+ *  kept on a free list for use by subsequent commands.
+ */
+
+#define ARENA_CHUNK_SIZE  (KILOBYTES(64))
+#define ARENA_FREE_MAX    (64)
+#define ARENA_ALIGN(X)    roundup((X), sizeof(long long))
+
+struct arena_chunk {
+	struct arena_chunk *next;
+	ulong size;
+	ulong used;
+	long long data[0];
+};
+
+static struct arena {
+	struct arena_chunk *current;
+	struct arena_chunk *freelist;
+	ulong free_chunks;
+	ulong chunks;
+	ulong allocs;
+	ulong zallocs;
+	ulong scopes;
+	ulong resets;
+	ulong mallocs;
+	ulong frees;
+	ulong inuse;
+	ulong highwater;
+	double total;
+} arena = { 0 };
+
+static struct arena_chunk *
+arena_get_chunk(ulong size)
+{
+	struct arena_chunk *ac, **acp;
+	struct arena *ap;
+
+	ap = &arena;
+
+	for (acp = &ap->freelist; (ac = *acp); acp = &ac->next) {
+		if (ac->size >= size) {
+			*acp = ac->next;
+			ap->free_chunks--;
+			break;
+		}
+	}
+
+	if (!ac) {
+		size = MAX(size, ARENA_CHUNK_SIZE);
+		if (!(ac = (struct arena_chunk *)
+		    malloc(sizeof(struct arena_chunk) + size)))
+			error(FATAL, "cannot allocate any more memory!\n");
+		ac->size = size;
+		ap->mallocs++;
+	}
+
+	ac->used = 0;
+	ac->next = ap->current;
+	ap->current = ac;
+	ap->chunks++;
+
+	return ac;
+}
+
+/*
+ *  Return a chunk to the free list, or free it if it is oversized or
+ *  the free list is already long enough.
+ */
+static void
+arena_put_chunk(struct arena_chunk *ac)
+{
+	struct arena *ap;
+
+	ap = &arena;
+	ap->chunks--;
+	ap->inuse -= ac->used;
+
+	if ((ac->size > ARENA_CHUNK_SIZE) || (ap->free_chunks >= ARENA_FREE_MAX)) {
+		free(ac);
+		ap->frees++;
+		return;
+	}
+
+	ac->next = ap->freelist;
+	ap->freelist = ac;
+	ap->free_chunks++;
+}
+
+void *
+arena_alloc(long reqsize, ulong flags)
+{
+	struct arena_chunk *ac;
+	struct arena *ap;
+	ulong size;
+	char *p;
+
+	if (reqsize <= 0) {
+		ulong retaddr = (ulong)__builtin_return_address(0);
+		error(FATAL, "invalid arena allocation size: %ld (called from %lx)\n",
+			reqsize, retaddr);
+	}
+
+	ap = &arena;
+	size = ARENA_ALIGN(reqsize);
+
+	if (!(ac = ap->current) || ((ac->size - ac->used) < size))
+		ac = arena_get_chunk(size);
+
+	p = (char *)ac->data + ac->used;
+	ac->used += size;
+
+	ap->allocs++;
+	ap->total += reqsize;
+	ap->inuse += size;
+	if (ap->inuse > ap->highwater)
+		ap->highwater = ap->inuse;
+
+	if (flags & ARENA_ZERO) {
+		BZERO(p, reqsize);
+		ap->zallocs++;
+	}
+
+	return p;
+}
+
+void
+arena_scope_begin(struct arena_scope *scope)
+{
+	struct arena *ap;
+
+	ap = &arena;
+	scope->chunk = ap->current;
+	scope->used = ap->current ? ap->current->used : 0;
+	scope->resets = ap->resets;
+	ap->scopes++;
+}
+
+/*
+ *  Rewind the arena to the mark taken by arena_scope_begin().  The
+ *  scope may be ended more than once, i.e., once per loop iteration.
+ */
+void
+arena_scope_end(struct arena_scope *scope)
+{
+	struct arena_chunk *ac;
+	struct arena *ap;
+
+	ap = &arena;
+	if (scope->resets != ap->resets)
+		return;
+
+	while ((ac = ap->current) && (ac != scope->chunk)) {
+		ap->current = ac->next;
+		arena_put_chunk(ac);
+	}
+
+	if ((ac = ap->current) && (ac->used > scope->used)) {
+		ap->inuse -= ac->used - scope->used;
+		ac->used = scope->used;
+	}
+}
+
+/*
+ *  Release everything allocated by the last command.
+ */
+void
+arena_reset(void)
+{
+	struct arena_chunk *ac;
+	struct arena *ap;
+
+	ap = &arena;
+	while ((ac = ap->current)) {
+		ap->current = ac->next;
+		arena_put_chunk(ac);
+	}
+	ap->inuse = 0;
+	ap->resets++;
+}
+
+/*
+ *  "help -b" output
+ */
+void
+dump_arena(void)
+{
+	struct arena_chunk *ac;
+	struct arena *ap;
+	ulong bytes;
+
+	ap = &arena;
+
+	for (ac = ap->current, bytes = 0; ac; ac = ac->next)
+		bytes += ac->size;
+
+	fprintf(fp, "         arena: chunks: %ld (%ld bytes)  free: %ld\n", 
+		ap->chunks, bytes, ap->free_chunks);
+	fprintf(fp, "         inuse: %ld\n", ap->inuse);
+	fprintf(fp, "     highwater: %ld\n", ap->highwater);
+	fprintf(fp, " allocs/zalloc: %ld/%ld\n", ap->allocs, ap->zallocs);
+	fprintf(fp, "        scopes: %ld\n", ap->scopes);
+	fprintf(fp, "        resets: %ld\n", ap->resets);
+	fprintf(fp, "       mallocs: %ld\n", ap->mallocs);
+	fprintf(fp, "         frees: %ld\n", ap->frees);
+	fprintf(fp, "  average size: %.0f\n", 
+		ap->allocs ? ap->total/ap->allocs : 0.0);
+}
+
 /*
  *  Return the number of bits set in an int or long.
  */
@@ -27,6 +27,8 @@
 
 static vmssdata vmss = { 0 };
 
+static void vmware_vmss_map_memory(void);
+
 int
 is_vmware_vmss(char *filename)
 {
@@ -293,6 +295,7 @@ vmware_vmss_init(char *filename, FILE *ofp)
 	}
 
 	vmss.dfp = fp;
+	vmware_vmss_map_memory();
 
 exit:
 	if (grps)
@@ -304,6 +307,48 @@ exit:
 	return result;
 }
 
+/*
+ * The memory image is a linear copy of guest physical memory with the
+ * holes between regions squeezed out.  Precompute the hole adjustment
+ * of each region, and map the image so that reads are a memcpy; if the
+ * image cannot be mapped, it is read with fseek/fread.
+ */
+static void
+vmware_vmss_map_memory(void)
+{
+	uint64_t holes, offset, pgoff;
+	void *map;
+	int i;
+
+	for (i = 0, holes = 0; i < vmss.regionscount; i++) {
+		holes += (uint64_t)(vmss.regions[i].startppn -
+			vmss.regions[i].startpagenum) << VMW_PAGE_SHIFT;
+		vmss.ranges[i].paddr = (uint64_t)vmss.regions[i].startppn << 
+			VMW_PAGE_SHIFT;
+		vmss.ranges[i].holes = holes;
+	}
+
+	offset = vmss.memoffset;
+	pgoff = offset & ~((uint64_t)getpagesize() - 1);
+	if (!vmss.memsize || 
+	    ((offset - pgoff + vmss.memsize) != (size_t)(offset - pgoff + vmss.memsize)))
+		return;
+
+	vmss.maplen = (size_t)(offset - pgoff + vmss.memsize);
+	if ((map = mmap(NULL, vmss.maplen, PROT_READ, MAP_PRIVATE, 
+	    fileno(vmss.dfp), (off_t)pgoff)) == MAP_FAILED) {
+		DEBUG_PARSE_PRINT((fp, LOGPRX"Cannot mmap memory image: %s\n",
+				   strerror(errno)));
+		vmss.maplen = 0;
+		return;
+	}
+
+	vmss.memmap = map;
+	vmss.memimage = vmss.memmap + (offset - pgoff);
+	DEBUG_PARSE_PRINT((fp, LOGPRX"Memory image mapped at %lx length %#llx\n",
+			   (ulong)vmss.memimage, (ulonglong)vmss.memsize));
+}
+
 uint vmware_vmss_page_size(void)
 {
 	return VMW_PAGE_SIZE;
@@ -316,22 +361,23 @@ read_vmware_vmss(int fd, void *bufptr, int cnt, ulong addr, physaddr_t paddr)
 
 	if (vmss.regionscount > 0) {
 		/* Memory is divided into regions and there are holes between them. */
-		uint32_t ppn = (uint32_t) (pos >> VMW_PAGE_SHIFT);
 	        int i;
 
-		for (i = 0; i < vmss.regionscount; i++) {
-			if (ppn < vmss.regions[i].startppn)
+		for (i = vmss.regionscount - 1; i >= 0; i--) {
+			if (pos >= vmss.ranges[i].paddr) {
+				/* skip holes. */
+				pos -= vmss.ranges[i].holes;
 				break;
-
-			/* skip holes. */
-			pos -= ((vmss.regions[i].startppn - vmss.regions[i].startpagenum)
-				<< VMW_PAGE_SHIFT);
+			}
 		}
 	}
 
 	if (pos + cnt > vmss.memsize) {
 		error(INFO, LOGPRX"Read beyond the end of file! paddr=%#lx cnt=%d\n",
 		      paddr, cnt);
+	} else if (vmss.memimage) {
+		memcpy(bufptr, vmss.memimage + pos, cnt);
+		return cnt;
 	}
 
 	pos += vmss.memoffset;
@@ -89,6 +89,16 @@ struct memregion {
 };
 typedef struct memregion	memregion;
 
+/*
+ * Physical address to memory file offset translation: a paddr at or
+ * above paddr maps to paddr - holes within the memory image.
+ */
+struct memrange {
+	uint64_t	paddr;
+	uint64_t	holes;
+};
+typedef struct memrange	memrange;
+
 #define MAX_REGIONS	3
 struct vmssdata {
 	int32_t	cpt64bit;
@@ -99,6 +109,10 @@ struct vmssdata {
         memregion	regions[MAX_REGIONS];
 	uint64_t	memoffset;
 	uint64_t	memsize;
+	memrange	ranges[MAX_REGIONS];
+	char		*memmap;
+	size_t		maplen;
+	char		*memimage;
 };
 typedef struct vmssdata vmssdata;
 
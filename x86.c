@@ -4419,7 +4419,8 @@ x86_function_called_by(ulong eip)
         sprintf(buf, "x/i 0x%lx", eip);
 
         open_tmpfile2();
-        if (gdb_pass_through(buf, pc->tmpfile2, GNU_RETURN_ON_ERROR)) {
+        if (disasm_cache_lines(eip, 1, pc->tmpfile2) ||
+	    gdb_pass_through(buf, pc->tmpfile2, GNU_RETURN_ON_ERROR)) {
 	        rewind(pc->tmpfile2);
 	        while (fgets(buf, BUFSIZE, pc->tmpfile2)) {
 			if ((p1 = strstr(buf, "call   "))) {
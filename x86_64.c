@@ -112,6 +112,7 @@ static int x86_64_get_framesize(struct bt_info *, ulong, ulong);
 static void x86_64_framesize_debug(struct bt_info *);
 static void x86_64_get_active_set(void);
 static int x86_64_get_kvaddr_ranges(struct vaddr_range *);
+static int x86_64_uvtop_range(struct task_context *, ulong, ulong, struct uvtop_range *);
 static int x86_64_verify_paddr(uint64_t);
 static void GART_init(void);
 static void x86_64_exception_stacks_init(void);
@@ -170,6 +171,7 @@ x86_64_init(int when)
 		machdep->flags |= FRAMESIZE_DEBUG;
 		machdep->machspec->irq_eframe_link = UNINITIALIZED;
 		machdep->get_kvaddr_ranges = x86_64_get_kvaddr_ranges;
+		machdep->uvtop_range = x86_64_uvtop_range;
                 if (machdep->cmdline_args[0])
                         parse_cmdline_args();
 		break;
@@ -679,6 +681,7 @@ x86_64_dump_machdep_table(ulong arg)
         fprintf(fp, "          is_uvaddr: x86_64_is_uvaddr()\n");
         fprintf(fp, "       verify_paddr: x86_64_verify_paddr()\n");
         fprintf(fp, "  get_kvaddr_ranges: x86_64_get_kvaddr_ranges()\n");
+        fprintf(fp, "        uvtop_range: x86_64_uvtop_range()\n");
         fprintf(fp, "    init_kernel_pgd: x86_64_init_kernel_pgd()\n");
         fprintf(fp, "clear_machdep_cache: x86_64_clear_machdep_cache()\n");
 	fprintf(fp, " xendump_p2m_create: %s\n", PVOPS_XEN() ?
@@ -1455,6 +1458,105 @@ no_upage:
 	return FALSE;
 }
 
+/*
+ *  Gather the translations of the user virtual pages from uvaddr up to
+ *  the end of the page table span that contains it, limited by end, 
+ *  with one pass down the page tables.  Each page is translated in the
+ *  same manner as x86_64_uvtop_level4().
+ */
+static int
+x86_64_uvtop_range(struct task_context *tc, ulong uvaddr, ulong end, 
+	struct uvtop_range *ur)
+{
+	ulong mm;
+	ulong *pml;
+	ulong pml_paddr;
+	ulong pml_pte;
+	ulong *pgd;
+	ulong pgd_paddr;
+	ulong pgd_pte;
+	ulong *pmd;
+	ulong pmd_paddr;
+	ulong pmd_pte;
+	ulong pte_paddr;
+	ulong pte;
+	ulong vaddr, span;
+	int i;
+
+	if ((machdep->uvtop != x86_64_uvtop_level4) || IS_KVADDR(uvaddr))
+		return FALSE;
+
+	if ((mm = task_mm(tc->task, TRUE)))
+		pml = ULONG_PTR(tt->mm_struct + OFFSET(mm_struct_pgd));
+	else
+		readmem(tc->mm_struct + OFFSET(mm_struct_pgd), KVADDR, &pml,
+			sizeof(long), "mm_struct pgd", FAULT_ON_ERROR);
+
+	ur->start = uvaddr = VIRTPAGEBASE(uvaddr);
+	ur->type = UVTOP_RANGE_UNMAPPED;
+
+	pml_paddr = x86_64_VTOP((ulong)pml);
+	FILL_UPML(pml_paddr, PHYSADDR, PAGESIZE());
+	pml = ((ulong *)pml_paddr) + pml4_index(uvaddr); 
+	pml_pte = ULONG(machdep->machspec->upml + PAGEOFFSET(pml));
+	span = 1UL << PML4_SHIFT;
+	if (!(pml_pte & _PAGE_PRESENT))
+		goto done;
+
+	pgd_paddr = pml_pte & PHYSICAL_PAGE_MASK;
+	FILL_PGD(pgd_paddr, PHYSADDR, PAGESIZE());
+	pgd = ((ulong *)pgd_paddr) + pgd_index(uvaddr); 
+	pgd_pte = ULONG(machdep->pgd + PAGEOFFSET(pgd));
+	span = 1UL << PGDIR_SHIFT;
+	if (!(pgd_pte & _PAGE_PRESENT))
+		goto done;
+
+	pmd_paddr = pgd_pte & PHYSICAL_PAGE_MASK;
+	FILL_PMD(pmd_paddr, PHYSADDR, PAGESIZE());
+	pmd = ((ulong *)pmd_paddr) + pmd_index(uvaddr);
+	pmd_pte = ULONG(machdep->pmd + PAGEOFFSET(pmd));
+	span = 1UL << PMD_SHIFT;
+	if (!(pmd_pte & (_PAGE_PRESENT | _PAGE_PROTNONE)))
+		goto done;
+
+	if (pmd_pte & _PAGE_PSE) {
+		ur->type = UVTOP_RANGE_HUGE;
+		ur->base = (PAGEBASE(pmd_pte) & PHYSICAL_PAGE_MASK) + 
+			(uvaddr & ~_2MB_PAGE_MASK);
+		goto done;
+	}
+
+	/*
+	 *  The whole page table page is read by FILL_PTBL(); pick out 
+	 *  the ptes of the pages in the span.
+	 */
+	ur->type = UVTOP_RANGE_PTES;
+	pte_paddr = pmd_pte & PHYSICAL_PAGE_MASK;
+	FILL_PTBL(pte_paddr, PHYSADDR, PAGESIZE());
+
+done:
+	ur->end = (uvaddr & ~(span - 1)) + span;
+	if (end < ur->end)
+		ur->end = end;
+
+	if (ur->type == UVTOP_RANGE_PTES) {
+		for (i = 0, vaddr = uvaddr; vaddr < ur->end; 
+		     i++, vaddr += PAGESIZE()) {
+			pte = ULONG(machdep->ptbl + 
+				(pte_index(vaddr) * sizeof(ulong)));
+			if (pte & _PAGE_PRESENT) {
+				ur->paddr[i] = PAGEBASE(pte) & PHYSICAL_PAGE_MASK;
+				ur->mapped[i] = TRUE;
+			} else {
+				ur->paddr[i] = pte;
+				ur->mapped[i] = FALSE;
+			}
+		}
+	}
+
+	return TRUE;
+}
+
 static int
 x86_64_uvtop_level4_xen_wpt(struct task_context *tc, ulong uvaddr, physaddr_t *paddr, int verbose)
 {
@@ -3804,7 +3906,8 @@ x86_64_function_called_by(ulong rip)
         sprintf(buf, "x/i 0x%lx", rip);
 
         open_tmpfile2();
-	if (gdb_pass_through(buf, pc->tmpfile2, GNU_RETURN_ON_ERROR)) {
+	if (disasm_cache_lines(rip, 1, pc->tmpfile2) ||
+	    gdb_pass_through(buf, pc->tmpfile2, GNU_RETURN_ON_ERROR)) {
 	        rewind(pc->tmpfile2);
 	        while (fgets(buf, BUFSIZE, pc->tmpfile2)) {
 			if ((p1 = strstr(buf, "callq")) &&
@@ -7540,7 +7643,8 @@ x86_64_get_framesize(struct bt_info *bt, ulong textaddr, ulong rsp)
         sprintf(buf, "x/%ldi 0x%lx",
                 max_instructions, sp->value);
 
-        if (!gdb_pass_through(buf, pc->tmpfile2, GNU_RETURN_ON_ERROR)) {
+        if (!disasm_cache_lines(sp->value, max_instructions, pc->tmpfile2) &&
+	    !gdb_pass_through(buf, pc->tmpfile2, GNU_RETURN_ON_ERROR)) {
         	close_tmpfile2();
 		bt->flags |= BT_FRAMESIZE_DISABLE;
                 return 0;
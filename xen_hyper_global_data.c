@@ -91,7 +91,7 @@ struct command_table_entry xen_hyper_command_table[] = {
         {"struct",  cmd_struct,  help_struct,  0},
         {"sym",     cmd_sym,     help_sym,     0},
         {"sys",     xen_hyper_cmd_sys,      xen_hyper_help_sys,     0},
-	{"test",    cmd_test,    NULL,         HIDDEN_COMMAND},
+	{"test",    cmd_test,    help_test,    HIDDEN_COMMAND},
 	{"union",   cmd_union,   help_union,   0},
 	{"vcpu",    xen_hyper_cmd_vcpu,     xen_hyper_help_vcpu,    REFRESH_TASK_TABLE},
 	{"vcpus",   xen_hyper_cmd_vcpus,    xen_hyper_help_vcpus,   REFRESH_TASK_TABLE},